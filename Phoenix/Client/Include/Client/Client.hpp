@@ -52,6 +52,7 @@ namespace phx::client
 		void pushLayer(gfx::Layer* layer);
 		void popLayer(gfx::Layer* layer);
 		bool isDebugLayerActive() const { return m_debugOverlayActive; }
+		DebugOverlay* getDebugOverlay();
 
 		void onEvent(events::Event e) override;
 		void run();
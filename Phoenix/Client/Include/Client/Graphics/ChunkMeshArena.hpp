@@ -0,0 +1,212 @@
+// Copyright 2019-20 Genten Studios
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors
+// may be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+/**
+ * @file ChunkMeshArena.hpp
+ * @brief Shared vertex buffers that every chunk mesh is allocated from.
+ *
+ * @copyright Copyright (c) 2019-20 Genten Studios
+ */
+
+#pragma once
+
+#include <Client/Graphics/ChunkMesher.hpp>
+
+#include <Common/Math/Math.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <vector>
+
+namespace phx::gfx
+{
+	/**
+	 * @brief A range of vertices reserved in a ChunkMeshArena.
+	 */
+	struct ArenaRange
+	{
+		/// @brief The page the range is in.
+		std::size_t page = 0;
+		/// @brief The first vertex of the range in the page.
+		std::size_t first = 0;
+		/// @brief The amount of vertices reserved, 0 if nothing is.
+		std::size_t capacity = 0;
+	};
+
+	/**
+	 * @brief A mesh to draw from a ChunkMeshArena.
+	 */
+	struct ArenaDraw
+	{
+		/// @brief Where the mesh is.
+		ArenaRange range;
+		/// @brief The amount of vertices to draw.
+		std::size_t vertexCount = 0;
+		/// @brief Added to every vertex of the mesh, in model units.
+		math::vec3 offset;
+	};
+
+	/**
+	 * @brief Stores the meshes of every chunk in a few large vertex buffers.
+	 *
+	 * Each buffer (a page) is split up with a first fit free list, so
+	 * adding, changing and removing chunks doesn't create or reallocate
+	 * any GL objects. Every page is drawn through the same vertex array,
+	 * which only has its buffer swapped when moving on to the next page.
+	 *
+	 * When ARB_buffer_storage is available the pages are mapped once and
+	 * written to directly. The GPU might still be drawing from a range when
+	 * it's freed, so those are only given back once a fence placed at the
+	 * end of the frame has passed, and a mesh always moves to a new range
+	 * instead of being written over the old one. Without it, ranges are
+	 * written with glBufferSubData and a mesh that still fits stays where
+	 * it is.
+	 *
+	 * Meshes are drawn with one glMultiDrawArraysIndirect per page when
+	 * ARB_multi_draw_indirect and ARB_base_instance are available. The
+	 * offset of each mesh is then an instanced attribute picked by the
+	 * command's base instance. Otherwise every mesh is drawn on its own
+	 * with the offset set as a constant attribute.
+	 *
+	 * @paragraph Usage
+	 * @code
+	 * ChunkMeshArena arena;
+	 *
+	 * ArenaRange range;
+	 * arena.write(range, mesh);
+	 *
+	 * std::vector<ArenaDraw> draws = {{range, mesh.size(), offset}};
+	 * arena.draw(draws, true);
+	 *
+	 * arena.free(range);
+	 * arena.endFrame();
+	 * @endcode
+	 */
+	class ChunkMeshArena
+	{
+	public:
+		/// @brief The amount of vertices in a page, 16 MiB worth.
+		static constexpr std::size_t PAGE_VERTICES = 1 << 20;
+
+		/// @brief Ranges are reserved in multiples of this, so a mesh that
+		/// grows a little can usually stay where it is.
+		static constexpr std::size_t GRANULARITY = 96;
+
+		ChunkMeshArena();
+		~ChunkMeshArena();
+
+		ChunkMeshArena(const ChunkMeshArena&) = delete;
+		ChunkMeshArena& operator=(const ChunkMeshArena&) = delete;
+
+		/**
+		 * @brief Writes a mesh into the arena.
+		 * @param range The range the mesh was in, it is reused if the mesh
+		 * still fits and otherwise freed and replaced with a new one.
+		 * @param mesh The vertices to write, an empty mesh frees the range.
+		 */
+		void write(ArenaRange& range, const std::vector<Vertex>& mesh);
+
+		/**
+		 * @brief Gives a range back to the arena.
+		 * @param range The range to free, it's reset to an empty range.
+		 */
+		void free(ArenaRange& range);
+
+		/**
+		 * @brief Draws meshes from the arena.
+		 *
+		 * The offset is passed to the shader as attribute 1, the packed
+		 * vertex is attribute 0.
+		 *
+		 * @param draws The meshes to draw, they are sorted by page.
+		 * @param multiDraw Whether to use multi draw indirect when it is
+		 * supported.
+		 * @return The amount of draw calls that were made.
+		 */
+		std::size_t draw(std::vector<ArenaDraw>& draws, bool multiDraw);
+
+		bool isMultiDrawSupported() const;
+
+		/**
+		 * @brief Fences off the ranges freed this frame and gives back the
+		 * ones the GPU has finished with. Call once a frame.
+		 */
+		void endFrame();
+
+		std::size_t getPageCount() const;
+
+		/**
+		 * @brief Gets the amount of vertices that are reserved.
+		 * @return The total size of every range that isn't free.
+		 */
+		std::size_t getUsedVertices() const;
+
+	private:
+		struct Page
+		{
+			unsigned int buffer = 0;
+			std::size_t  size   = 0;
+			Vertex*      mapped = nullptr;
+
+			// free ranges by their first vertex, neighbouring ranges are
+			// always merged.
+			std::map<std::size_t, std::size_t> free;
+		};
+
+		struct Retired
+		{
+			void*                   fence = nullptr;
+			std::vector<ArenaRange> ranges;
+		};
+
+		void        bind(std::size_t page);
+		ArenaRange  allocate(std::size_t size);
+		void        release(const ArenaRange& range);
+		std::size_t addPage(std::size_t size);
+
+	private:
+		std::vector<Page> m_pages;
+
+		// ranges freed this frame, then ranges waiting on their fence.
+		std::vector<ArenaRange> m_freed;
+		std::deque<Retired>     m_retired;
+
+		bool         m_persistent = false;
+		bool         m_multiDraw  = false;
+		unsigned int m_vao        = 0;
+		std::size_t  m_boundPage  = SIZE_MAX;
+		std::size_t  m_used       = 0;
+
+		// rebuilt every frame for multi draw, the offsets are read as an
+		// instanced attribute.
+		unsigned int m_commandBuffer = 0;
+		unsigned int m_offsetBuffer  = 0;
+	};
+} // namespace phx::gfx
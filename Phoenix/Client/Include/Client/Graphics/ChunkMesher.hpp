@@ -36,34 +36,102 @@
 #pragma once
 
 #include <Client/Graphics/TexturePacker.hpp>
-#include <Client/Graphics/ChunkRenderer.hpp>
 #include <Client/Voxels/BlockRegistry.hpp>
 
 #include <Common/Voxels/Chunk.hpp>
+#include <Common/Voxels/ChunkVisibility.hpp>
 
+#include <array>
+#include <cstdint>
 #include <vector>
 
 namespace phx::gfx
 {
+	/**
+	 * @brief A vertex of a chunk mesh, packed into 16 bytes.
+	 *
+	 * Positions are relative to the chunk, the shader adds the position of
+	 * the chunk to them, see SimpleWorld.vert for how the rest is unpacked.
+	 */
+	struct Vertex
+	{
+		/// @brief Added to positions so parts of models that stick out of
+		/// the chunk are still positive, in model units.
+		static constexpr float POSITION_OFFSET = 2.f;
+
+		/// @brief x, y and z in quarters of a model unit, then the index of
+		/// the normal in the top byte. Each of the normal's components is
+		/// -1, 0 or 1, the index is (x + 1) + (y + 1) * 3 + (z + 1) * 9.
+		std::uint32_t position;
+
+		/// @brief u and v in halves of the texture, then the texture array
+		/// layer in the top 16 bits.
+		std::uint32_t uv;
+
+		/// @brief The bottom left corner of the texture on its layer, in
+		/// texels, x in the bottom 16 bits and y in the top.
+		std::uint32_t textureOrigin;
+
+		/// @brief The size of the texture on its layer, in texels.
+		std::uint32_t textureSize;
+	};
+
+	static_assert(sizeof(Vertex) == 16, "chunk vertices should stay packed.");
+
+	/**
+	 * @brief How the faces of full blocks are turned into triangles.
+	 *
+	 * SIMPLE emits every visible face on its own, GREEDY merges coplanar
+	 * faces with the same texture into as few rectangles as it can, the
+	 * texture is then tiled across the rectangle in the fragment shader.
+	 */
+	enum class MeshingMode
+	{
+		SIMPLE,
+		GREEDY
+	};
+
+	/**
+	 * @brief The chunks around a chunk, indexed by the BlockFace they touch.
+	 *
+	 * NORTH and SOUTH are the chunks towards -z and +z, EAST and WEST towards
+	 * -x and +x, then TOP and BOTTOM towards +y and -y.
+	 * A chunk that isn't loaded is nullptr, the faces on that side are then
+	 * kept until the chunk is remeshed with it loaded.
+	 */
+	using ChunkNeighbours = std::array<const voxels::Chunk*, 6>;
+
 	/**
 	 * @brief Meshes a chunk.
 	 *
-	 * This mesher does not understand "smart"/"greedy" meshing, it will mesh
-	 * only this chunk, and will not take neighbor chunks into account as of
-	 * yet. As the project gains maturity and we have more features, this will
-	 * be improved.
+	 * The faces on the border of the chunk are culled against its
+	 * neighbours, so a chunk needs to be meshed again when a neighbour is
+	 * loaded or changes. Only full blocks are merged in greedy mode, every
+	 * other block model is meshed the same in both modes.
 	 *
 	 * @paragraph Usage
 	 * @code
-	 * auto mesh = ChunkMesher::mesh(chunk, renderer->getTextureTable(),
-	 * blockRegistry);
+	 * auto mesh = ChunkMesher::mesh(chunk, blockRegistry,
+	 *                               MeshingMode::GREEDY, neighbours);
 	 * @endcode
 	 *
 	 */
 	class ChunkMesher
 	{
 	public:
-		static std::vector<float> mesh(voxels::Chunk*         chunk,
-		                               client::BlockRegistry* blockRegistry);
+		static std::vector<Vertex> mesh(
+		    voxels::Chunk* chunk, client::BlockRegistry* blockRegistry,
+		    MeshingMode            mode       = MeshingMode::SIMPLE,
+		    const ChunkNeighbours& neighbours = {});
+
+		/**
+		 * @brief Finds which faces of a chunk can see each other through
+		 * the blocks that aren't full solid blocks.
+		 * @param chunk The chunk to look through.
+		 * @param blockRegistry The registry with the model of each block.
+		 * @return The visibility of the chunk, for occlusion culling.
+		 */
+		static voxels::ChunkVisibility getVisibility(
+		    const voxels::Chunk* chunk, client::BlockRegistry* blockRegistry);
 	};
 } // namespace phx::gfx
@@ -36,26 +36,26 @@
 #pragma once
 
 #include <Client/Graphics/Camera.hpp>
+#include <Client/Graphics/ChunkMeshArena.hpp>
+#include <Client/Graphics/ChunkMesher.hpp>
 #include <Client/Graphics/ShaderPipeline.hpp>
 #include <Client/Voxels/BlockRegistry.hpp>
 #include <Client/Graphics/TexturePacker.hpp>
 
+#include <Common/Settings.hpp>
+#include <Common/Utility/BlockingQueue.hpp>
+#include <Common/Utility/ThreadPool.hpp>
 #include <Common/Voxels/Map.hpp>
 
 #include <entt/entt.hpp>
 
+#include <atomic>
+#include <memory>
 #include <unordered_map>
 #include <vector>
 
 namespace phx::gfx
 {
-	struct Vertex
-	{
-		math::vec3 pos;
-		math::vec3 uv;
-		math::vec3 normal;
-	};
-	
 	/**
 	 * @brief A struct to store the data required to render chunks.
 	 *
@@ -64,12 +64,27 @@ namespace phx::gfx
 	 */
 	struct ChunkRenderData
 	{
-		/// @brief The vertex array object.
-		unsigned int vao;
-		/// @brief The buffer object.
-		unsigned int buffer;
+		/// @brief Where the mesh is in the ChunkMeshArena.
+		ArenaRange range;
 		/// @brief The amount of vertices to render.
-		std::size_t vertexCount;
+		std::size_t vertexCount = 0;
+	};
+
+	/**
+	 * @brief What was drawn in the last frame.
+	 */
+	struct ChunkRenderStats
+	{
+		/// @brief The amount of chunks with a mesh that were in view.
+		std::size_t drawn = 0;
+		/// @brief The amount of chunks with a mesh that were out of view or
+		/// hidden behind other chunks.
+		std::size_t culled = 0;
+		/// @brief The amount of draw calls made for the chunks.
+		std::size_t drawCalls = 0;
+		/// @brief The amount of memory the meshes take up on the GPU, in
+		/// bytes.
+		std::size_t meshMemory = 0;
 	};
 
 	/**
@@ -141,6 +156,88 @@ namespace phx::gfx
 		 */
 		const AssociativeTextureTable& getTextureTable() const;
 
+		const ChunkRenderStats& getStats() const;
+
+	private:
+		/**
+		 * @brief A mesh finished by the worker threads, waiting to be
+		 * uploaded.
+		 */
+		struct MeshResult
+		{
+			math::vec3          pos;
+			std::size_t         version = 0;
+			std::vector<Vertex> mesh;
+
+			voxels::ChunkVisibility visibility;
+		};
+
+		/**
+		 * @brief Queues a chunk to be meshed by the worker threads,
+		 * superseding any mesh of it that hasn't been uploaded yet.
+		 * @param chunk The chunk to mesh, it is copied along with its
+		 * neighbours so it can keep changing in the meantime.
+		 */
+		void requestMesh(voxels::Chunk* chunk);
+
+		/**
+		 * @brief Uploads a finished mesh, unless a newer one was requested.
+		 * @param result The finished mesh.
+		 */
+		void upload(const MeshResult& result);
+
+		/**
+		 * @brief Gets the loaded chunks around a chunk.
+		 * @param pos The position of the chunk to get the neighbours of.
+		 * @return The neighbours, nullptr where they aren't loaded.
+		 */
+		ChunkNeighbours getNeighbours(const math::vec3& pos) const;
+
+		/**
+		 * @brief Remeshes the rendered neighbours of a chunk, since the faces
+		 * on their border depend on it.
+		 * @param pos The position of the chunk that was added, changed or
+		 * unloaded.
+		 * @param faces Which neighbours to remesh, indexed by BlockFace.
+		 */
+		void updateNeighbours(const math::vec3&          pos,
+		                      const std::array<bool, 6>& faces);
+
+		/**
+		 * @brief Stops rendering the chunks that are too far from the
+		 * player and unloads them from the map.
+		 */
+		void unloadOutOfRange();
+
+		/**
+		 * @brief Adds the draw of a chunk's mesh.
+		 * @param pos The position of the chunk.
+		 * @param data Where its mesh is.
+		 */
+		void addDraw(const math::vec3& pos, const ChunkRenderData& data);
+
+		/**
+		 * @brief Adds the draws of the chunks that are in view.
+		 * @param frustum The view of the camera.
+		 */
+		void addDrawsInView(const math::Frustum& frustum);
+
+		/**
+		 * @brief Adds the draws of the chunks that are in view and aren't
+		 * hidden behind other chunks.
+		 * @param frustum The view of the camera.
+		 * @return false if the chunk the camera is in isn't rendered, no
+		 * draws are added then.
+		 */
+		bool addVisibleDraws(const math::Frustum& frustum);
+
+		/**
+		 * @brief Gets the minimum corner of a chunk's bounds.
+		 * @param pos The position of the chunk.
+		 * @return The corner, in model units.
+		 */
+		static math::vec3 getBoundsMin(const math::vec3& pos);
+
 	private:
 		client::BlockRegistry* m_blockRegistry;
 		voxels::Map*           m_map;
@@ -153,19 +250,57 @@ namespace phx::gfx
 
 		// keep another copy of chunk pointers so we can know which chunks need
 		// to be remeshed that are being rendered rn.
-		std::vector<voxels::Chunk*> m_chunks;
+		std::unordered_map<math::vec3, voxels::Chunk*, math::Vector3Hasher,
+		                   math::Vector3KeyComparator>
+		    m_chunks;
 
 		std::unordered_map<math::vec3, ChunkRenderData, math::Vector3Hasher,
 		                   math::Vector3KeyComparator>
 		    m_buffers;
 
-		const int m_vertexAttributeLocation = 0;
-		const int m_uvAttributeLocation     = 1;
-		const int m_normalAttributeLocation = 2;
-		const int m_colorAttributeLocation  = 3;
+		ChunkMeshArena m_arena;
+
+		// the setting can be flipped at runtime, every chunk is remeshed
+		// when it no longer matches the mode the meshes were built with.
+		Setting<bool> m_greedyMeshing;
+		MeshingMode   m_meshingMode;
+
+		// every chunk is drawn with a single call per arena page when the
+		// driver supports it, the list is kept to avoid allocating.
+		Setting<bool>          m_multiDraw;
+		std::vector<ArenaDraw> m_draws;
+
+		// chunks outside of the camera's view aren't drawn, the bounds of
+		// every mesh are rebuilt along with the draws.
+		math::PackedBoxes         m_bounds;
+		std::vector<std::uint8_t> m_visible;
+		ChunkRenderStats          m_stats;
+
+		// chunks that are buried behind others aren't drawn either, found
+		// by walking outwards from the camera through the chunks that can
+		// be seen through.
+		Setting<bool> m_occlusionCulling;
+		std::unordered_map<math::vec3, voxels::ChunkVisibility,
+		                   math::Vector3Hasher, math::Vector3KeyComparator>
+		                        m_visibility;
+		std::vector<math::vec3> m_visibleChunks;
 
 		unsigned int   m_selectionBoxVAO = 0;
 		unsigned int   m_selectionBoxVBO = 0;
 		ShaderPipeline m_selectionBoxPipeline;
+
+		// the latest mesh requested for each chunk, jobs for an older one
+		// are skipped and their results are dropped.
+		std::unordered_map<math::vec3,
+		                   std::shared_ptr<std::atomic<std::size_t>>,
+		                   math::Vector3Hasher, math::Vector3KeyComparator>
+		                          m_meshVersions;
+		std::size_t               m_lastMeshVersion = 0;
+		BlockingQueue<MeshResult> m_meshed;
+		Setting<int>              m_uploadBudget;
+
+		// declared last so the workers are stopped before anything they
+		// use is destroyed.
+		std::unique_ptr<ThreadPool> m_pool;
 	};
 } // namespace phx::gfx
@@ -65,6 +65,9 @@ namespace phx::gfx
 		// may be improved upon in the future.
 		constexpr static unsigned int MAX_TEXTURE_SIZE = 512;
 
+		// the width and height of every layer of the texture array.
+		constexpr static unsigned int LAYER_SIZE = 1024;
+
 	public:
 		TexturePacker();
 		~TexturePacker();
@@ -82,7 +82,7 @@ namespace phx::client
 		gfx::FPSCamera* m_camera;
 		entt::registry* m_registry;
 
-		std::size_t m_sequence;
+		std::size_t m_sequence = 0;
 
 		client::Input* m_forward;
 		client::Input* m_backward;
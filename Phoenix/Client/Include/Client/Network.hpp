@@ -32,10 +32,12 @@
 
 #include <Common/Input.hpp>
 #include <Common/Network/Host.hpp>
+#include <Common/Network/Snapshot.hpp>
 #include <Common/Position.hpp>
 #include <Common/Utility/BlockingQueue.hpp>
 #include <Common/Voxels/Chunk.hpp>
 
+#include <atomic>
 #include <thread>
 
 namespace phx::client
@@ -106,6 +108,19 @@ namespace phx::client
 		bool            m_running = false;
 		phx::net::Host* m_client;
 		std::thread     m_thread;
-		std::size_t     m_currentSequence;
+
+		// snapshots are read on the network thread, the newest one is
+		// acknowledged along with every input sent.
+		phx::net::SnapshotReceiver m_snapshots;
+		std::atomic<std::uint32_t> m_acknowledged {0};
+
+		// the latest input states, every packet repeats them so one lost
+		// packet doesn't lose any input.
+		phx::InputBatch m_sentStates;
+		std::size_t     m_inputRedundancy;
+
+		// snapshots only carry the lowest bits of the input sequence, the
+		// rest is taken from the newest input sent.
+		std::atomic<std::size_t> m_latestSequence {0};
 	};
 } // namespace phx::client
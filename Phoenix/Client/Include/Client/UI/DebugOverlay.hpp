@@ -31,6 +31,9 @@
 #include <Client/Events/Event.hpp>
 #include <Client/Graphics/Layer.hpp>
 
+#include <map>
+#include <string>
+
 namespace phx::client
 {
 	/**
@@ -50,6 +53,13 @@ namespace phx::client
 		void onEvent(events::Event& e) override;
 		void tick(float dt) override;
 
+		/**
+		 * @brief Shows a value under the graphics information.
+		 * @param name The name to show the value with.
+		 * @param value The value, it's shown until it's set again.
+		 */
+		void setStatistic(const std::string& name, std::size_t value);
+
 	private:
 		bool m_wireframe     = false;
 		int  m_sampleRate    = 60;
@@ -57,5 +67,7 @@ namespace phx::client
 		bool m_pauseSampling = false;
 
 		unsigned int m_time = 0;
+
+		std::map<std::string, std::size_t> m_statistics;
 	};
 } // namespace phx::client
@@ -65,6 +65,14 @@ void Client::popLayer(phx::gfx::Layer* layer)
 	}
 }
 
+DebugOverlay* Client::getDebugOverlay()
+{
+	if (m_debugOverlay == nullptr)
+		m_debugOverlay = new DebugOverlay();
+
+	return m_debugOverlay;
+}
+
 void Client::onEvent(phx::events::Event e)
 {
 	using namespace phx::events;
@@ -81,10 +89,7 @@ void Client::onEvent(phx::events::Event e)
 			m_debugOverlayActive = !m_debugOverlayActive;
 			if (m_debugOverlayActive)
 			{
-				if (m_debugOverlay == nullptr)
-					m_debugOverlay = new DebugOverlay();
-
-				m_layerStack.pushLayer(m_debugOverlay);
+				m_layerStack.pushLayer(getDebugOverlay());
 			}
 			else
 			{
@@ -39,7 +39,10 @@
 #include <Common/Movement.hpp>
 
 #include <Common/PlayerView.hpp>
+#include <Common/Voxels/BlockAccessor.hpp>
+#include <algorithm>
 #include <cmath>
+#include <string>
 #include <tuple>
 
 using namespace phx::client;
@@ -136,6 +139,57 @@ Game::Game(gfx::Window* window, entt::registry* registry, bool networked)
 		                               }
 		                               return value;
 	                               });
+
+	// reading only the ID through a BlockAccessor skips the metadata and the
+	// table of getBlock, for mods walking or scanning many blocks.
+	m_modManager->registerFunction(
+	    "voxel.map.getBlockId", [this](math::vec3 pos) -> std::string {
+		    if (m_map == nullptr)
+		    {
+			    return "";
+		    }
+		    voxels::BlockAccessor blocks(m_map);
+		    return blocks.getTypeAt(voxels::toBlockPos(pos))->id;
+	    });
+
+	// getBlockIds reads at most 4 chunks worth of blocks (16384) a call,
+	// a bigger box raises a Lua error. Every chunk in the box that isn't
+	// loaded is queued for loading, so the cap also keeps a mod from
+	// pulling in a large part of the world at once.
+	m_modManager->registerFunction(
+	    "voxel.map.getBlockIds", [this](math::vec3 min, math::vec3 max) {
+		    constexpr long long maxBlocks = 4 * voxels::Chunk::CHUNK_MAX_BLOCKS;
+
+		    const math::vec3i from = voxels::toBlockPos(min);
+		    const math::vec3i to   = voxels::toBlockPos(max);
+		    // clamped so multiplying the sides of a huge box can't overflow.
+		    const auto size = [](int low, int high) {
+			    return std::clamp(static_cast<long long>(high) - low + 1, 0LL,
+			                      maxBlocks + 1);
+		    };
+		    if (size(from.x, to.x) * size(from.y, to.y) * size(from.z, to.z) >
+		        maxBlocks)
+		    {
+			    throw sol::error("voxel.map.getBlockIds can read at most " +
+			                     std::to_string(maxBlocks) +
+			                     " blocks at once");
+		    }
+
+		    // x changes fastest, then y, then z.
+		    sol::table ids = m_modManager->createTable();
+		    if (m_map == nullptr)
+		    {
+			    return ids;
+		    }
+
+		    std::vector<voxels::BlockType*> types;
+		    voxels::BlockAccessor(m_map).getTypes(from, to, types);
+		    for (std::size_t i = 0; i < types.size(); ++i)
+		    {
+			    ids[i + 1] = types[i]->id;
+		    }
+		    return ids;
+	    });
 }
 
 Game::~Game()
@@ -170,7 +224,17 @@ void Game::onAttach()
 	}
 	else
 	{
-		m_map = new voxels::Map(m_save, "map1", &m_blockRegistry.referrer);
+		m_map = new voxels::Map(
+		    m_save, "map1", &m_blockRegistry.referrer,
+		    Settings::instance()->getOr("map:io_threads", 2));
+		m_map->setWriteBack(
+		    std::chrono::milliseconds(
+		        Settings::instance()->getOr("map:flush_interval_ms", 5000)),
+		    Settings::instance()->getOr("map:max_dirty_chunks", 64));
+		m_map->setCompression(
+		    data::Compression::fromName(Settings::instance()->getOr(
+		        "map:compression", std::string("deflate"))),
+		    Settings::instance()->getOr("map:compression_level", 1));
 	}
 	m_invManager =
 	    new voxels::InventoryManager(m_save, &m_itemRegistry.referrer);
@@ -233,7 +297,8 @@ void Game::onAttach()
 	m_inputQueue = new InputQueue(m_registry, m_player, m_camera);
 	if (m_network != nullptr)
 	{
-		m_inputQueue->start(std::chrono::milliseconds(50), m_network);
+		m_inputQueue->start(std::chrono::milliseconds(1000 / InputState::RATE),
+		                    m_network);
 	}
 	LOG_INFO("MAIN") << "Game layer attached";
 	SoLoud::Wav* bg = m_audioRegistry.get(
@@ -252,6 +317,10 @@ void Game::onDetach()
 	delete m_network;
 	delete m_camera;
 	delete m_audioEventHandler;
+
+	// deleting the map saves every chunk that was edited but not saved yet.
+	delete m_map;
+	m_map = nullptr;
 }
 
 void Game::onEvent(events::Event& e)
@@ -388,7 +457,26 @@ void Game::tick(float dt)
 	m_renderPipeline.setVector3("u_LightDir", lightdir);
 	m_renderPipeline.setFloat("u_Brightness", 0.6f);
 
+	// publish chunks loaded in the background before the renderer looks for
+	// new chunks to mesh.
+	m_map->tick(std::chrono::milliseconds(2));
+
 	m_mapRenderer->tick(dt);
+
+	if (Client::get()->isDebugLayerActive())
+	{
+		const gfx::ChunkRenderStats& stats = m_mapRenderer->getStats();
+
+		DebugOverlay* overlay = Client::get()->getDebugOverlay();
+		overlay->setStatistic("Chunks Drawn", stats.drawn);
+		overlay->setStatistic("Chunks Culled", stats.culled);
+		overlay->setStatistic("Chunk Draw Calls", stats.drawCalls);
+		overlay->setStatistic("Chunks Loaded", m_map->getLoadedChunkCount());
+		overlay->setStatistic("Chunk Memory (KiB)",
+		                      m_map->getMemoryUsage() / 1024);
+		overlay->setStatistic("Mesh Memory (KiB)", stats.meshMemory / 1024);
+	}
+
 	m_mapRenderer->renderSelectionBox();
 
 	m_worldRenderer->tick(dt);
@@ -428,7 +516,8 @@ void Game::confirmState(const Position& position)
 	    entity, m_registry->get<Movement>(m_player).moveSpeed);
 	for (const auto& inputState : m_states)
 	{
-		phx::ActorSystem::tick(m_registry, entity, 1.f / 20.f, inputState);
+		phx::ActorSystem::tick(m_registry, entity, 1.f / InputState::RATE,
+		                       inputState);
 	}
 
 	// Compare the temporary position object with the current player position.
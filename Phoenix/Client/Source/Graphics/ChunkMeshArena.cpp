@@ -0,0 +1,385 @@
+// Copyright 2019-20 Genten Studios
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors
+// may be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include <Client/Graphics/ChunkMeshArena.hpp>
+
+#include <Common/Logger.hpp>
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <iterator>
+
+using namespace phx::gfx;
+
+namespace
+{
+	// the layout glMultiDrawArraysIndirect reads its commands in.
+	struct DrawArraysIndirectCommand
+	{
+		GLuint count;
+		GLuint instanceCount;
+		GLuint first;
+		GLuint baseInstance;
+	};
+} // namespace
+
+ChunkMeshArena::ChunkMeshArena()
+{
+	m_persistent = GLAD_GL_ARB_buffer_storage != 0;
+
+	// the base instance is only used to pick the offset of each command
+	// with ARB_base_instance, which is core from 4.2 on.
+	m_multiDraw = GLAD_GL_ARB_multi_draw_indirect != 0 &&
+	              GLAD_GL_ARB_base_instance != 0;
+
+	glGenVertexArrays(1, &m_vao);
+	glBindVertexArray(m_vao);
+	glEnableVertexAttribArray(0);
+
+	if (m_multiDraw)
+	{
+		glGenBuffers(1, &m_commandBuffer);
+		glGenBuffers(1, &m_offsetBuffer);
+
+		// one offset per command rather than per vertex.
+		glBindBuffer(GL_ARRAY_BUFFER, m_offsetBuffer);
+		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(math::vec3),
+		                      nullptr);
+		glVertexAttribDivisor(1, 1);
+	}
+}
+
+ChunkMeshArena::~ChunkMeshArena()
+{
+	for (Retired& retired : m_retired)
+	{
+		glDeleteSync(static_cast<GLsync>(retired.fence));
+	}
+
+	// deleting a buffer unmaps it as well.
+	for (Page& page : m_pages)
+	{
+		glDeleteBuffers(1, &page.buffer);
+	}
+
+	glDeleteBuffers(1, &m_commandBuffer);
+	glDeleteBuffers(1, &m_offsetBuffer);
+	glDeleteVertexArrays(1, &m_vao);
+}
+
+void ChunkMeshArena::write(ArenaRange& range, const std::vector<Vertex>& mesh)
+{
+	if (mesh.empty())
+	{
+		free(range);
+		return;
+	}
+
+	// the GPU might still be reading a mapped range, so it's never written
+	// over, glBufferSubData waits for the GPU by itself.
+	if (m_persistent || range.capacity < mesh.size())
+	{
+		free(range);
+		range = allocate(mesh.size());
+	}
+
+	Page& page = m_pages[range.page];
+	if (page.mapped != nullptr)
+	{
+		std::copy(mesh.begin(), mesh.end(), page.mapped + range.first);
+	}
+	else
+	{
+		glBindBuffer(GL_ARRAY_BUFFER, page.buffer);
+		glBufferSubData(GL_ARRAY_BUFFER, sizeof(Vertex) * range.first,
+		                sizeof(Vertex) * mesh.size(), mesh.data());
+	}
+}
+
+void ChunkMeshArena::free(ArenaRange& range)
+{
+	if (range.capacity == 0)
+	{
+		return;
+	}
+
+	if (m_persistent)
+	{
+		m_freed.push_back(range);
+	}
+	else
+	{
+		release(range);
+	}
+
+	range = {};
+}
+
+std::size_t ChunkMeshArena::draw(std::vector<ArenaDraw>& draws, bool multiDraw)
+{
+	if (draws.empty())
+	{
+		return 0;
+	}
+
+	// every page needs at least one draw call, so keep them together.
+	const auto byPage = [](const ArenaDraw& lhs, const ArenaDraw& rhs) {
+		return lhs.range.page < rhs.range.page;
+	};
+	std::sort(draws.begin(), draws.end(), byPage);
+
+	glBindVertexArray(m_vao);
+
+	std::size_t drawCalls = 0;
+	if (!multiDraw || !m_multiDraw)
+	{
+		glDisableVertexAttribArray(1);
+
+		for (const ArenaDraw& draw : draws)
+		{
+			bind(draw.range.page);
+			glVertexAttrib3f(1, draw.offset.x, draw.offset.y, draw.offset.z);
+			glDrawArrays(GL_TRIANGLES, static_cast<GLint>(draw.range.first),
+			             static_cast<GLsizei>(draw.vertexCount));
+			++drawCalls;
+		}
+
+		return drawCalls;
+	}
+
+	std::vector<DrawArraysIndirectCommand> commands;
+	std::vector<math::vec3>                offsets;
+	commands.reserve(draws.size());
+	offsets.reserve(draws.size());
+	for (const ArenaDraw& draw : draws)
+	{
+		// the base instance is the index of the offset to draw with.
+		commands.push_back({static_cast<GLuint>(draw.vertexCount), 1,
+		                    static_cast<GLuint>(draw.range.first),
+		                    static_cast<GLuint>(offsets.size())});
+		offsets.push_back(draw.offset);
+	}
+
+	// orphan the old contents, the last frame might still be using them.
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_commandBuffer);
+	glBufferData(GL_DRAW_INDIRECT_BUFFER,
+	             sizeof(DrawArraysIndirectCommand) * commands.size(),
+	             commands.data(), GL_STREAM_DRAW);
+
+	glBindBuffer(GL_ARRAY_BUFFER, m_offsetBuffer);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(math::vec3) * offsets.size(),
+	             offsets.data(), GL_STREAM_DRAW);
+
+	glEnableVertexAttribArray(1);
+
+	std::size_t first = 0;
+	while (first < draws.size())
+	{
+		const std::size_t page = draws[first].range.page;
+
+		std::size_t last = first + 1;
+		while (last < draws.size() && draws[last].range.page == page)
+		{
+			++last;
+		}
+
+		bind(page);
+		glMultiDrawArraysIndirect(
+		    GL_TRIANGLES,
+		    reinterpret_cast<const void*>(sizeof(DrawArraysIndirectCommand) *
+		                                  first),
+		    static_cast<GLsizei>(last - first), 0);
+		++drawCalls;
+
+		first = last;
+	}
+
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+
+	return drawCalls;
+}
+
+bool ChunkMeshArena::isMultiDrawSupported() const { return m_multiDraw; }
+
+void ChunkMeshArena::bind(std::size_t page)
+{
+	if (page == m_boundPage)
+	{
+		return;
+	}
+
+	// the vertex is unpacked in the shader, so it's passed in as is.
+	glBindBuffer(GL_ARRAY_BUFFER, m_pages[page].buffer);
+	glVertexAttribIPointer(0, 4, GL_UNSIGNED_INT, sizeof(Vertex), nullptr);
+	m_boundPage = page;
+}
+
+void ChunkMeshArena::endFrame()
+{
+	if (!m_freed.empty())
+	{
+		Retired retired;
+		retired.fence  = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		retired.ranges = std::move(m_freed);
+		m_freed.clear();
+
+		m_retired.push_back(std::move(retired));
+	}
+
+	// fences pass in order, so stop at the first one that hasn't.
+	while (!m_retired.empty())
+	{
+		const GLsync fence  = static_cast<GLsync>(m_retired.front().fence);
+		const GLenum status = glClientWaitSync(fence, 0, 0);
+		if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+		{
+			break;
+		}
+
+		glDeleteSync(fence);
+		for (const ArenaRange& range : m_retired.front().ranges)
+		{
+			release(range);
+		}
+
+		m_retired.pop_front();
+	}
+}
+
+std::size_t ChunkMeshArena::getPageCount() const { return m_pages.size(); }
+
+std::size_t ChunkMeshArena::getUsedVertices() const { return m_used; }
+
+ArenaRange ChunkMeshArena::allocate(std::size_t size)
+{
+	size = (size + GRANULARITY - 1) / GRANULARITY * GRANULARITY;
+
+	for (std::size_t i = 0;; ++i)
+	{
+		if (i == m_pages.size())
+		{
+			addPage(std::max(size, PAGE_VERTICES));
+		}
+
+		auto& free = m_pages[i].free;
+		auto  it   = free.begin();
+		while (it != free.end() && it->second < size)
+		{
+			++it;
+		}
+
+		if (it == free.end())
+		{
+			continue;
+		}
+
+		ArenaRange range;
+		range.page     = i;
+		range.first    = it->first;
+		range.capacity = size;
+
+		// the rest of the free range stays free.
+		if (it->second > size)
+		{
+			free.emplace(it->first + size, it->second - size);
+		}
+		free.erase(it);
+
+		m_used += size;
+		return range;
+	}
+}
+
+void ChunkMeshArena::release(const ArenaRange& range)
+{
+	auto& free = m_pages[range.page].free;
+
+	auto it = free.emplace(range.first, range.capacity).first;
+
+	// merge with the free ranges on either side.
+	const auto next = std::next(it);
+	if (next != free.end() && it->first + it->second == next->first)
+	{
+		it->second += next->second;
+		free.erase(next);
+	}
+
+	if (it != free.begin())
+	{
+		const auto previous = std::prev(it);
+		if (previous->first + previous->second == it->first)
+		{
+			previous->second += it->second;
+			free.erase(it);
+		}
+	}
+
+	m_used -= range.capacity;
+}
+
+std::size_t ChunkMeshArena::addPage(std::size_t size)
+{
+	Page page;
+	page.size = size;
+	page.free.emplace(0, size);
+
+	glGenBuffers(1, &page.buffer);
+	glBindBuffer(GL_ARRAY_BUFFER, page.buffer);
+
+	if (m_persistent)
+	{
+		// dynamic storage lets the page still be written the slow way if
+		// it can't be mapped.
+		const GLbitfield flags =
+		    GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		glBufferStorage(GL_ARRAY_BUFFER, sizeof(Vertex) * size, nullptr,
+		                flags | GL_DYNAMIC_STORAGE_BIT);
+		page.mapped = static_cast<Vertex*>(glMapBufferRange(
+		    GL_ARRAY_BUFFER, 0, sizeof(Vertex) * size, flags));
+
+		if (page.mapped == nullptr)
+		{
+			LOG_WARNING("RENDERER")
+			    << "Could not map a chunk mesh page, falling back to "
+			       "glBufferSubData.";
+		}
+	}
+	else
+	{
+		glBufferData(GL_ARRAY_BUFFER, sizeof(Vertex) * size, nullptr,
+		             GL_DYNAMIC_DRAW);
+	}
+
+	LOG_DEBUG("RENDERER") << "Added a chunk mesh page of " << size
+	                      << " vertices, " << m_pages.size() + 1
+	                      << " pages in total.";
+
+	m_pages.push_back(std::move(page));
+	return m_pages.size() - 1;
+}
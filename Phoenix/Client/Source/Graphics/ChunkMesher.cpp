@@ -30,36 +30,449 @@
 #include <Client/Graphics/ChunkMesher.hpp>
 #include <Client/Graphics/TexturePacker.hpp>
 
+#include <array>
+#include <cmath>
+#include <cstdint>
+
 using namespace phx::gfx;
 
-std::vector<float> ChunkMesher::mesh(phx::voxels::Chunk*         chunk,
-                                     phx::client::BlockRegistry* blockRegistry)
+namespace
 {
-	std::vector<float> mesh;
+	/**
+	 * @brief Packs a vertex into the chunk vertex format.
+	 *
+	 * The position is relative to the chunk. UVs above 1 repeat the texture,
+	 * the shader wraps them back into the texture's rectangle on its layer.
+	 */
+	void pushVertex(std::vector<Vertex>& mesh, const phx::math::vec3& pos,
+	                const phx::math::vec2& uv, const TextureData* texData,
+	                const phx::math::vec3& normal)
+	{
+		// every block model is built out of quarters of a model unit.
+		const auto quarters = [](float value) {
+			return static_cast<std::uint32_t>(
+			    std::lround((value + Vertex::POSITION_OFFSET) * 4.f));
+		};
+
+		const auto halves = [](float value) {
+			return static_cast<std::uint32_t>(std::lround(value * 2.f));
+		};
+
+		const auto texels = [](float value) {
+			return static_cast<std::uint32_t>(
+			    std::lround(value * TexturePacker::LAYER_SIZE));
+		};
+
+		// the normal's components are each -1, 0 or 1.
+		const auto normalIndex = static_cast<std::uint32_t>(
+		    std::lround(normal.x + 1.f) + std::lround(normal.y + 1.f) * 3 +
+		    std::lround(normal.z + 1.f) * 9);
+
+		Vertex vertex;
+		vertex.position = quarters(pos.x) | (quarters(pos.y) << 8) |
+		                  (quarters(pos.z) << 16) | (normalIndex << 24);
+		vertex.uv       = halves(uv.x) | (halves(uv.y) << 8) |
+		            (static_cast<std::uint32_t>(texData->layer) << 16);
+		vertex.textureOrigin = texels(texData->bottomLeftUV.x) |
+		                       (texels(texData->bottomLeftUV.y) << 16);
+		vertex.textureSize =
+		    texels(texData->uvSize.x) | (texels(texData->uvSize.y) << 16);
+
+		mesh.push_back(vertex);
+	}
+
+	phx::math::vec3 toMeshPosition(const DefaultMeshVertex* vertex,
+	                               const phx::math::vec3&   blockPos)
+	{
+		return {vertex->pos.x + (blockPos.x * DEFAULT_MODEL_SIZE),
+		        vertex->pos.y + (blockPos.y * DEFAULT_MODEL_SIZE),
+		        vertex->pos.z + (blockPos.z * DEFAULT_MODEL_SIZE)};
+	}
+
+	// whether each block in a palette is a full solid block, which hides
+	// the faces next to it.
+	std::vector<bool> resolveOpaque(
+	    const phx::voxels::BlockStorage::Palette& palette,
+	    phx::client::BlockRegistry*               blockRegistry)
+	{
+		using namespace phx::voxels;
+
+		std::vector<bool> opaque(palette.size());
+		for (std::size_t p = 0; p < palette.size(); ++p)
+		{
+			opaque[p] =
+			    palette[p]->category == BlockCategory::SOLID &&
+			    *blockRegistry->models.get(palette[p]->uniqueIdentifier) ==
+			        BlockModel::BLOCK;
+		}
+
+		return opaque;
+	}
+
+	/**
+	 * @brief Resolves whether blocks are full solid blocks, in the chunk
+	 * being meshed and in the chunks around it.
+	 *
+	 * Every palette entry is resolved once up front, the checks while meshing
+	 * then only need the palette index.
+	 */
+	class OpaqueLookup
+	{
+	public:
+		OpaqueLookup(const phx::voxels::Chunk*   chunk,
+		             const ChunkNeighbours&      neighbours,
+		             phx::client::BlockRegistry* blockRegistry)
+		    : m_chunk(resolve(chunk, blockRegistry))
+		{
+			for (std::size_t i = 0; i < neighbours.size(); ++i)
+			{
+				m_neighbours[i] = resolve(neighbours[i], blockRegistry);
+			}
+		}
+
+		bool isOpaque(std::size_t paletteIndex) const
+		{
+			return m_chunk.opaque[paletteIndex];
+		}
+
+		// the position is relative to the chunk being meshed and can be a
+		// block outside of it, into one of its neighbours. a neighbour that
+		// isn't loaded is never opaque, so the border stays closed until it
+		// is.
+		bool isOpaque(int x, int y, int z) const
+		{
+			using phx::voxels::Chunk;
+
+			const Resolved* chunk = &m_chunk;
+			if (x < 0)
+			{
+				chunk =
+				    &m_neighbours[static_cast<std::size_t>(BlockFace::EAST)];
+				x += Chunk::CHUNK_WIDTH;
+			}
+			else if (x >= Chunk::CHUNK_WIDTH)
+			{
+				chunk =
+				    &m_neighbours[static_cast<std::size_t>(BlockFace::WEST)];
+				x -= Chunk::CHUNK_WIDTH;
+			}
+			else if (y < 0)
+			{
+				chunk =
+				    &m_neighbours[static_cast<std::size_t>(BlockFace::BOTTOM)];
+				y += Chunk::CHUNK_HEIGHT;
+			}
+			else if (y >= Chunk::CHUNK_HEIGHT)
+			{
+				chunk =
+				    &m_neighbours[static_cast<std::size_t>(BlockFace::TOP)];
+				y -= Chunk::CHUNK_HEIGHT;
+			}
+			else if (z < 0)
+			{
+				chunk =
+				    &m_neighbours[static_cast<std::size_t>(BlockFace::NORTH)];
+				z += Chunk::CHUNK_DEPTH;
+			}
+			else if (z >= Chunk::CHUNK_DEPTH)
+			{
+				chunk =
+				    &m_neighbours[static_cast<std::size_t>(BlockFace::SOUTH)];
+				z -= Chunk::CHUNK_DEPTH;
+			}
+
+			if (chunk->blocks == nullptr)
+			{
+				return false;
+			}
+
+			return chunk->opaque[chunk->blocks->getPaletteIndex(
+			    Chunk::getVectorIndex(x, y, z))];
+		}
+
+	private:
+		struct Resolved
+		{
+			const phx::voxels::BlockStorage* blocks = nullptr;
+			std::vector<bool>                opaque;
+		};
+
+		static Resolved resolve(const phx::voxels::Chunk*   chunk,
+		                        phx::client::BlockRegistry* blockRegistry)
+		{
+			using namespace phx::voxels;
+
+			Resolved resolved;
+			if (chunk == nullptr)
+			{
+				return resolved;
+			}
+
+			resolved.blocks = &chunk->getBlocks();
+			resolved.opaque =
+			    resolveOpaque(resolved.blocks->getPalette(), blockRegistry);
 
-	auto&           blocks   = chunk->getBlocks();
-	phx::math::vec3 chunkPos = chunk->getChunkPos();
+			return resolved;
+		}
+
+	private:
+		Resolved                m_chunk;
+		std::array<Resolved, 6> m_neighbours;
+	};
+
+	struct GreedyFace
+	{
+		const DefaultMeshVertex* vertices;
+		BlockFace                face;
+
+		// the axis the face points along and which way, the neighbour that
+		// decides whether the face is visible is one step that way.
+		int axis;
+		int direction;
+
+		// the axes the template's u and v coordinates run along, so they can
+		// be stretched over the merged rectangle.
+		int uAxis;
+		int vAxis;
+	};
+
+	// the same faces and neighbours the simple mesher checks for a block.
+	const GreedyFace GREEDY_FACES[] = {
+	    {BLOCK_FRONT, BlockFace::NORTH, 2, -1, 0, 1},
+	    {BLOCK_BACK, BlockFace::SOUTH, 2, 1, 0, 1},
+	    {BLOCK_BOTTOM, BlockFace::BOTTOM, 1, -1, 0, 2},
+	    {BLOCK_TOP, BlockFace::TOP, 1, 1, 0, 2},
+	    {BLOCK_RIGHT, BlockFace::EAST, 0, -1, 2, 1},
+	    {BLOCK_LEFT, BlockFace::WEST, 0, 1, 2, 1},
+	};
+
+	void emitRectangle(std::vector<Vertex>& mesh, const GreedyFace& face,
+	                   const int origin[3], const int extent[3],
+	                   const TextureData* texData)
+	{
+		for (std::size_t v = 0; v < BLOCK_FACE_VERT_COUNT; ++v)
+		{
+			const DefaultMeshVertex* current = face.vertices + v;
+
+			// the far corners of the template face move out to the far side
+			// of the rectangle.
+			const phx::math::vec3 corner = {
+			    origin[0] + (current->pos.x > 0 ? extent[0] - 1 : 0),
+			    origin[1] + (current->pos.y > 0 ? extent[1] - 1 : 0),
+			    origin[2] + (current->pos.z > 0 ? extent[2] - 1 : 0)};
+
+			// and the UVs grow with it, so the texture repeats once per
+			// block instead of stretching.
+			pushVertex(mesh, toMeshPosition(current, corner),
+			           {current->uv.x * extent[face.uAxis],
+			            current->uv.y * extent[face.vAxis]},
+			           texData, current->normal);
+		}
+	}
+
+	/**
+	 * @brief Meshes the faces of every full block, merging neighbouring
+	 * faces that share a texture into rectangles.
+	 *
+	 * Each slice of the chunk along every face direction is turned into a
+	 * mask of visible faces (keyed by their texture), which is then covered
+	 * by growing each unmerged face as wide, then as high as it can go.
+	 */
+	void meshGreedy(
+	    std::vector<Vertex>& mesh, const phx::voxels::BlockStorage& blocks,
+	    const OpaqueLookup&                                   lookup,
+	    const std::vector<std::array<const TextureData*, 6>>& textures)
+	{
+		using phx::voxels::Chunk;
+
+		static_assert(Chunk::CHUNK_WIDTH == Chunk::CHUNK_HEIGHT &&
+		                  Chunk::CHUNK_WIDTH == Chunk::CHUNK_DEPTH,
+		              "greedy meshing expects cubic chunks.");
+		constexpr int SIZE = Chunk::CHUNK_WIDTH;
+
+		std::array<const TextureData*, SIZE * SIZE> mask;
+
+		for (const GreedyFace& face : GREEDY_FACES)
+		{
+			// the two axes spanning the slice.
+			const int a = (face.axis + 1) % 3;
+			const int b = (face.axis + 2) % 3;
+
+			for (int slice = 0; slice < SIZE; ++slice)
+			{
+				for (int j = 0; j < SIZE; ++j)
+				{
+					for (int i = 0; i < SIZE; ++i)
+					{
+						int pos[3];
+						pos[face.axis] = slice;
+						pos[a]         = i;
+						pos[b]         = j;
+
+						const std::size_t index =
+						    blocks.getPaletteIndex(Chunk::getVectorIndex(
+						        pos[0], pos[1], pos[2]));
+
+						const TextureData*& cell = mask[i + SIZE * j];
+						cell                     = nullptr;
+
+						if (!lookup.isOpaque(index))
+						{
+							continue;
+						}
+
+						// the face is only visible next to a non full block,
+						// which can be in the neighbouring chunk.
+						pos[face.axis] += face.direction;
+						if (lookup.isOpaque(pos[0], pos[1], pos[2]))
+						{
+							continue;
+						}
+
+						cell = textures[index][static_cast<std::size_t>(
+						    face.face)];
+					}
+				}
+
+				for (int j = 0; j < SIZE; ++j)
+				{
+					for (int i = 0; i < SIZE;)
+					{
+						const TextureData* texData = mask[i + SIZE * j];
+						if (texData == nullptr)
+						{
+							++i;
+							continue;
+						}
+
+						int width = 1;
+						while (i + width < SIZE &&
+						       mask[i + width + SIZE * j] == texData)
+						{
+							++width;
+						}
+
+						int  height = 1;
+						bool grow   = true;
+						while (grow && j + height < SIZE)
+						{
+							for (int k = i; k < i + width; ++k)
+							{
+								if (mask[k + SIZE * (j + height)] != texData)
+								{
+									grow = false;
+									break;
+								}
+							}
+
+							if (grow)
+							{
+								++height;
+							}
+						}
+
+						int origin[3];
+						origin[face.axis] = slice;
+						origin[a]         = i;
+						origin[b]         = j;
+
+						int extent[3];
+						extent[face.axis] = 1;
+						extent[a]         = width;
+						extent[b]         = height;
+
+						emitRectangle(mesh, face, origin, extent, texData);
+
+						for (int h = 0; h < height; ++h)
+						{
+							for (int k = i; k < i + width; ++k)
+							{
+								mask[k + SIZE * (j + h)] = nullptr;
+							}
+						}
+
+						i += width;
+					}
+				}
+			}
+		}
+	}
+} // namespace
+
+std::vector<Vertex> ChunkMesher::mesh(phx::voxels::Chunk*         chunk,
+                                     phx::client::BlockRegistry* blockRegistry,
+                                     MeshingMode                 mode,
+                                     const ChunkNeighbours&      neighbours)
+{
+	std::vector<Vertex> mesh;
 
 	using namespace voxels;
+
+	const BlockStorage&          blocks  = chunk->getBlocks();
+	const BlockStorage::Palette& palette = blocks.getPalette();
+
+	// a chunk made up of a single non solid block (usually air) has nothing
+	// to mesh, don't bother walking it.
+	if (blocks.isSingleValue() &&
+	    palette.front()->category != BlockCategory::SOLID)
+	{
+		return mesh;
+	}
+
+	const OpaqueLookup lookup(chunk, neighbours, blockRegistry);
+
+	if (mode == MeshingMode::GREEDY)
+	{
+		// full blocks are merged by their texture, so look up the texture of
+		// each of their faces up front.
+		std::vector<std::array<const TextureData*, 6>> textures(
+		    palette.size());
+		for (std::size_t p = 0; p < palette.size(); ++p)
+		{
+			if (!lookup.isOpaque(p))
+			{
+				continue;
+			}
+
+			std::vector<TexturePacker::Handle>* tex =
+			    blockRegistry->textureHandles.get(palette[p]->uniqueIdentifier);
+			for (std::size_t face = 0; face < 6; ++face)
+			{
+				textures[p][face] = blockRegistry->texturePacker.getData(
+				    (*tex)[(*tex).size() != 6 ? 0 : face]);
+			}
+		}
+
+		meshGreedy(mesh, blocks, lookup, textures);
+	}
+
 	for (std::size_t i = 0;
 	     i < Chunk::CHUNK_WIDTH * Chunk::CHUNK_HEIGHT * Chunk::CHUNK_DEPTH; ++i)
 	{
-		BlockType* block = blocks[i];
+		const BlockStorage::PaletteIndex paletteIndex =
+		    blocks.getPaletteIndex(i);
+		BlockType* block = palette[paletteIndex];
 
 		if (block->category != BlockCategory::SOLID)
 			continue;
 
+		// the greedy pass has already meshed the full blocks.
+		if (mode == MeshingMode::GREEDY && lookup.isOpaque(paletteIndex))
+			continue;
+
 		// get position of block in chunk.
-		const std::size_t x = i % Chunk::CHUNK_WIDTH;
-		const std::size_t y = (i / Chunk::CHUNK_WIDTH) % Chunk::CHUNK_HEIGHT;
-		const std::size_t z = i / (Chunk::CHUNK_WIDTH * Chunk::CHUNK_HEIGHT);
+		const int x = static_cast<int>(i % Chunk::CHUNK_WIDTH);
+		const int y =
+		    static_cast<int>((i / Chunk::CHUNK_WIDTH) % Chunk::CHUNK_HEIGHT);
+		const int z =
+		    static_cast<int>(i / (Chunk::CHUNK_WIDTH * Chunk::CHUNK_HEIGHT));
 
 		// get textures since at this point we know we're gonna be meshing
 		// something.
 		std::vector<TexturePacker::Handle>* tex = blockRegistry->textureHandles.get(block->uniqueIdentifier);
 
-		auto insertToMesh = [&mesh, tex, blockRegistry,
-		                     chunkPos](DefaultMeshVertex const* vertex,
+		auto insertToMesh = [&mesh, tex,
+		                     blockRegistry](DefaultMeshVertex const* vertex,
 		                               std::size_t vertexCount, BlockFace face,
 		                               const math::vec3& blockPos) {	
 			const TextureData* texData = nullptr;
@@ -76,23 +489,8 @@ std::vector<float> ChunkMesher::mesh(phx::voxels::Chunk*         chunk,
 			{
 				DefaultMeshVertex const* current = vertex + i;
 
-				mesh.push_back(current->pos.x +
-				               (blockPos.x * DEFAULT_MODEL_SIZE) +
-				               (chunkPos.x * DEFAULT_MODEL_SIZE));
-				mesh.push_back(current->pos.y +
-				               (blockPos.y * DEFAULT_MODEL_SIZE) +
-				               (chunkPos.y * DEFAULT_MODEL_SIZE));
-				mesh.push_back(current->pos.z +
-				               (blockPos.z * DEFAULT_MODEL_SIZE) +
-				               (chunkPos.z * DEFAULT_MODEL_SIZE));
-
-				mesh.push_back(texData->bottomLeftUV.x + (texData->uvSize.x * current->uv.x));
-				mesh.push_back(texData->bottomLeftUV.y + (texData->uvSize.y * current->uv.y));
-				mesh.push_back(texData->layer);
-
-				mesh.push_back(current->normal.x);
-				mesh.push_back(current->normal.y);
-				mesh.push_back(current->normal.z);
+				pushVertex(mesh, toMeshPosition(current, blockPos),
+				           current->uv, texData, current->normal);
 			}
 		};
 
@@ -114,126 +512,43 @@ std::vector<float> ChunkMesher::mesh(phx::voxels::Chunk*         chunk,
 		{
 		case BlockModel::BLOCK:
 		{
-			// check if block is on the north border of the chunk.
-			if (z == 0)
+			// add each face if the neighbour on that side is not a full
+			// block, blocks on the border are checked against the
+			// neighbouring chunk.
+			if (!lookup.isOpaque(x, y, z - 1))
 			{
-				// if on north border, add north face.
 				insertToMesh(BLOCK_FRONT, BLOCK_FACE_VERT_COUNT,
 				             BlockFace::NORTH, {x, y, z});
 			}
-			else
-			{
-				// else get the block to the north.
-				BlockType* north = blocks[Chunk::getVectorIndex(x, y, z - 1)];
-
-				// if the block to the north is not solid, or is not a full
-				// block, add the north face.
-				if (north->category != BlockCategory::SOLID ||
-				    *blockRegistry->models.get(north->uniqueIdentifier) !=
-				        BlockModel::BLOCK)
-				{
-					insertToMesh(BLOCK_FRONT, BLOCK_FACE_VERT_COUNT,
-					             BlockFace::NORTH, {x, y, z});
-				}
-			}
 
-			// check if the block is on the south border
-			if (z == Chunk::CHUNK_DEPTH - 1)
+			if (!lookup.isOpaque(x, y, z + 1))
 			{
 				insertToMesh(BLOCK_BACK, BLOCK_FACE_VERT_COUNT,
 				             BlockFace::SOUTH, {x, y, z});
 			}
-			else
-			{
-				// else get the block to the south.
-				BlockType* south = blocks[Chunk::getVectorIndex(x, y, z + 1)];
-
-				// if the block to the south is not solid, or is not a full
-				// block, add the south face.
-				if (south->category != BlockCategory::SOLID ||
-				    *blockRegistry->models.get(south->uniqueIdentifier) !=
-				        BlockModel::BLOCK)
-				{
-					insertToMesh(BLOCK_BACK, BLOCK_FACE_VERT_COUNT,
-					             BlockFace::SOUTH, {x, y, z});
-				}
-			}
 
-			// check if block is on the bottom border of the chunk.
-			if (y == 0)
+			if (!lookup.isOpaque(x, y - 1, z))
 			{
-				// if on bottom border, add bottom face.
 				insertToMesh(BLOCK_BOTTOM, BLOCK_FACE_VERT_COUNT,
 				             BlockFace::BOTTOM, {x, y, z});
 			}
-			else
-			{
-				// else get the block underneath.
-				BlockType* bottom = blocks[Chunk::getVectorIndex(x, y - 1, z)];
-
-				if (bottom->category != BlockCategory::SOLID ||
-				    *blockRegistry->models.get(bottom->uniqueIdentifier) !=
-				        BlockModel::BLOCK)
-				{
-					insertToMesh(BLOCK_BOTTOM, BLOCK_FACE_VERT_COUNT,
-					             BlockFace::BOTTOM, {x, y, z});
-				}
-			}
 
-			// check if the block is on the top border.
-			if (y == Chunk::CHUNK_HEIGHT - 1)
+			if (!lookup.isOpaque(x, y + 1, z))
 			{
-				insertToMesh(BLOCK_TOP, BLOCK_FACE_VERT_COUNT, BlockFace::TOP,
-				             {x, y, z});
+				insertToMesh(BLOCK_TOP, BLOCK_FACE_VERT_COUNT,
+				             BlockFace::TOP, {x, y, z});
 			}
-			else
-			{
-				// else get the block to the top of it.
-				BlockType* top = blocks[Chunk::getVectorIndex(x, y + 1, z)];
 
-				if (top->category != BlockCategory::SOLID ||
-				    *blockRegistry->models.get(top->uniqueIdentifier) !=
-				        BlockModel::BLOCK)
-				{
-					insertToMesh(BLOCK_TOP, BLOCK_FACE_VERT_COUNT,
-					             BlockFace::TOP, {x, y, z});
-				}
-			}
-
-			if (x == 0)
+			if (!lookup.isOpaque(x - 1, y, z))
 			{
 				insertToMesh(BLOCK_RIGHT, BLOCK_FACE_VERT_COUNT,
 				             BlockFace::EAST, {x, y, z});
 			}
-			else
-			{
-				BlockType* east = blocks[Chunk::getVectorIndex(x - 1, y, z)];
 
-				if (east->category != BlockCategory::SOLID ||
-				    *blockRegistry->models.get(east->uniqueIdentifier) !=
-				        BlockModel::BLOCK)
-				{
-					insertToMesh(BLOCK_RIGHT, BLOCK_FACE_VERT_COUNT,
-					             BlockFace::EAST, {x, y, z});
-				}
-			}
-
-			if (x == Chunk::CHUNK_WIDTH - 1)
+			if (!lookup.isOpaque(x + 1, y, z))
 			{
-				insertToMesh(BLOCK_LEFT, BLOCK_FACE_VERT_COUNT, BlockFace::WEST,
-				             {x, y, z});
-			}
-			else
-			{
-				BlockType* west = blocks[Chunk::getVectorIndex(x + 1, y, z)];
-
-				if (west->category != BlockCategory::SOLID ||
-				    *blockRegistry->models.get(west->uniqueIdentifier) !=
-				        BlockModel::BLOCK)
-				{
-					insertToMesh(BLOCK_LEFT, BLOCK_FACE_VERT_COUNT,
-					             BlockFace::WEST, {x, y, z});
-				}
+				insertToMesh(BLOCK_LEFT, BLOCK_FACE_VERT_COUNT,
+				             BlockFace::WEST, {x, y, z});
 			}
 		}
 		break;
@@ -295,24 +610,8 @@ std::vector<float> ChunkMesher::mesh(phx::voxels::Chunk*         chunk,
 				// we know the front of the slope is the first set of vertices.
 				DefaultMeshVertex const* current = SLOPE_FRONT + q;
 
-				mesh.push_back(current->pos.x + (x * DEFAULT_MODEL_SIZE) +
-				               (chunkPos.x * DEFAULT_MODEL_SIZE));
-
-				mesh.push_back(current->pos.y + (y * DEFAULT_MODEL_SIZE) +
-				               (chunkPos.y * DEFAULT_MODEL_SIZE));
-
-				mesh.push_back(current->pos.z + (z * DEFAULT_MODEL_SIZE) +
-				               (chunkPos.z * DEFAULT_MODEL_SIZE));
-
-				mesh.push_back(texData->bottomLeftUV.x +
-				               (texData->uvSize.x * current->uv.x));
-				mesh.push_back(texData->bottomLeftUV.y +
-				               (texData->uvSize.y * current->uv.y));
-				mesh.push_back(texData->layer);
-
-				mesh.push_back(current->normal.x);
-				mesh.push_back(current->normal.y);
-				mesh.push_back(current->normal.z);
+				pushVertex(mesh, toMeshPosition(current, {x, y, z}),
+				           current->uv, texData, current->normal);
 			}
 		}
 		break;
@@ -345,20 +644,8 @@ std::vector<float> ChunkMesher::mesh(phx::voxels::Chunk*         chunk,
 
 				phx::gfx::DefaultMeshVertex const* current = XPANEL_MESH + q;
 
-				mesh.push_back(current->pos.x + (x * DEFAULT_MODEL_SIZE) +
-				               (chunkPos.x * DEFAULT_MODEL_SIZE));
-				mesh.push_back(current->pos.y + (y * DEFAULT_MODEL_SIZE) +
-				               (chunkPos.y * DEFAULT_MODEL_SIZE));
-				mesh.push_back(current->pos.z + (z * DEFAULT_MODEL_SIZE) +
-				               (chunkPos.z * DEFAULT_MODEL_SIZE));
-
-				mesh.push_back(texData->bottomLeftUV.x + (texData->uvSize.x * current->uv.x));
-				mesh.push_back(texData->bottomLeftUV.y + (texData->uvSize.y * current->uv.y));
-				mesh.push_back(texData->layer);
-
-				mesh.push_back(current->normal.x);
-				mesh.push_back(current->normal.y);
-				mesh.push_back(current->normal.z);
+				pushVertex(mesh, toMeshPosition(current, {x, y, z}),
+				           current->uv, texData, current->normal);
 			}
 		}
 		break;
@@ -381,20 +668,8 @@ std::vector<float> ChunkMesher::mesh(phx::voxels::Chunk*         chunk,
 				phx::gfx::DefaultMeshVertex const* current =
 				    XPANEL_BLOCK_MESH + q;
 
-				mesh.push_back(current->pos.x + (x * DEFAULT_MODEL_SIZE) +
-				               (chunkPos.x * DEFAULT_MODEL_SIZE));
-				mesh.push_back(current->pos.y + (y * DEFAULT_MODEL_SIZE) +
-				               (chunkPos.y * DEFAULT_MODEL_SIZE));
-				mesh.push_back(current->pos.z + (z * DEFAULT_MODEL_SIZE) +
-				               (chunkPos.z * DEFAULT_MODEL_SIZE));
-
-				mesh.push_back(texData->bottomLeftUV.x + (texData->uvSize.x * current->uv.x));
-				mesh.push_back(texData->bottomLeftUV.y + (texData->uvSize.y * current->uv.y));
-				mesh.push_back(texData->layer);
-
-				mesh.push_back(current->normal.x);
-				mesh.push_back(current->normal.y);
-				mesh.push_back(current->normal.z);
+				pushVertex(mesh, toMeshPosition(current, {x, y, z}),
+				           current->uv, texData, current->normal);
 			}
 
 			for (std::size_t q = 0; q < XPANEL_BLOCK_BLOCK_VERT_COUNT; ++q)
@@ -414,22 +689,8 @@ std::vector<float> ChunkMesher::mesh(phx::voxels::Chunk*         chunk,
 				phx::gfx::DefaultMeshVertex const* current =
 				    XPANEL_BLOCK_BLOCK_MESH + q;
 
-				mesh.push_back(current->pos.x + (x * DEFAULT_MODEL_SIZE) +
-				               (chunkPos.x * DEFAULT_MODEL_SIZE));
-				mesh.push_back(current->pos.y + (y * DEFAULT_MODEL_SIZE) +
-				               (chunkPos.y * DEFAULT_MODEL_SIZE));
-				mesh.push_back(current->pos.z + (z * DEFAULT_MODEL_SIZE) +
-				               (chunkPos.z * DEFAULT_MODEL_SIZE));
-
-				mesh.push_back(texData->bottomLeftUV.x +
-				               (texData->uvSize.x * current->uv.x));
-				mesh.push_back(texData->bottomLeftUV.y +
-				               (texData->uvSize.y * current->uv.y));
-				mesh.push_back(texData->layer);
-
-				mesh.push_back(current->normal.x);
-				mesh.push_back(current->normal.y);
-				mesh.push_back(current->normal.z);
+				pushVertex(mesh, toMeshPosition(current, {x, y, z}),
+				           current->uv, texData, current->normal);
 			}
 		}
 		break;
@@ -441,3 +702,11 @@ std::vector<float> ChunkMesher::mesh(phx::voxels::Chunk*         chunk,
 
 	return mesh;
 }
+
+phx::voxels::ChunkVisibility ChunkMesher::getVisibility(
+    const phx::voxels::Chunk* chunk, phx::client::BlockRegistry* blockRegistry)
+{
+	const voxels::BlockStorage& blocks = chunk->getBlocks();
+	return voxels::ChunkVisibility::compute(
+	    blocks, resolveOpaque(blocks.getPalette(), blockRegistry));
+}
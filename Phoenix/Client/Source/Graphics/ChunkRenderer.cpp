@@ -26,25 +26,95 @@
 // ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
 // POSSIBILITY OF SUCH DAMAGE.
 
+#include <Client/Graphics/BaseBlockModels.hpp>
 #include <Client/Graphics/ChunkMesher.hpp>
 #include <Client/Graphics/ChunkRenderer.hpp>
 #include <Client/Graphics/OpenGLTools.hpp>
 
 #include <Common/Actor.hpp>
 #include <Common/PlayerView.hpp>
+#include <Common/Position.hpp>
 
 #include <glad/glad.h>
 
+#include <chrono>
+#include <cmath>
 #include <unordered_set>
 
 using namespace phx::gfx;
 
+namespace
+{
+	// the position of each neighbour relative to a chunk, indexed by the
+	// BlockFace it touches.
+	const phx::math::vec3 NEIGHBOUR_OFFSETS[] = {
+	    {0, 0, -phx::voxels::Chunk::CHUNK_DEPTH},
+	    {-phx::voxels::Chunk::CHUNK_WIDTH, 0, 0},
+	    {0, 0, phx::voxels::Chunk::CHUNK_DEPTH},
+	    {phx::voxels::Chunk::CHUNK_WIDTH, 0, 0},
+	    {0, phx::voxels::Chunk::CHUNK_HEIGHT, 0},
+	    {0, -phx::voxels::Chunk::CHUNK_HEIGHT, 0},
+	};
+
+	// a copy of a chunk and its loaded neighbours, so the originals can keep
+	// changing while the copy waits to be meshed.
+	struct MeshSnapshot
+	{
+		MeshSnapshot(const phx::voxels::Chunk& chunk,
+		             const ChunkNeighbours&    neighbours)
+		    : chunk(chunk)
+		{
+			for (std::size_t i = 0; i < neighbours.size(); ++i)
+			{
+				if (neighbours[i] != nullptr)
+				{
+					this->neighbours[i] =
+					    std::make_unique<phx::voxels::Chunk>(*neighbours[i]);
+				}
+			}
+		}
+
+		ChunkNeighbours getNeighbours() const
+		{
+			ChunkNeighbours pointers {};
+			for (std::size_t i = 0; i < neighbours.size(); ++i)
+			{
+				pointers[i] = neighbours[i].get();
+			}
+			return pointers;
+		}
+
+		phx::voxels::Chunk                                 chunk;
+		std::array<std::unique_ptr<phx::voxels::Chunk>, 6> neighbours;
+	};
+} // namespace
+
 ChunkRenderer::ChunkRenderer(phx::voxels::Map*           map,
                              phx::client::BlockRegistry* blockRegistry,
                              entt::registry* registry, entt::entity entity)
     : m_blockRegistry(blockRegistry), m_map(map), m_registry(registry),
-      m_entity(entity)
+      m_entity(entity),
+      m_greedyMeshing(
+          Settings::instance()->getOr("graphics:greedy_meshing", true)),
+      m_multiDraw(Settings::instance()->getOr("graphics:multi_draw", true)),
+      m_occlusionCulling(
+          Settings::instance()->getOr("graphics:occlusion_culling", true)),
+      m_uploadBudget(
+          Settings::instance()->getOr("graphics:mesh_upload_budget_us", 2000))
 {
+	m_meshingMode =
+	    m_greedyMeshing ? MeshingMode::GREEDY : MeshingMode::SIMPLE;
+
+	// with no threads chunks are meshed as soon as they're asked for, the
+	// uploads are still spread over frames.
+	const int meshThreads =
+	    Settings::instance()->getOr("graphics:mesh_threads", 2);
+	if (meshThreads > 0)
+	{
+		m_pool =
+		    std::make_unique<ThreadPool>(static_cast<std::size_t>(meshThreads));
+	}
+
 	// lets say you have a view distance of 10, so lets do 10x10x10 and
 	// just say you're gonna have 100 chunks in view at a time. you'll be
 	// able to have more obviously, but this is just a simple
@@ -52,6 +122,11 @@ ChunkRenderer::ChunkRenderer(phx::voxels::Map*           map,
 	m_chunks.reserve(100);
 	m_buffers.reserve(100);
 
+	using voxels::Chunk;
+	m_bounds.extent = {Chunk::CHUNK_WIDTH * DEFAULT_MODEL_SIZE + 4.f,
+	                   Chunk::CHUNK_HEIGHT * DEFAULT_MODEL_SIZE + 4.f,
+	                   Chunk::CHUNK_DEPTH * DEFAULT_MODEL_SIZE + 4.f};
+
 	glGenVertexArrays(1, &m_selectionBoxVAO);
 	glBindVertexArray(m_selectionBoxVAO);
 	glGenBuffers(1, &m_selectionBoxVBO);
@@ -69,7 +144,7 @@ std::vector<ShaderLayout> ChunkRenderer::getRequiredShaderLayout()
 {
 	std::vector<ShaderLayout> layout;
 	layout.emplace_back("a_Vertex", 0);
-	layout.emplace_back("a_UV", 1);
+	layout.emplace_back("a_ChunkPos", 1);
 
 	return layout;
 }
@@ -83,73 +158,99 @@ void ChunkRenderer::attachCamera(FPSCamera* camera) { m_camera = camera; }
 
 void ChunkRenderer::add(phx::voxels::Chunk* chunk)
 {
-	const auto it = std::find(m_chunks.begin(), m_chunks.end(), chunk);
-	if (it == m_chunks.end())
-	{
-		m_chunks.push_back(chunk);
-	}
-	else
+	if (!m_chunks.emplace(chunk->getChunkPos(), chunk).second)
 	{
 		// chunk already exists, lets do nothing.
 		return;
 	}
 
-	auto mesh = ChunkMesher::mesh(chunk, m_blockRegistry);
-	if (mesh.empty())
+	// the neighbours kept the faces towards this chunk while it wasn't
+	// loaded, even if this chunk ends up with an empty mesh.
+	updateNeighbours(chunk->getChunkPos(),
+	                 {true, true, true, true, true, true});
+
+	requestMesh(chunk);
+}
+
+void ChunkRenderer::update(phx::voxels::Chunk* chunk)
+{
+	if (m_chunks.find(chunk->getChunkPos()) == m_chunks.end())
 	{
-		// the mesh is empty, don't bother with adding it or anything.
+		// add a chunk if not exists for compatibility.
+		add(chunk);
 		return;
 	}
 
-	unsigned int vao;
-	unsigned int buf;
+	requestMesh(chunk);
+}
 
-	glGenVertexArrays(1, &vao);
-	glBindVertexArray(vao);
+void ChunkRenderer::requestMesh(phx::voxels::Chunk* chunk)
+{
+	auto& latest = m_meshVersions[chunk->getChunkPos()];
+	if (latest == nullptr)
+	{
+		latest = std::make_shared<std::atomic<std::size_t>>(0);
+	}
+
+	// versions are never reused, so a chunk that's removed and added again
+	// can't pick up a mesh from before it was removed.
+	const std::size_t version = ++m_lastMeshVersion;
+	latest->store(version);
 
-	glGenBuffers(1, &buf);
-	glBindBuffer(GL_ARRAY_BUFFER, buf);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(float) * mesh.size(), mesh.data(),
-	             GL_DYNAMIC_DRAW);
+	// until it's meshed, the chunk is treated as if it can be seen through
+	// so nothing behind it disappears.
+	m_visibility.emplace(chunk->getChunkPos(), voxels::ChunkVisibility::all());
 
-	glVertexAttribPointer(m_vertexAttributeLocation, 3, GL_FLOAT, GL_FALSE,
-	                      sizeof(Vertex),
-	                      reinterpret_cast<void*>(offsetof(Vertex, pos)));
+	auto snapshot =
+	    std::make_shared<MeshSnapshot>(*chunk,
+	                               getNeighbours(chunk->getChunkPos()));
 
-	// we're gonna pack texLayer into the UV struct cos why not.
-	glVertexAttribPointer(m_uvAttributeLocation, 3, GL_FLOAT, GL_FALSE,
-	                      sizeof(Vertex),
-	                      reinterpret_cast<void*>(offsetof(Vertex, uv)));
+	auto job = [this, latest, version, snapshot, mode = m_meshingMode]() {
+		// don't bother meshing if a newer mesh has been asked for already.
+		if (*latest != version)
+		{
+			return;
+		}
 
-	glVertexAttribPointer(
-	    m_normalAttributeLocation, 3, GL_FLOAT, GL_TRUE, sizeof(Vertex),
-	    reinterpret_cast<void*>(offsetof(Vertex, normal)));
+		MeshResult result;
+		result.pos     = snapshot->chunk.getChunkPos();
+		result.version = version;
+		result.mesh    = ChunkMesher::mesh(&snapshot->chunk, m_blockRegistry,
+		                                   mode, snapshot->getNeighbours());
+		result.visibility =
+		    ChunkMesher::getVisibility(&snapshot->chunk, m_blockRegistry);
 
-	glEnableVertexAttribArray(m_vertexAttributeLocation);
-	glEnableVertexAttribArray(m_uvAttributeLocation);
-	glEnableVertexAttribArray(m_normalAttributeLocation);
+		m_meshed.push(std::move(result));
+	};
 
-	m_buffers.insert({chunk->getChunkPos(), {vao, buf, mesh.size()}});
+	if (m_pool == nullptr)
+	{
+		job();
+	}
+	else
+	{
+		m_pool->push(job);
+	}
 }
 
-void ChunkRenderer::update(phx::voxels::Chunk* chunk)
+void ChunkRenderer::upload(const MeshResult& result)
 {
-	const auto it = std::find(m_chunks.begin(), m_chunks.end(), chunk);
-	if (it == m_chunks.end())
+	// the chunk was meshed again or removed since this was requested.
+	const auto latest = m_meshVersions.find(result.pos);
+	if (latest == m_meshVersions.end() || *latest->second != result.version)
 	{
-		// add a chunk if not exists for compatibility.
-		add(chunk);
 		return;
 	}
 
-	auto mesh = ChunkMesher::mesh(chunk, m_blockRegistry);
+	m_visibility[result.pos] = result.visibility;
+
+	const std::vector<Vertex>& mesh = result.mesh;
 
 	// we can't just say return if the mesh is empty, since we might be emptying
 	// a mesh (breaking the final block in a chunk so only air is left or
 	// something)
 
-	ChunkRenderData data;
-	auto            bufferExist = m_buffers.find(chunk->getChunkPos());
+	auto bufferExist = m_buffers.find(result.pos);
 	if (bufferExist == m_buffers.end())
 	{
 		// data does not exist on GPU, we gotta make it.
@@ -159,88 +260,204 @@ void ChunkRenderer::update(phx::voxels::Chunk* chunk)
 			return;
 		}
 
-		glGenVertexArrays(1, &data.vao);
-		glBindVertexArray(data.vao);
-
-		glGenBuffers(1, &data.buffer);
-		glBindBuffer(GL_ARRAY_BUFFER, data.buffer);
-
-		glBufferData(GL_ARRAY_BUFFER, sizeof(float) * mesh.size(), mesh.data(),
-		             GL_DYNAMIC_DRAW);
+		bufferExist = m_buffers.insert({result.pos, ChunkRenderData()}).first;
+	}
 
-		glVertexAttribPointer(m_vertexAttributeLocation, 3, GL_FLOAT, GL_FALSE,
-		                      sizeof(Vertex),
-		                      reinterpret_cast<void*>(offsetof(Vertex, pos)));
+	// the arena keeps the mesh where it is if it still fits.
+	m_arena.write(bufferExist->second.range, mesh);
+	bufferExist->second.vertexCount = mesh.size();
 
-		// we're gonna pack texLayer into the UV struct cos why not.
-		glVertexAttribPointer(m_uvAttributeLocation, 3, GL_FLOAT, GL_FALSE,
-		                      sizeof(Vertex),
-		                      reinterpret_cast<void*>(offsetof(Vertex, uv)));
+	if (mesh.empty())
+	{
+		m_buffers.erase(bufferExist);
+	}
+}
 
-		glVertexAttribPointer(
-		    m_normalAttributeLocation, 3, GL_FLOAT, GL_TRUE, sizeof(Vertex),
-		    reinterpret_cast<void*>(offsetof(Vertex, normal)));
+ChunkNeighbours ChunkRenderer::getNeighbours(const math::vec3& pos) const
+{
+	ChunkNeighbours neighbours {};
+	for (std::size_t i = 0; i < neighbours.size(); ++i)
+	{
+		// only look at loaded chunks, asking for any other would load it.
+		const math::vec3 neighbour = pos + NEIGHBOUR_OFFSETS[i];
+		if (m_map->getChunkState(neighbour) == voxels::ChunkState::LOADED)
+		{
+			neighbours[i] = m_map->getChunk(neighbour);
+		}
+	}
 
-		glEnableVertexAttribArray(m_vertexAttributeLocation);
-		glEnableVertexAttribArray(m_uvAttributeLocation);
-		glEnableVertexAttribArray(m_normalAttributeLocation);
+	return neighbours;
+}
 
-		data.vertexCount = mesh.size();
-		m_buffers.insert({chunk->getChunkPos(), data});
-	}
-	else
+void ChunkRenderer::updateNeighbours(const math::vec3&          pos,
+                                     const std::array<bool, 6>& faces)
+{
+	const ChunkNeighbours neighbours = getNeighbours(pos);
+	for (std::size_t i = 0; i < neighbours.size(); ++i)
 	{
-		// buffer already exists.
-		glBindVertexArray(bufferExist->second.vao);
-		glBindBuffer(GL_ARRAY_BUFFER, bufferExist->second.buffer);
-
-		if (mesh.size() == bufferExist->second.vertexCount)
+		if (!faces[i] || neighbours[i] == nullptr)
 		{
-			// if the vertex count is the same, don't reallocate the buffer,
-			// just change the value - will save expensive reallocation.
-			glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(float) * mesh.size(),
-			                mesh.data());
+			continue;
 		}
-		else
-		{
-			glBufferData(GL_ARRAY_BUFFER, sizeof(float) * mesh.size(),
-			             mesh.data(), GL_DYNAMIC_DRAW);
 
-			bufferExist->second.vertexCount = mesh.size();
+		// a neighbour that isn't rendered yet is meshed when it's added.
+		const auto it = m_chunks.find(neighbours[i]->getChunkPos());
+		if (it != m_chunks.end())
+		{
+			update(it->second);
 		}
 	}
 }
 
 void ChunkRenderer::remove(phx::voxels::Chunk* chunk)
 {
-	const auto it = std::find(m_chunks.begin(), m_chunks.end(), chunk);
+	const auto it = m_chunks.find(chunk->getChunkPos());
 	if (it != m_chunks.end())
 	{
 		// chunks is found, lets do something.
 
-		// delete the opengl buffers.
-		const auto buffer = m_buffers.find((*it)->getChunkPos());
+		// give the mesh back to the arena.
+		const auto buffer = m_buffers.find(it->first);
 		if (buffer != m_buffers.end())
 		{
-			glDeleteBuffers(1, &buffer->second.buffer);
-			glDeleteVertexArrays(1, &buffer->second.vao);
+			m_arena.free(buffer->second.range);
+		}
+
+		// any mesh still being made for it is no longer needed.
+		const auto latest = m_meshVersions.find(it->first);
+		if (latest != m_meshVersions.end())
+		{
+			latest->second->store(0);
+			m_meshVersions.erase(latest);
 		}
 
 		// remove the buffer and chunk from internal memory.
-		m_buffers.erase((*it)->getChunkPos());
+		m_visibility.erase(it->first);
+		m_buffers.erase(it->first);
 		m_chunks.erase(it);
 	}
 }
 
+void ChunkRenderer::unloadOutOfRange()
+{
+	std::vector<voxels::Chunk*> outOfRange;
+	for (auto& chunk : m_chunks)
+	{
+		if (!PlayerView::isInRange(m_registry, m_entity, chunk.first))
+		{
+			outOfRange.push_back(chunk.second);
+		}
+	}
+
+	std::vector<math::vec3> removed;
+	removed.reserve(outOfRange.size());
+	for (voxels::Chunk* chunk : outOfRange)
+	{
+		removed.push_back(chunk->getChunkPos());
+		remove(chunk);
+	}
+
+	// nothing points at them anymore, so the map can let go of them too.
+	// this also catches chunks that finished loading after the player had
+	// already moved on.
+	m_map->unloadChunks([this](const math::vec3& pos) {
+		return PlayerView::isInRange(m_registry, m_entity, pos);
+	});
+
+	// the faces towards the unloaded chunks have to come back.
+	for (const math::vec3& pos : removed)
+	{
+		updateNeighbours(pos, {true, true, true, true, true, true});
+	}
+}
+
 void ChunkRenderer::clear()
 {
 	for (auto& buffer : m_buffers)
 	{
-		glDeleteBuffers(1, &buffer.second.buffer);
-		glDeleteVertexArrays(1, &buffer.second.vao);
+		m_arena.free(buffer.second.range);
+	}
+
+	m_buffers.clear();
+}
+
+void ChunkRenderer::addDraw(const math::vec3&      pos,
+                            const ChunkRenderData& data)
+{
+	// meshes are relative to their chunk.
+	m_draws.push_back({data.range, data.vertexCount, pos * DEFAULT_MODEL_SIZE});
+}
+
+void ChunkRenderer::addDrawsInView(const math::Frustum& frustum)
+{
+	m_bounds.clear();
+	for (auto& buffer : m_buffers)
+	{
+		m_bounds.push(getBoundsMin(buffer.first));
+	}
+
+	frustum.cull(m_bounds, m_visible);
+
+	std::size_t i = 0;
+	for (auto& buffer : m_buffers)
+	{
+		if (m_visible[i++] != 0)
+		{
+			addDraw(buffer.first, buffer.second);
+		}
+	}
+}
+
+bool ChunkRenderer::addVisibleDraws(const math::Frustum& frustum)
+{
+	// the camera's position is in model units, see PlayerView.
+	const math::vec3 block =
+	    m_registry->get<Position>(m_entity).position / 2.f + 0.5f;
+
+	using voxels::Chunk;
+	const math::vec3 start = {
+	    std::floor(block.x / Chunk::CHUNK_WIDTH) * Chunk::CHUNK_WIDTH,
+	    std::floor(block.y / Chunk::CHUNK_HEIGHT) * Chunk::CHUNK_HEIGHT,
+	    std::floor(block.z / Chunk::CHUNK_DEPTH) * Chunk::CHUNK_DEPTH};
+
+	const auto lookup =
+	    [this](const math::vec3& pos) -> const voxels::ChunkVisibility* {
+		const auto it = m_visibility.find(pos);
+		return it == m_visibility.end() ? nullptr : &it->second;
+	};
+
+	const auto inView = [this, &frustum](const math::vec3& pos) {
+		const math::vec3 min = getBoundsMin(pos);
+		return frustum.intersects(min, min + m_bounds.extent);
+	};
+
+	if (!voxels::ChunkVisibility::findVisible(start, lookup, inView,
+	                                          m_visibleChunks))
+	{
+		return false;
+	}
+
+	for (const math::vec3& pos : m_visibleChunks)
+	{
+		// chunks with nothing to draw don't have a buffer.
+		const auto buffer = m_buffers.find(pos);
+		if (buffer != m_buffers.end())
+		{
+			addDraw(buffer->first, buffer->second);
+		}
 	}
+
+	return true;
 }
 
+phx::math::vec3 ChunkRenderer::getBoundsMin(const math::vec3& pos)
+{
+	// parts of blocks can stick out of the chunk by up to 2 units.
+	return pos * DEFAULT_MODEL_SIZE - math::vec3 {2.f, 2.f, 2.f};
+}
+
+const ChunkRenderStats& ChunkRenderer::getStats() const { return m_stats; }
+
 void ChunkRenderer::onMapEvent(const phx::voxels::MapEvent& mapEvent)
 {
 	m_mapEvents.push(mapEvent);
@@ -248,6 +465,17 @@ void ChunkRenderer::onMapEvent(const phx::voxels::MapEvent& mapEvent)
 
 void ChunkRenderer::tick(float dt)
 {
+	const MeshingMode mode =
+	    m_greedyMeshing ? MeshingMode::GREEDY : MeshingMode::SIMPLE;
+	if (mode != m_meshingMode)
+	{
+		m_meshingMode = mode;
+		for (auto& chunk : m_chunks)
+		{
+			requestMesh(chunk.second);
+		}
+	}
+
 	for (auto& chunk : PlayerView::update(m_registry, m_entity))
 	{
 		add(chunk);
@@ -258,17 +486,70 @@ void ChunkRenderer::tick(float dt)
 	{
 		if (e.type == voxels::MapEvent::CHUNK_UPDATE)
 		{
-			update(std::get<voxels::Chunk*>(e.data));
+			voxels::Chunk* chunk = std::get<voxels::Chunk*>(e.data);
+			update(chunk);
+
+			// only the neighbours sharing a border with the block can have
+			// changed.
+			using voxels::Chunk;
+			updateNeighbours(
+			    chunk->getChunkPos(), {e.position.z == 0, e.position.x == 0,
+			            e.position.z == Chunk::CHUNK_DEPTH - 1,
+			            e.position.x == Chunk::CHUNK_WIDTH - 1,
+			            e.position.y == Chunk::CHUNK_HEIGHT - 1,
+			            e.position.y == 0});
 		}
 	}
-	
+
+	// the map events are handled first, so none of them can be left
+	// pointing at a chunk that's unloaded here.
+	if (!PlayerView::evict(m_registry, m_entity).empty())
+	{
+		unloadOutOfRange();
+	}
+
+	// only spend so long uploading each frame, anything left over is
+	// uploaded on the next one.
+	using Clock            = std::chrono::steady_clock;
+	const Clock::time_point start = Clock::now();
+	const std::chrono::microseconds budget(static_cast<int>(m_uploadBudget));
+
+	MeshResult result;
+	while (Clock::now() - start < budget && m_meshed.try_pop(result))
+	{
+		upload(result);
+	}
+
 	m_blockRegistry->texturePacker.activate(0);
 
-	for (auto& buffer : m_buffers)
+	m_draws.clear();
+	if (m_camera == nullptr)
 	{
-		glBindVertexArray(buffer.second.vao);
-		glDrawArrays(GL_TRIANGLES, 0, buffer.second.vertexCount);
+		for (auto& buffer : m_buffers)
+		{
+			addDraw(buffer.first, buffer.second);
+		}
 	}
+	else
+	{
+		const math::Frustum frustum(m_camera->getProjection() *
+		                            m_camera->calculateViewMatrix());
+
+		// occlusion culling needs the chunk the camera is in to be known,
+		// otherwise it's only the chunks out of view that are skipped.
+		if (!m_occlusionCulling || !addVisibleDraws(frustum))
+		{
+			addDrawsInView(frustum);
+		}
+	}
+
+	m_stats.drawn  = m_draws.size();
+	m_stats.culled = m_buffers.size() - m_draws.size();
+
+	m_stats.drawCalls = m_arena.draw(m_draws, m_multiDraw);
+	m_stats.meshMemory = m_arena.getUsedVertices() * sizeof(Vertex);
+
+	m_arena.endFrame();
 
 	// we shouldn't render the selection box in here since you might be
 	// spectating. the box should really be a thing the player stuff renders.
@@ -282,17 +563,15 @@ void ChunkRenderer::renderSelectionBox()
 		return;
 	}
 
-	auto pos =
-	    ActorSystem::getTarget(m_registry, m_entity).getCurrentPosition();
-	pos.floor();
 	// do not waste cpu time if we aren't targeting a solid block
-	if (m_registry->get<PlayerView>(m_entity)
-	        .map->getBlockAt(pos)
-	        .type->category != voxels::BlockCategory::SOLID)
+	const math::RayHit target = ActorSystem::getTarget(m_registry, m_entity);
+	if (!target.hit)
 	{
 		return;
 	}
 
+	math::vec3 pos(target.block);
+
 	// voxel position to camera position
 	pos.x = (pos.x - 0.5f) * 2.f;
 	pos.y = (pos.y - 0.5f) * 2.f;
@@ -272,7 +272,7 @@ void TexturePacker::pack()
 
 	// don't wrap this in GLCheck because we want to manually check for an out
 	// of memory error.
-	glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, 1024, 1024,
+	glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, LAYER_SIZE, LAYER_SIZE,
 	             static_cast<int>(layersNeeded), 0, GL_RGBA, GL_UNSIGNED_BYTE,
 	             nullptr);
 
@@ -302,13 +302,13 @@ void TexturePacker::pack()
 		while (!size.second.empty())
 		{
 			for (std::size_t y = 0;
-			     y < 1024 / static_cast<std::size_t>(size.first); ++y)
+			     y < LAYER_SIZE / static_cast<std::size_t>(size.first); ++y)
 			{
 				if (size.second.empty())
 					break;
 
 				for (std::size_t x = 0;
-				     x < 1024 / static_cast<std::size_t>(size.first); ++x)
+				     x < LAYER_SIZE / static_cast<std::size_t>(size.first); ++x)
 				{
 					if (size.second.empty())
 						break;
@@ -348,8 +348,8 @@ void TexturePacker::pack()
 						size.second.back().first,
 						{
 							layer,
-							{static_cast<float>(posX) / 1024.f, static_cast<float>(posY) / 1024.f},
-							{static_cast<float>(size.first) / 1024.f, static_cast<float>(size.first) / 1024.f}
+							{static_cast<float>(posX) / LAYER_SIZE, static_cast<float>(posY) / LAYER_SIZE},
+							{static_cast<float>(size.first) / LAYER_SIZE, static_cast<float>(size.first) / LAYER_SIZE}
 						}
 					});
 					// clang-format on
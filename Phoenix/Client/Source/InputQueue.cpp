@@ -101,10 +101,7 @@ InputState InputQueue::getCurrentState()
 		input.up       = InputMap::get()->getState(m_up);
 		input.down     = InputMap::get()->getState(m_down);
 	}
-	input.rotation.x = static_cast<int>(
-	    m_registry->get<Position>(m_player).rotation.x * 360000.0);
-	input.rotation.y = static_cast<int>(
-	    m_registry->get<Position>(m_player).rotation.y * 360000.0);
+	input.setRotation(m_registry->get<Position>(m_player).rotation);
 	input.sequence = m_sequence;
 	return input;
 }
@@ -29,12 +29,21 @@
 #include <Client/Network.hpp>
 
 #include <Common/Logger.hpp>
+#include <Common/Settings.hpp>
+#include <Common/Utility/Compression.hpp>
 #include <Common/Voxels/Chunk.hpp>
 
+#include <algorithm>
+
 using namespace phx::client;
 
 Network::Network(const phx::net::Address& address)
 {
+	const int redundancy =
+	    Settings::instance()->getOr("network:input_redundancy", 5);
+	m_inputRedundancy = std::clamp<std::size_t>(
+	    redundancy > 0 ? redundancy : 1, 1, phx::InputBatch::MAX_STATES);
+
 	m_client = new phx::net::Host();
 
 	m_client->onReceive([this](phx::net::Peer& peer, phx::net::Packet&& packet,
@@ -63,7 +72,8 @@ Network::Network(const phx::net::Address& address)
 		std::cout << "Server disconnected";
 	});
 
-	m_client->connect(address, 4);
+	// tell the server which codecs chunks can be compressed with.
+	m_client->connect(address, 4, data::Compression::getSupportedCodecs());
 	m_client->poll(5000_ms);
 }
 
@@ -102,33 +112,36 @@ void Network::parseEvent(phx::net::Packet& packet)
 
 void Network::parseState(phx::net::Packet& packet)
 {
-	auto data = packet.getData();
-
 	phx::Serializer ser;
-	ser.setBuffer(data.data(), packet.getSize());
+	ser.setView(packet.getRawData(), packet.getSize());
 
-	std::size_t sequence;
-	ser >> sequence;
-	if (sequence < m_currentSequence && sequence > 10)
+	// snapshots that arrive late, or against a baseline we never got, are
+	// dropped and the server keeps sending against the last one we have.
+	if (!m_snapshots.read(ser))
 	{
 		return;
 	}
-	m_currentSequence = sequence;
 
-	Position input;
-	ser >> input.position.x >> input.position.y >> input.position.z;
+	const phx::net::Snapshot* snapshot = m_snapshots.getLatest();
+	m_acknowledged = snapshot->tick;
+
+	const phx::net::EntityState* self = snapshot->find(snapshot->self);
+	if (self == nullptr)
+	{
+		return;
+	}
 
-	stateQueue.push(std::pair(input, sequence));
+	const std::size_t sequence = BitReader::unwrapSequence(
+	    static_cast<std::uint16_t>(snapshot->sequence), m_latestSequence);
+	stateQueue.push(std::pair(self->dequantize(), sequence));
 }
 
 void Network::parseMessage(phx::net::Packet& packet)
 {
 	std::string input;
 
-	auto data = packet.getData();
-
 	phx::Serializer ser;
-	ser.setBuffer(reinterpret_cast<std::byte*>(data.data()), data.size());
+	ser.setView(packet.getRawData(), packet.getSize());
 	ser >> input;
 
 	messageQueue.push(input);
@@ -136,34 +149,47 @@ void Network::parseMessage(phx::net::Packet& packet)
 
 void Network::parseData(phx::net::Packet& packet)
 {
-	auto data = packet.getData();
+	data::Data chunk;
+	if (data::Compression::decompress(packet.getRawData(), packet.getSize(),
+	                                  chunk) != data::FrameStatus::OK)
+	{
+		LOG_WARNING("NETWORK") << "Received a damaged chunk, dropping it.";
+		return;
+	}
 
 	math::vec3 pos;
-	
+
 	phx::Serializer ser;
-	ser.setBuffer(reinterpret_cast<std::byte*>(data.data()), sizeof(float) * 3);
+	ser.setView(chunk.data(), sizeof(float) * 3);
 	ser >> pos.x >> pos.y >> pos.z;
 
-	chunkQueue.push({pos, data});
+	chunkQueue.push({pos, std::move(chunk)});
 }
 
 void Network::sendState(const phx::InputState& inputState)
 {
-	Serializer ser;
-	ser << inputState;
+	m_latestSequence = inputState.sequence;
+	m_sentStates.states.insert(m_sentStates.states.begin(), inputState);
+	if (m_sentStates.states.size() > m_inputRedundancy)
+	{
+		m_sentStates.states.pop_back();
+	}
+
+	Serializer ser(phx::net::Packet::acquireBuffer());
+	ser << m_sentStates << m_acknowledged.load();
 
-	phx::net::Packet packet =
-	    phx::net::Packet(ser.getBuffer(), phx::net::PacketFlags::UNRELIABLE);
+	phx::net::Packet packet = phx::net::Packet(
+	    std::move(ser.getBuffer()), phx::net::PacketFlags::UNRELIABLE);
 
 	m_client->broadcast(packet, 1);
 }
 
 void Network::sendMessage(const std::string& message)
 {
-	Serializer ser;
+	Serializer ser(phx::net::Packet::acquireBuffer());
 	ser << message;
-	phx::net::Packet packet =
-	    phx::net::Packet(ser.getBuffer(), phx::net::PacketFlags::RELIABLE);
+	phx::net::Packet packet = phx::net::Packet(
+	    std::move(ser.getBuffer()), phx::net::PacketFlags::RELIABLE);
 	m_client->broadcast(packet, 2);
 
 	messageQueue.push(message);
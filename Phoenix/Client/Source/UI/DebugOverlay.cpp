@@ -74,6 +74,12 @@ void DebugOverlay::tick(float dt)
 		ImGui::Text("Frame Time: %.2f ms/frame\n", dt * 1000.f);
 		ImGui::Text("FPS: %d\n", static_cast<int>(1.f / dt));
 
+		for (const auto& statistic : m_statistics)
+		{
+			ImGui::Text("%s: %zu\n", statistic.first.c_str(),
+			            statistic.second);
+		}
+
 		ImGui::SliderInt("Debug Sample Rate", &m_sampleRate, 1, 60);
 		ImGui::Checkbox("Pause Debug Graph", &m_pauseSampling);
 
@@ -92,3 +98,8 @@ void DebugOverlay::tick(float dt)
 	if (m_time >= 3600)
 		m_time = 0;
 }
+
+void DebugOverlay::setStatistic(const std::string& name, std::size_t value)
+{
+	m_statistics[name] = value;
+}
@@ -29,6 +29,7 @@
 #include <Client/UI/GameTools.hpp>
 
 #include <Common/Actor.hpp>
+#include <Common/PlayerView.hpp>
 #include <Common/Position.hpp>
 
 #include <imgui.h>
@@ -60,6 +61,20 @@ void GameTools::tick(float dt)
 		            m_registry->get<Position>(m_player).position.x,
 		            m_registry->get<Position>(m_player).position.y,
 		            m_registry->get<Position>(m_player).position.z);
+
+		const voxels::Map* map = m_registry->get<PlayerView>(m_player).map;
+
+		const voxels::ChunkIOStats stats = map->getIOStats();
+
+		ImGui::Text("Chunks Queued: %zu\nChunks Pending: %zu\n"
+		            "Chunks Completed: %zu\nChunks Published: %zu",
+		            stats.queued, stats.pending, stats.completed,
+		            stats.published);
+		ImGui::Text("Chunk Latency: %.2f ms (avg %.2f ms, max %.2f ms)",
+		            stats.lastLatency, stats.averageLatency,
+		            stats.maxLatency);
+		ImGui::Text("Chunks Loaded: %zu (%zu KiB)",
+		            map->getLoadedChunkCount(), map->getMemoryUsage() / 1024);
 	}
 	ImGui::End();
 }
@@ -57,12 +57,11 @@ void HUD::tick(float dt)
 	ImGui::Begin("HUD", nullptr,
 	             ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_NoMove);
 	{
-		auto target =
-		    ActorSystem::getTarget(m_registry, m_player).getCurrentPosition();
-		target.floor();
-		auto targetBlock = map->getBlockAt(target).type;
-		if (targetBlock->category == voxels::BlockCategory::SOLID)
+		const math::RayHit target =
+		    ActorSystem::getTarget(m_registry, m_player);
+		if (target.hit)
 		{
+			auto targetBlock = map->getBlockAt(math::vec3(target.block)).type;
 			ImGui::Text("%s", targetBlock->displayName.c_str());
 		}
 		else
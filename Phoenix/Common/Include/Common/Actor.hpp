@@ -34,6 +34,7 @@
  */
 
 #include <Common/Input.hpp>
+#include <Common/Math/Ray.hpp>
 #include <Common/Voxels/Block.hpp>
 #include <Common/Voxels/BlockReferrer.hpp>
 #include <Common/Voxels/Item.hpp>
@@ -43,6 +44,8 @@
 
 #include <entt/entt.hpp>
 
+#include <vector>
+
 namespace phx
 {
 	/**
@@ -83,8 +86,30 @@ namespace phx
 		static constexpr float m_reach    = 32.f;
 		static constexpr bool  m_creative = false;
 
-		static math::Ray    getTarget(entt::registry* registry,
+		/**
+		 * @brief Gets the block an actor is looking at.
+		 *
+		 * @param registry The registry the actor is in.
+		 * @param entity The actor, it needs a PlayerView to see the map.
+		 * @return The first solid block within reach, if any.
+		 */
+		static math::RayHit getTarget(entt::registry* registry,
 		                              entt::entity    entity);
+
+		/**
+		 * @brief Gets the block each of a group of actors is looking at.
+		 *
+		 * @param registry The registry the actors are in.
+		 * @param entities The actors, they need a PlayerView to see the map.
+		 * @return What each actor is looking at, in the same order.
+		 *
+		 * This is cheaper than calling getTarget for each actor, like when
+		 * checking the interactions of every player on a server each tick.
+		 */
+		static std::vector<math::RayHit> getTargets(
+		    entt::registry*                  registry,
+		    const std::vector<entt::entity>& entities);
+
 		static entt::entity registerActor(entt::registry* registry);
 		static void         tick(entt::registry* registry, entt::entity entity,
 		                         float dt, const InputState& input);
@@ -31,6 +31,7 @@
 #include <Common/Math/Math.hpp>
 #include <Common/Utility/Serializer.hpp>
 #include <cstddef>
+#include <vector>
 
 namespace phx
 {
@@ -44,6 +45,11 @@ namespace phx
 		InputState(InputState&& other)                 = default;
 		InputState& operator=(InputState&& other)      = default;
 
+		/// @brief How many inputs a client sends a second. The server
+		/// applies one a step, so both sides move actors by 1 / RATE
+		/// seconds an input however often the server ticks.
+		static constexpr unsigned int RATE = 20;
+
 		bool forward  = false;
 		bool backward = false;
 		bool left     = false;
@@ -51,10 +57,51 @@ namespace phx
 		bool up       = false;
 		bool down     = false;
 
-		math::vec3i rotation; // in 1/1000 degrees
+		/// @brief How many bits the yaw and pitch are quantized to.
+		static constexpr unsigned int ROTATION_BITS = 16;
+
+		/// @brief The yaw and pitch, as steps of ROTATION_BITS.
+		math::vec3i rotation;
 
+		/// @brief Only the lowest 16 bits are sent, the receiver recovers
+		/// the rest with BitReader::unwrapSequence().
 		std::size_t sequence = 0;
 
+		/**
+		 * @brief Sets the rotation, quantized to what is sent so the client
+		 * predicts with exactly what the server receives.
+		 * @param rotation The yaw and pitch in radians.
+		 */
+		void setRotation(const math::vec3& rotation);
+
+		/**
+		 * @brief Gets the rotation.
+		 * @return The yaw between 0 and 2pi, and the pitch between -pi/2
+		 * and pi/2.
+		 */
+		math::vec3 getRotation() const;
+
+		Serializer& operator>>(Serializer& serializer) const override;
+		Serializer& operator<<(Serializer& serializer) override;
+	};
+
+	/**
+	 * @brief The most recent input states, sent together so a lost packet is
+	 * covered by the ones after it.
+	 *
+	 * The newest state is written in full, every older one as what changed
+	 * from the state after it. Held keys and a still mouse cost a single
+	 * byte per state. Sequences are wrapped to 16 bits like they are for a
+	 * single InputState.
+	 */
+	struct InputBatch : ISerializable
+	{
+		/// @brief The most states a batch can carry.
+		static constexpr std::size_t MAX_STATES = 32;
+
+		/// @brief The states, newest first with decreasing sequences.
+		std::vector<InputState> states;
+
 		Serializer& operator>>(Serializer& serializer) const override;
 		Serializer& operator<<(Serializer& serializer) override;
 	};
@@ -0,0 +1,117 @@
+// Copyright 2019-20 Genten Studios
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors
+// may be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <Common/Math/Matrix4x4.hpp>
+#include <Common/Math/Vector3.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace phx::math
+{
+	/**
+	 * @brief Boxes that all have the same size, stored one component at a
+	 * time so a whole list can be tested against a Frustum at once.
+	 */
+	struct PackedBoxes
+	{
+		using vec3 = detail::Vector3<float>;
+
+		/// @brief The minimum corner of every box.
+		std::vector<float> x;
+		std::vector<float> y;
+		std::vector<float> z;
+
+		/// @brief The size of every box.
+		vec3 extent;
+
+		void        push(const vec3& min);
+		void        clear();
+		std::size_t size() const;
+	};
+
+	/**
+	 * @brief The six planes bounding what a camera can see.
+	 *
+	 * @paragraph Usage
+	 * @code
+	 * Frustum frustum(camera->getProjection() *
+	 *                 camera->calculateViewMatrix());
+	 *
+	 * if (frustum.intersects(min, max))
+	 * {
+	 *     // draw it.
+	 * }
+	 * @endcode
+	 */
+	class Frustum
+	{
+		using vec3 = detail::Vector3<float>;
+
+	public:
+		/**
+		 * @brief Constructs a frustum that contains everything.
+		 */
+		Frustum();
+
+		/**
+		 * @brief Extracts the frustum from a matrix.
+		 * @param viewProjection The projection matrix multiplied by the
+		 * view matrix, the frustum is then in world space.
+		 */
+		explicit Frustum(const detail::Matrix4x4& viewProjection);
+
+		/**
+		 * @brief Checks whether a box is at least partly inside the frustum.
+		 * @param min The minimum corner of the box.
+		 * @param max The maximum corner of the box.
+		 * @return false if the box is completely outside.
+		 *
+		 * Boxes near the corners of the frustum can be reported as inside
+		 * when they aren't, which is fine for culling.
+		 */
+		bool intersects(const vec3& min, const vec3& max) const;
+
+		/**
+		 * @brief Checks a list of boxes the same way as intersects.
+		 * @param boxes The boxes to check.
+		 * @param visible Filled with 1 for every box that is at least
+		 * partly inside and 0 for the rest.
+		 * @return The amount of boxes that are at least partly inside.
+		 */
+		std::size_t cull(const PackedBoxes&         boxes,
+		                 std::vector<std::uint8_t>& visible) const;
+
+	private:
+		// a, b, c and d of each plane, ax + by + cz + d >= 0 is inside.
+		float m_planes[6][4];
+	};
+} // namespace phx::math
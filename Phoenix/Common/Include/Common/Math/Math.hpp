@@ -29,6 +29,7 @@
 #pragma once
 
 #include <Common/Math/MathUtils.hpp>
+#include <Common/Math/Frustum.hpp>
 #include <Common/Math/Matrix4x4.hpp>
 #include <Common/Math/Vector2.hpp>
 #include <Common/Math/Vector3.hpp>
@@ -104,5 +104,33 @@ namespace phx::math
 	{
 		return x + len * (y + len * z);
 	}
+
+	/**
+	 * @brief Divides two integers, rounding down rather than towards zero.
+	 *
+	 * @tparam T
+	 * @param a The number being divided.
+	 * @param b The positive number to divide by.
+	 * @return constexpr T The largest whole number not above a / b.
+	 */
+	template <typename T>
+	static constexpr T floorDiv(T a, T b)
+	{
+		return a / b - (a % b < 0 ? 1 : 0);
+	}
+
+	/**
+	 * @brief Gets the remainder of floorDiv, which is never negative.
+	 *
+	 * @tparam T
+	 * @param a The number being divided.
+	 * @param b The positive number to divide by.
+	 * @return constexpr T The remainder, from 0 up to b - 1.
+	 */
+	template <typename T>
+	static constexpr T floorMod(T a, T b)
+	{
+		return a % b + (a % b < 0 ? b : 0);
+	}
 } // namespace phx::math
 
@@ -30,8 +30,38 @@
 
 #include <Common/Math/Vector3.hpp>
 
+#include <cmath>
+#include <limits>
+
 namespace phx::math
 {
+	/**
+	 * @brief Where a ray cast through a grid of voxels stopped.
+	 *
+	 * Voxel (x, y, z) is the unit cube from (x, y, z) to (x + 1, y + 1, z +
+	 * 1), so flooring a position gives the voxel it is in.
+	 */
+	struct RayHit
+	{
+		/// @brief Whether a voxel stopped the ray before it ran out.
+		bool hit = false;
+
+		/// @brief The voxel that stopped the ray, or the last one visited.
+		detail::Vector3<int> block;
+
+		/**
+		 * @brief The face the ray went into the voxel through, pointing out
+		 * of it. (0, 1, 0) means it came in through the top.
+		 *
+		 * This is zero if the ray started inside of the voxel, otherwise
+		 * block + normal is the voxel the ray came from.
+		 */
+		detail::Vector3<int> normal;
+
+		/// @brief How far along the ray it went into the voxel.
+		float distance = 0.f;
+	};
+
 	/**
 	 * @brief Produces a castable ray for helping find things at
 	 * positions/intervals along the ray.
@@ -77,11 +107,92 @@ namespace phx::math
 		 */
 		vec3 getCurrentPosition() const;
 
+		/**
+		 * @brief Walks every voxel the ray passes through from its start,
+		 * in order, until one stops it.
+		 *
+		 * @param maxDistance How far to walk, in lengths of the direction.
+		 * @param stop Called with each voxel as a detail::Vector3<int>,
+		 * returns true if the ray stops there.
+		 * @return Where the ray stopped.
+		 *
+		 * This is the voxel traversal of Amanatides and Woo: every voxel the
+		 * ray touches is visited exactly once, corners included, and
+		 * nothing else is. The current position of the ray is left alone.
+		 */
+		template <typename Stop>
+		RayHit traverse(float maxDistance, Stop&& stop) const;
+
 	private:
 		float m_length;
 		vec3  m_start;
 		vec3  m_direction;
 		vec3  m_currentPosition;
 	};
+
+	template <typename Stop>
+	RayHit Ray::traverse(float maxDistance, Stop&& stop) const
+	{
+		const float start[3]     = {m_start.x, m_start.y, m_start.z};
+		const float direction[3] = {m_direction.x, m_direction.y,
+		                            m_direction.z};
+
+		int voxel[3];
+		int step[3];
+		// how far along the ray the next boundary on each axis is, and how
+		// far apart the boundaries on each axis are.
+		float next[3];
+		float delta[3];
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			voxel[axis] = static_cast<int>(std::floor(start[axis]));
+
+			if (direction[axis] > 0.f)
+			{
+				step[axis]  = 1;
+				delta[axis] = 1.f / direction[axis];
+				next[axis]  = (voxel[axis] + 1 - start[axis]) * delta[axis];
+			}
+			else if (direction[axis] < 0.f)
+			{
+				step[axis]  = -1;
+				delta[axis] = -1.f / direction[axis];
+				next[axis]  = (start[axis] - voxel[axis]) * delta[axis];
+			}
+			else
+			{
+				step[axis]  = 0;
+				delta[axis] = std::numeric_limits<float>::infinity();
+				next[axis]  = std::numeric_limits<float>::infinity();
+			}
+		}
+
+		RayHit result;
+		while (true)
+		{
+			result.block = {voxel[0], voxel[1], voxel[2]};
+			if (stop(result.block))
+			{
+				result.hit = true;
+				return result;
+			}
+
+			int axis = next[0] < next[1] ? 0 : 1;
+			axis     = next[2] < next[axis] ? 2 : axis;
+
+			if (next[axis] > maxDistance)
+			{
+				return result;
+			}
+
+			voxel[axis] += step[axis];
+			result.distance = next[axis];
+			next[axis] += delta[axis];
+
+			int normal[3] = {0, 0, 0};
+			normal[axis]  = -step[axis];
+			result.normal = {normal[0], normal[1], normal[2]};
+		}
+	}
 } // namespace phx::math
 
@@ -29,6 +29,8 @@
 #pragma once
 
 #include <cmath>
+#include <functional>
+#include <initializer_list>
 #include <iostream>
 #include <ostream>
 
@@ -334,8 +336,15 @@ namespace phx::math
 		template <typename T>
 		std::size_t operator()(const detail::Vector3<T>& k) const
 		{
-			return std::hash<T>()(k.x) ^ std::hash<T>()(k.y) ^
-			       std::hash<T>()(k.z);
+			// combined like boost::hash_combine, xor alone gives every
+			// permutation of the axes (and any x == y) the same hash.
+			std::size_t hash = std::hash<T>()(k.x);
+			for (const T& axis : {k.y, k.z})
+			{
+				hash ^= std::hash<T>()(axis) + 0x9E3779B9 + (hash << 6) +
+				        (hash >> 2);
+			}
+			return hash;
 		}
 	};
 
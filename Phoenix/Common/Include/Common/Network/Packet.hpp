@@ -84,6 +84,18 @@ namespace phx::net
 		 */
 		Packet(const Data& data, PacketFlags flags);
 
+		/**
+		 * @brief Constructs a packet that takes over a buffer of data.
+		 * @param data The data to send within the packet.
+		 * @param flags The method with which the packet should be sent.
+		 *
+		 * ENet sends straight out of the buffer rather than a copy of it,
+		 * and it goes back to the pool acquireBuffer() takes from once ENet
+		 * is done with the packet. Move a Serializer's buffer in here once
+		 * it has been written to.
+		 */
+		Packet(Data&& data, PacketFlags flags);
+
 		/**
 		 * @brief Constructs a packet with a predetermined size.
 		 * @param size The size of the data which will be set later.
@@ -112,10 +124,20 @@ namespace phx::net
 		 * @return The packet's data.
 		 *
 		 * This method is useful on the receiving end. It will return a copy of
-		 * the data since the packet's lifetime cannot be determined.
+		 * the data since the packet's lifetime cannot be determined, prefer
+		 * getRawData() when the data is read inside of the receive callback.
 		 */
 		Data getData() const;
 
+		/**
+		 * @brief Gets the data the packet is storing without copying it.
+		 * @return A pointer to the packet's data, getSize() bytes long.
+		 *
+		 * The pointer is only valid for as long as the packet is, use this
+		 * with Serializer::setView when the data is read straight away.
+		 */
+		const std::byte* getRawData() const;
+
 		/**
 		 * @brief Resizes the packet.
 		 * @param size The new size for the packet.
@@ -146,6 +168,22 @@ namespace phx::net
 		 */
 		bool isSent() const { return m_sent; }
 
+		/**
+		 * @brief Gets an empty buffer to write the data of a packet into.
+		 * @return The buffer, reusing the memory of a sent packet if there
+		 * is one to spare.
+		 *
+		 * Hand the buffer back by moving it into a packet.
+		 *
+		 * @paragraph Usage
+		 * @code
+		 * Serializer ser(Packet::acquireBuffer());
+		 * ser << message;
+		 * peer->send(Packet(std::move(ser.getBuffer()), PacketFlags::RELIABLE));
+		 * @endcode
+		 */
+		static Data acquireBuffer();
+
 	private:
 		void create(const Data& data, PacketFlags flags);
 
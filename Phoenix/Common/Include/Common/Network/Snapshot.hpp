@@ -0,0 +1,202 @@
+// Copyright 2019-20 Genten Studios
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors
+// may be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+/**
+ * @file Snapshot.hpp
+ * @brief Delta compressed snapshots of the entities a client can see.
+ *
+ * @copyright Copyright (c) Genten Studios 2019 - 2020
+ *
+ */
+
+#pragma once
+
+#include <Common/Math/Math.hpp>
+#include <Common/Position.hpp>
+#include <Common/Utility/Serializer.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+namespace phx::net
+{
+	/**
+	 * @brief The state of an entity as it is sent to clients.
+	 *
+	 * Everything is quantized to whole numbers, so an entity that hasn't
+	 * moved compares equal and a change is a small integer that packs into
+	 * a byte or two.
+	 */
+	struct EntityState
+	{
+		/// @brief How many steps a position is split into per unit.
+		static constexpr float POSITION_SCALE = 64.f;
+		/// @brief How many steps a rotation is split into per radian.
+		static constexpr float ROTATION_SCALE = 4096.f;
+
+		std::uint32_t id = 0;
+		math::vec3i   position;
+		math::vec3i   rotation;
+
+		/**
+		 * @brief Quantizes the position of an entity.
+		 * @param id The ID of the entity.
+		 * @param position Where the entity is.
+		 * @return The quantized state.
+		 */
+		static EntityState quantize(std::uint32_t id, const Position& position);
+
+		/**
+		 * @brief Turns the state back into a position.
+		 * @return The position, to within a step of the one quantized.
+		 */
+		Position dequantize() const;
+
+		bool operator==(const EntityState& other) const
+		{
+			return id == other.id && position == other.position &&
+			       rotation == other.rotation;
+		}
+	};
+
+	/**
+	 * @brief The entities a client can see, at one point in time.
+	 */
+	struct Snapshot
+	{
+		/// @brief Counts up by one for every snapshot sent to a client,
+		/// starting at 1.
+		std::uint32_t tick = 0;
+		/// @brief The sequence of the last input the server applied, only
+		/// the lowest 16 bits are sent.
+		std::size_t sequence = 0;
+		/// @brief The entity the client controls.
+		std::uint32_t self = 0;
+		/// @brief The entities the client can see, sorted by ID.
+		std::vector<EntityState> entities;
+
+		/**
+		 * @brief Finds an entity in the snapshot.
+		 * @param id The ID of the entity.
+		 * @return The entity, or nullptr if the client can't see it.
+		 */
+		const EntityState* find(std::uint32_t id) const;
+	};
+
+	/**
+	 * @brief Writes the snapshots sent to one client, each as a delta
+	 * against the newest snapshot the client has acknowledged.
+	 *
+	 * Only entities that changed are written, and only the parts of them
+	 * that changed, as differences to the acknowledged snapshot. Entities
+	 * the client can no longer see are listed by ID. Until the client
+	 * acknowledges anything, or if it hasn't for longer than the history
+	 * kept, whole snapshots are sent.
+	 *
+	 * @paragraph Usage
+	 * @code
+	 * // server, every tick for every client.
+	 * Snapshot snapshot;
+	 * snapshot.entities = visibleEntities; // sorted by ID.
+	 * Serializer ser;
+	 * sender.write(std::move(snapshot), ser);
+	 *
+	 * // when the client acknowledges a tick.
+	 * sender.acknowledge(tick);
+	 * @endcode
+	 */
+	class SnapshotSender
+	{
+	public:
+		/// @brief How many sent snapshots are kept to be used as baselines.
+		static constexpr std::size_t HISTORY = 32;
+
+		/**
+		 * @brief Writes the next snapshot for the client.
+		 * @param snapshot The snapshot, its tick is set by the sender.
+		 * @param ser The serializer to write to.
+		 */
+		void write(Snapshot snapshot, Serializer& ser);
+
+		/**
+		 * @brief Records that the client has a snapshot, so later ones can
+		 * be sent as deltas against it.
+		 * @param tick The tick of the snapshot.
+		 *
+		 * Acknowledgements older than the newest one are ignored.
+		 */
+		void acknowledge(std::uint32_t tick);
+
+		/**
+		 * @brief Gets the tick of the newest snapshot the client has.
+		 * @return The tick, or 0 if the client hasn't acknowledged any.
+		 */
+		std::uint32_t getAcknowledged() const { return m_acknowledged; }
+
+	private:
+		std::deque<Snapshot> m_history;
+		std::uint32_t        m_tick         = 0;
+		std::uint32_t        m_acknowledged = 0;
+	};
+
+	/**
+	 * @brief Reads the snapshots written by a SnapshotSender.
+	 *
+	 * Received snapshots are kept for as long as the sender could use them
+	 * as a baseline, snapshots older than the newest one are dropped since
+	 * they arrived too late.
+	 */
+	class SnapshotReceiver
+	{
+	public:
+		/**
+		 * @brief Reads a snapshot.
+		 * @param ser The serializer to read from.
+		 * @return true if the snapshot was newer than the last one, and its
+		 * baseline was known.
+		 */
+		bool read(Serializer& ser);
+
+		/**
+		 * @brief Gets the newest snapshot read.
+		 * @return The snapshot, or nullptr if none have been read.
+		 */
+		const Snapshot* getLatest() const;
+
+		/**
+		 * @brief Gets the tick to acknowledge to the sender.
+		 * @return The tick of the newest snapshot, or 0 if none.
+		 */
+		std::uint32_t getAcknowledgement() const;
+
+	private:
+		std::deque<Snapshot> m_history;
+	};
+} // namespace phx::net
@@ -29,6 +29,7 @@
 #pragma once
 
 #include <Common/Position.hpp>
+#include <Common/Voxels/ChunkViewTracker.hpp>
 #include <Common/Voxels/Map.hpp>
 
 #include <entt/entt.hpp>
@@ -39,12 +40,72 @@ namespace phx
 {
 	struct PlayerView
 	{
-		PlayerView(voxels::Map* map) : map(map) {}
+		/// @brief How many chunks away from the player chunks are loaded.
+		static constexpr int VIEW_DISTANCE = 3;
+		/// @brief How many chunks further than the view distance chunks are
+		/// kept, so going back and forth over a chunk border doesn't keep
+		/// unloading and loading the same chunks.
+		static constexpr int UNLOAD_HYSTERESIS = 1;
 
-		std::vector<math::vec3> chunks;
-		voxels::Map*            map;
+		PlayerView(voxels::Map* map)
+		    : tracker(VIEW_DISTANCE, VIEW_DISTANCE + UNLOAD_HYSTERESIS),
+		      map(map)
+		{
+		}
 
+		/// @brief The chunks the player has been given, and the ones they
+		/// are still waiting on.
+		voxels::ChunkViewTracker tracker;
+		voxels::Map*             map;
+
+		/**
+		 * @brief Loads the chunks that have come into the player's view.
+		 *
+		 * @param registry The registry the player is in.
+		 * @param entity The player.
+		 * @return The chunks the player hasn't been given yet, nearest
+		 * first. Chunks that are still loading are returned by a later
+		 * update.
+		 */
 		static std::vector<voxels::Chunk*> update(entt::registry* registry,
 		                                          entt::entity    entity);
+
+		/**
+		 * @brief Forgets the chunks that are too far away from the player,
+		 * so they are loaded again by update if the player comes back.
+		 *
+		 * @param registry The registry the player is in.
+		 * @param entity The player.
+		 * @return The positions of the chunks that were forgotten, nearest
+		 * first.
+		 *
+		 * Nothing is unloaded from the map, other players might still need
+		 * the chunks.
+		 */
+		static std::vector<math::vec3> evict(entt::registry* registry,
+		                                     entt::entity    entity);
+
+		/**
+		 * @brief Gets whether a chunk is close enough to the player to be
+		 * kept loaded.
+		 *
+		 * @param registry The registry the player is in.
+		 * @param entity The player.
+		 * @param chunkPos The position of the chunk.
+		 * @return true if the chunk is within the view distance plus the
+		 * hysteresis.
+		 */
+		static bool isInRange(entt::registry* registry, entt::entity entity,
+		                      const math::vec3& chunkPos);
+
+		/**
+		 * @brief Gets the chunk a player is in.
+		 *
+		 * @param registry The registry the player is in.
+		 * @param entity The player.
+		 * @return The chunk.
+		 */
+		static voxels::ChunkPos getChunkPos(entt::registry* registry,
+		                                    entt::entity    entity);
 	};
 } // namespace phx
@@ -0,0 +1,159 @@
+// Copyright 2019-20 Genten Studios
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors
+// may be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <Common/Utility/Internal/SharedTypes.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace phx::data
+{
+	/**
+	 * @brief The algorithms a compression frame can be encoded with.
+	 *
+	 * The values are written into every frame and sent over the network, so
+	 * existing values must never change.
+	 */
+	enum class Codec : std::uint8_t
+	{
+		/// @brief The payload is stored as is.
+		NONE = 0,
+
+		/// @brief The payload is compressed with zlib's deflate.
+		DEFLATE = 1,
+	};
+
+	/**
+	 * @brief The outcome of decompressing a frame.
+	 */
+	enum class FrameStatus
+	{
+		/// @brief The frame was decompressed.
+		OK,
+
+		/// @brief The frame is cut short or its payload doesn't decode, the
+		/// data in it is lost.
+		DAMAGED,
+
+		/// @brief The frame's codec isn't built in (or isn't known at all),
+		/// the data might still be intact for a build that has it.
+		UNSUPPORTED,
+	};
+
+	/**
+	 * @brief Compresses data into self describing frames.
+	 *
+	 * Every frame starts with a small header, the codec the payload was
+	 * encoded with and the length of the data before it was compressed, so
+	 * decompressing never needs to know how the frame was made. If a codec
+	 * does not make the data any smaller, the frame falls back to Codec::NONE.
+	 *
+	 * Codecs that are not built in (zlib is optional) are never used, which
+	 * is what getSupportedCodecs() and negotiate() are for when talking to a
+	 * peer that might have been built differently.
+	 *
+	 * @paragraph Usage
+	 * @code
+	 * Serializer ser;
+	 * ser << chunk;
+	 *
+	 * const data::Data frame =
+	 *     Compression::compress(ser.getBuffer(), Codec::DEFLATE, 1);
+	 *
+	 * data::Data raw;
+	 * if (Compression::decompress(frame.data(), frame.size(), raw) ==
+	 *     FrameStatus::OK)
+	 * {
+	 *     ser.setBuffer(std::move(raw));
+	 *     ser >> chunk;
+	 * }
+	 * @endcode
+	 */
+	class Compression
+	{
+	public:
+		/// @brief The size of a frame's header, in bytes.
+		static constexpr std::size_t HEADER_SIZE = 5;
+
+		/// @brief Frames larger than this when decompressed are rejected.
+		static constexpr std::size_t MAX_RAW_SIZE = 64 * 1024 * 1024;
+
+		/**
+		 * @brief Compresses data into a frame.
+		 * @param data The data to compress.
+		 * @param size The size of the data in bytes.
+		 * @param codec The codec to compress with.
+		 * @param level The codec specific compression level, 0 uses the
+		 * codec's default.
+		 * @return The frame, header included.
+		 */
+		static Data compress(const std::byte* data, std::size_t size,
+		                     Codec codec, int level = 0);
+		static Data compress(const Data& data, Codec codec, int level = 0);
+
+		/**
+		 * @brief Decompresses a frame.
+		 * @param frame The frame, starting at its header.
+		 * @param size The size of the frame in bytes.
+		 * @param data Where the decompressed data is written to.
+		 * @return FrameStatus::OK if data holds the decompressed frame.
+		 */
+		static FrameStatus decompress(const std::byte* frame, std::size_t size,
+		                              Data& data);
+
+		/**
+		 * @brief Checks whether a codec was built in.
+		 * @param codec The codec to check.
+		 * @return Whether frames can be compressed with the codec.
+		 */
+		static bool isSupported(Codec codec);
+
+		/**
+		 * @brief Gets every codec that was built in.
+		 * @return A mask with the bit of every supported codec's value set.
+		 */
+		static std::uint32_t getSupportedCodecs();
+
+		/**
+		 * @brief Picks the best codec both sides support.
+		 * @param peerCodecs The mask of codecs the other side supports.
+		 * @return The codec to compress with, Codec::NONE at worst.
+		 */
+		static Codec negotiate(std::uint32_t peerCodecs);
+
+		/**
+		 * @brief Finds a codec by its name, as used in settings.
+		 * @param name The name of the codec, like "deflate".
+		 * @return The codec, Codec::NONE if the name is unknown.
+		 */
+		static Codec fromName(const std::string& name);
+	};
+} // namespace phx::data
@@ -0,0 +1,312 @@
+// Copyright 2019-20 Genten Studios
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors
+// may be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace phx
+{
+	/**
+	 * @brief A hash map that keeps its elements in one flat array.
+	 *
+	 * Collisions are resolved with linear probing, so a lookup only walks
+	 * through neighbouring slots instead of chasing a pointer to every
+	 * node like std::unordered_map. Erasing shifts the elements after it
+	 * back, so no tombstones are left behind to slow down later lookups.
+	 *
+	 * Elements move when the map grows and when an element before them is
+	 * erased, so pointers and iterators to them don't stay valid. Store a
+	 * std::unique_ptr if something needs to point at a value for longer.
+	 *
+	 * @tparam Key The type of the keys.
+	 * @tparam Value The type of the values, must be default constructible.
+	 * @tparam Hash Hashes keys, the low bits are used so they must be
+	 * mixed well.
+	 * @tparam KeyEqual Compares keys.
+	 *
+	 * @paragraph Usage
+	 * @code
+	 * FlatHashMap<ChunkPos, std::unique_ptr<Chunk>, ChunkPosHasher> chunks;
+	 * chunks.try_emplace({0, 0, 0}, std::make_unique<Chunk>(...));
+	 *
+	 * const auto it = chunks.find({0, 0, 0});
+	 * if (it != chunks.end())
+	 * {
+	 *     it->second->getBlockAt(...);
+	 * }
+	 * @endcode
+	 */
+	template <typename Key, typename Value, typename Hash = std::hash<Key>,
+	          typename KeyEqual = std::equal_to<Key>>
+	class FlatHashMap
+	{
+	public:
+		using value_type = std::pair<Key, Value>;
+
+		template <bool Const>
+		class Iterator
+		{
+		public:
+			using Map =
+			    std::conditional_t<Const, const FlatHashMap, FlatHashMap>;
+			using Slot    = typename FlatHashMap::value_type;
+			using Element = std::conditional_t<Const, const Slot, Slot>;
+
+			using iterator_category = std::forward_iterator_tag;
+			using difference_type   = std::ptrdiff_t;
+			using value_type        = Element;
+			using pointer           = Element*;
+			using reference         = Element&;
+
+			Iterator(Map* map, std::size_t slot) : m_map(map), m_slot(slot)
+			{
+				skipEmpty();
+			}
+
+			reference operator*() const { return m_map->m_slots[m_slot]; }
+			pointer   operator->() const { return &m_map->m_slots[m_slot]; }
+
+			Iterator& operator++()
+			{
+				++m_slot;
+				skipEmpty();
+				return *this;
+			}
+
+			bool operator==(const Iterator& other) const
+			{
+				return m_slot == other.m_slot;
+			}
+
+			bool operator!=(const Iterator& other) const
+			{
+				return m_slot != other.m_slot;
+			}
+
+		private:
+			void skipEmpty()
+			{
+				while (m_slot < m_map->m_used.size() && !m_map->m_used[m_slot])
+				{
+					++m_slot;
+				}
+			}
+
+			friend class FlatHashMap;
+
+			Map*        m_map;
+			std::size_t m_slot;
+		};
+
+		using iterator       = Iterator<false>;
+		using const_iterator = Iterator<true>;
+
+	public:
+		iterator       begin() { return {this, 0}; }
+		iterator       end() { return {this, m_slots.size()}; }
+		const_iterator begin() const { return {this, 0}; }
+		const_iterator end() const { return {this, m_slots.size()}; }
+
+		std::size_t size() const { return m_size; }
+		bool        empty() const { return m_size == 0; }
+
+		void clear()
+		{
+			m_slots.clear();
+			m_used.clear();
+			m_size = 0;
+		}
+
+		/**
+		 * @brief Makes room for a number of elements, so adding them never
+		 * has to grow the map.
+		 * @param count The amount of elements to make room for.
+		 */
+		void reserve(std::size_t count)
+		{
+			std::size_t capacity = MIN_CAPACITY;
+			while (count * 4 > capacity * 3)
+			{
+				capacity *= 2;
+			}
+
+			if (capacity > m_slots.size())
+			{
+				rehash(capacity);
+			}
+		}
+
+		iterator find(const Key& key)
+		{
+			return {this, findSlot(key)};
+		}
+
+		const_iterator find(const Key& key) const
+		{
+			return {this, findSlot(key)};
+		}
+
+		/**
+		 * @brief Adds an element, unless one with the same key is already in
+		 * the map.
+		 * @param key The key of the element.
+		 * @param args Constructs the value, only used if it's added.
+		 * @return The element with the key, and whether it was added.
+		 */
+		template <typename... Args>
+		std::pair<iterator, bool> try_emplace(const Key& key, Args&&... args)
+		{
+			const std::size_t existing = findSlot(key);
+			if (existing != m_slots.size())
+			{
+				return {{this, existing}, false};
+			}
+
+			if ((m_size + 1) * 4 > m_slots.size() * 3)
+			{
+				rehash(m_slots.empty() ? MIN_CAPACITY : m_slots.size() * 2);
+			}
+
+			const std::size_t mask = m_slots.size() - 1;
+
+			std::size_t slot = Hash()(key) & mask;
+			while (m_used[slot])
+			{
+				slot = (slot + 1) & mask;
+			}
+
+			m_slots[slot] =
+			    value_type(key, Value(std::forward<Args>(args)...));
+			m_used[slot] = 1;
+			++m_size;
+
+			return {{this, slot}, true};
+		}
+
+		/**
+		 * @brief Removes the element with a key.
+		 * @param key The key of the element.
+		 * @return The amount of elements removed, 0 or 1.
+		 */
+		std::size_t erase(const Key& key)
+		{
+			std::size_t hole = findSlot(key);
+			if (hole == m_slots.size())
+			{
+				return 0;
+			}
+
+			const std::size_t mask = m_slots.size() - 1;
+
+			// the elements after the hole are shifted back into it as long
+			// as that doesn't put them before the slot they hash to.
+			m_slots[hole] = value_type();
+			m_used[hole]  = 0;
+			for (std::size_t slot = (hole + 1) & mask; m_used[slot];
+			     slot             = (slot + 1) & mask)
+			{
+				const std::size_t home = Hash()(m_slots[slot].first) & mask;
+				if (((slot - home) & mask) >= ((slot - hole) & mask))
+				{
+					m_slots[hole] = std::move(m_slots[slot]);
+					m_used[hole]  = 1;
+					m_slots[slot] = value_type();
+					m_used[slot]  = 0;
+					hole          = slot;
+				}
+			}
+
+			--m_size;
+			return 1;
+		}
+
+	private:
+		static constexpr std::size_t MIN_CAPACITY = 16;
+
+		std::size_t findSlot(const Key& key) const
+		{
+			if (m_size == 0)
+			{
+				return m_slots.size();
+			}
+
+			const std::size_t mask = m_slots.size() - 1;
+			for (std::size_t slot = Hash()(key) & mask; m_used[slot];
+			     slot             = (slot + 1) & mask)
+			{
+				if (KeyEqual()(m_slots[slot].first, key))
+				{
+					return slot;
+				}
+			}
+
+			return m_slots.size();
+		}
+
+		void rehash(std::size_t capacity)
+		{
+			std::vector<value_type>   slots(capacity);
+			std::vector<std::uint8_t> used(capacity, 0);
+
+			const std::size_t mask = capacity - 1;
+			for (std::size_t i = 0; i < m_slots.size(); ++i)
+			{
+				if (!m_used[i])
+				{
+					continue;
+				}
+
+				std::size_t slot = Hash()(m_slots[i].first) & mask;
+				while (used[slot])
+				{
+					slot = (slot + 1) & mask;
+				}
+
+				slots[slot] = std::move(m_slots[i]);
+				used[slot]  = 1;
+			}
+
+			m_slots.swap(slots);
+			m_used.swap(used);
+		}
+
+	private:
+		// always a power of two in size, so slots can be masked rather than
+		// divided into.
+		std::vector<value_type>   m_slots;
+		std::vector<std::uint8_t> m_used;
+		std::size_t               m_size = 0;
+	};
+} // namespace phx
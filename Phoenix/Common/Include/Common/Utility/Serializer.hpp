@@ -70,28 +70,15 @@ namespace phx
 	 * this class on both sides of the system.
 	 *
 	 * @paragraph Usage
-	 * If preparing data to send, the mode used must be Mode::WRITE, since
-	 * you're writing to the buffer. If you've just received data and funneled
-	 * the Packet's data into the serializer, you should use the Mode::READ
-	 * mode. This will prevent you from writing to the buffer (and vice versa
-	 * for the write mode).
-	 *
-	 * To pack a value into the buffer, use the & operator and write mode. The &
-	 * operator is small so you can have a chain of things like: ``serializer &
-	 * var & var2 & var3;``. The buffer can then be retrieved using ``getBuffer()``
-	 *
-	 * To retrieve a value from the buffer, again, use the & operator and read
-	 * mode. You should read **in the same direction of variables than when
-	 * you packed the buffer**. For example, pack the buffer like this:
-	 * @code
-	 * Serializer ser(Serializer::Mode::WRITE);
-	 * ser & var1 & var2 & var3 & var4;
-	 * @endcode
-	 * And unpack the buffer like this:
-	 * @code
-	 * Serializer ser(Serializer::Mode::READ);
-	 * ser & var1 & var2 & var3 & var4;
-	 * @endcode
+	 * To pack values into the buffer, use the << operator. It returns the
+	 * serializer so values can be chained like: ``serializer << var << var2 <<
+	 * var3;``. The buffer can then be retrieved using ``getBuffer()``.
+	 *
+	 * To retrieve values, give the serializer the data with ``setBuffer()``
+	 * or ``setView()`` and use the >> operator. You should read **in the same
+	 * order and with the same types as when you packed the buffer**. Strings
+	 * and vectors are written as their length followed by their contents.
+	 * Classes implementing ISerializable can be written and read the same way.
 	 *
 	 * Usage with a packet:
 	 * @code
@@ -101,8 +88,8 @@ namespace phx
 	 * float wowee = 0.01f;
 	 * std::size_t sequence = 100355;
 	 *
-	 * Serializer ser(Serializer::Mode::WRITE)
-	 * ser & status & moving & wowee & sequence;
+	 * Serializer ser;
+	 * ser << status << moving << wowee << sequence;
 	 *
 	 * send_packet(ser.getBuffer());
 	 *
@@ -114,30 +101,77 @@ namespace phx
 	 *
 	 * Packet packet = receive_packet();
 	 *
-	 * Serializer ser(Serializer::Mode::READ)
-	 * ser.setBuffer(packet.getData());
-	 * ser & status & moving & wowee & sequence;
+	 * Serializer ser;
+	 * ser.setView(packet.getRawData(), packet.getSize());
+	 * ser >> status >> moving >> wowee >> sequence;
 	 *
 	 * // status, moving, wowee and sequence will be equal to their client
 	 * // counterparts.
 	 * @endcode
+	 *
+	 * @paragraph Reading
+	 * Reading does not remove anything from the buffer, a read cursor is
+	 * moved forward instead so deserializing stays linear in the size of the
+	 * data. If the data lives somewhere else for long enough, like in a
+	 * received packet or a mapped file, ``setView()`` lets the serializer read
+	 * straight from it without copying it into the buffer first. Reading past
+	 * the end of the data gives zeroed values rather than reading out of
+	 * bounds, and marks the serializer as failed().
 	 */
 	class Serializer
 	{
 	public:
 		Serializer() = default;
 
+		/**
+		 * @brief Constructs a serializer that writes into a buffer with
+		 * memory already set aside, like one from Packet::acquireBuffer().
+		 * @param buffer The buffer to write into, anything in it is cleared.
+		 */
+		explicit Serializer(data::Data&& buffer);
+
 		data::Data& getBuffer() { return m_buffer; }
 		void        setBuffer(std::byte* data, std::size_t dataLength);
-		void        setBuffer(const data::Data& data) { m_buffer = data; }
-		void        setBuffer(data::Data&& data) { m_buffer = std::move(data); }
+		void        setBuffer(const data::Data& data);
+		void        setBuffer(data::Data&& data);
+
+		/**
+		 * @brief Reads from memory owned by something else.
+		 * @param data The data to read from.
+		 * @param dataLength The size of the data in bytes.
+		 *
+		 * Nothing is copied, the data must outlive any reads from this
+		 * serializer. Writing still goes into the serializer's own buffer.
+		 */
+		void setView(const std::byte* data, std::size_t dataLength);
 
 		void appendToBuffer(const std::vector<std::byte>& data)
 		{
 			m_buffer.insert(m_buffer.end(), data.begin(), data.end());
 		}
 
-		bool empty() const { return m_buffer.empty(); }
+		/**
+		 * @brief Gets the number of bytes that have not been read yet.
+		 * @return The number of unread bytes.
+		 */
+		std::size_t remaining() const { return readSize() - m_cursor; }
+
+		bool empty() const { return remaining() == 0; }
+
+		/**
+		 * @brief Checks if the data being read turned out to be damaged.
+		 * @return true if anything was read past the end of the data, or a
+		 * reader found the data didn't make sense and called fail().
+		 */
+		bool failed() const { return m_failed; }
+
+		/**
+		 * @brief Marks the data being read as damaged.
+		 *
+		 * For an ISerializable to report data it can't make sense of, the
+		 * flag is cleared when new data is set to be read.
+		 */
+		void fail() { m_failed = true; }
 		
 		Serializer& operator<<(const bool& val);
 		Serializer& operator<<(const char& val);
@@ -208,8 +242,187 @@ namespace phx
 		template <typename T>
 		void pop(std::vector<T>& data);
 
+		const std::byte* readData() const
+		{
+			return m_view != nullptr ? m_view : m_buffer.data();
+		}
+
+		std::size_t readSize() const
+		{
+			return m_view != nullptr ? m_viewSize : m_buffer.size();
+		}
+
 	private:
 		data::Data m_buffer;
+
+		const std::byte* m_view     = nullptr;
+		std::size_t      m_viewSize = 0;
+		std::size_t      m_cursor   = 0;
+		bool             m_failed   = false;
+	};
+
+	/**
+	 * @brief Packs values into only as many bits as they need, at the end of
+	 * a serializer's buffer.
+	 *
+	 * Bits are gathered into bytes, the last byte is only written when the
+	 * writer is flushed or destroyed, so flush before writing anything else
+	 * to the serializer. Values are read back with a BitReader, in the same
+	 * order and with the same sizes.
+	 *
+	 * @paragraph Usage
+	 * @code
+	 * Serializer ser;
+	 * {
+	 *     BitWriter bits(ser);
+	 *     bits.writeBool(moving);
+	 *     bits.writeBits(direction, 3);
+	 *     bits.writeQuantized(health, 0.f, 100.f, 7);
+	 *     bits.writeSequence(static_cast<std::uint16_t>(sequence));
+	 * }
+	 *
+	 * BitReader bits(ser);
+	 * moving    = bits.readBool();
+	 * direction = bits.readBits(3);
+	 * health    = bits.readQuantized(0.f, 100.f, 7);
+	 * sequence  = BitReader::unwrapSequence(bits.readSequence(), sequence);
+	 * @endcode
+	 */
+	class BitWriter
+	{
+	public:
+		explicit BitWriter(Serializer& serializer);
+		~BitWriter();
+
+		BitWriter(const BitWriter&) = delete;
+		BitWriter& operator=(const BitWriter&) = delete;
+
+		/**
+		 * @brief Writes the lowest bits of a value.
+		 * @param value The value, any higher bits are ignored.
+		 * @param bits How many bits to write, at most 32.
+		 */
+		void writeBits(std::uint32_t value, unsigned int bits);
+
+		void writeBool(bool value);
+
+		/**
+		 * @brief Writes an unsigned integer in 7 bit groups, so small values
+		 * take a byte.
+		 * @param value The value to write.
+		 */
+		void writeVarint(std::uint64_t value);
+
+		/**
+		 * @brief Writes a signed integer as a varint, small negative values
+		 * stay small.
+		 * @param value The value to write.
+		 */
+		void writeSigned(std::int64_t value);
+
+		/**
+		 * @brief Writes a float in a known range as a fixed number of steps.
+		 * @param value The value, clamped to the range.
+		 * @param min The lowest value of the range.
+		 * @param max The highest value of the range.
+		 * @param bits How many bits to use, at most 32.
+		 */
+		void writeQuantized(float value, float min, float max,
+		                    unsigned int bits);
+
+		/**
+		 * @brief Writes the lowest 16 bits of a sequence number.
+		 * @param sequence The sequence, wrapped to 16 bits.
+		 *
+		 * The reader recovers the full sequence with
+		 * BitReader::unwrapSequence(), as long as it is within 32767 of a
+		 * sequence the reader knows.
+		 */
+		void writeSequence(std::uint16_t sequence);
+
+		/**
+		 * @brief Writes the bits gathered so far, padding the last byte with
+		 * zeroes.
+		 */
+		void flush();
+
+		/**
+		 * @brief Gets the step a float falls on, as written by
+		 * writeQuantized().
+		 * @param value The value, clamped to the range.
+		 * @param min The lowest value of the range.
+		 * @param max The highest value of the range.
+		 * @param bits How many bits there are to the step.
+		 * @return The step, from 0 for min to all bits set for max.
+		 */
+		static std::uint32_t quantize(float value, float min, float max,
+		                              unsigned int bits);
+
+	private:
+		Serializer&   m_serializer;
+		std::uint64_t m_scratch     = 0;
+		unsigned int  m_scratchBits = 0;
+	};
+
+	/**
+	 * @brief Reads the values written by a BitWriter.
+	 *
+	 * Bytes are taken from the serializer as they are needed, so once the
+	 * last value is read the serializer is at the byte after them. Reading
+	 * past the end gives zeroes and marks the reader as overflowed.
+	 */
+	class BitReader
+	{
+	public:
+		explicit BitReader(Serializer& serializer);
+
+		std::uint32_t readBits(unsigned int bits);
+		bool          readBool();
+		std::uint64_t readVarint();
+		std::int64_t  readSigned();
+		float         readQuantized(float min, float max, unsigned int bits);
+		std::uint16_t readSequence();
+
+		/**
+		 * @brief Gets how many bits are left to read.
+		 * @return The number of unread bits.
+		 */
+		std::size_t remaining() const;
+
+		/**
+		 * @brief Checks if anything was read past the end of the data.
+		 * @return true if the data ran out, which in a packet means it was
+		 * damaged or cut short.
+		 */
+		bool overflowed() const { return m_overflowed; }
+
+		/**
+		 * @brief Gets the float a step stands for, as read by
+		 * readQuantized().
+		 * @param step The step.
+		 * @param min The lowest value of the range.
+		 * @param max The highest value of the range.
+		 * @param bits How many bits there are to the step.
+		 * @return The value.
+		 */
+		static float dequantize(std::uint32_t step, float min, float max,
+		                        unsigned int bits);
+
+		/**
+		 * @brief Recovers a full sequence number from its lowest 16 bits.
+		 * @param sequence The sequence as read by readSequence().
+		 * @param reference A recent sequence, like the last one received.
+		 * @return The sequence closest to the reference that ends in the
+		 * same 16 bits.
+		 */
+		static std::size_t unwrapSequence(std::uint16_t sequence,
+		                                  std::size_t   reference);
+
+	private:
+		Serializer&   m_serializer;
+		std::uint64_t m_scratch     = 0;
+		unsigned int  m_scratchBits = 0;
+		bool          m_overflowed  = false;
 	};
 } // namespace phx::data
 
@@ -27,13 +27,52 @@
 // POSSIBILITY OF SUCH DAMAGE.
 
 #include <algorithm>
+#include <cmath>
+#include <cstdint>
 
 namespace phx
 {
+	inline Serializer::Serializer(data::Data&& buffer)
+	    : m_buffer(std::move(buffer))
+	{
+		m_buffer.clear();
+	}
+
 	inline void Serializer::setBuffer(std::byte* data, std::size_t dataLength)
 	{
 		m_buffer.clear();
 		m_buffer.insert(m_buffer.begin(), data, data + dataLength);
+
+		m_view   = nullptr;
+		m_cursor = 0;
+		m_failed = false;
+	}
+
+	inline void Serializer::setBuffer(const data::Data& data)
+	{
+		m_buffer = data;
+
+		m_view   = nullptr;
+		m_cursor = 0;
+		m_failed = false;
+	}
+
+	inline void Serializer::setBuffer(data::Data&& data)
+	{
+		m_buffer = std::move(data);
+
+		m_view   = nullptr;
+		m_cursor = 0;
+		m_failed = false;
+	}
+
+	inline void Serializer::setView(const std::byte* data,
+	                                std::size_t      dataLength)
+	{
+		m_view     = data;
+		m_viewSize = dataLength;
+		m_cursor   = 0;
+		m_failed   = false;
 	}
 
 	inline Serializer& Serializer::operator<<(const bool& val)
@@ -286,14 +325,14 @@ namespace phx
 	template <typename T>
 	void Serializer::push(const std::basic_string<T>& data)
 	{
-		// if T is the same as the number of bits in a char, it's a normal
-		// std::string. This means that there is only 1 byte per character and
-		// so you don't need to factor in any endianness changes.
-		if constexpr (sizeof(T) == CHAR_BIT)
+		// if a character is a single byte, it's a normal std::string. This
+		// means you don't need to factor in any endianness changes.
+		if constexpr (sizeof(T) == 1)
 		{
 			// this is faster than iterating through every character and
 			// swapping endianness and essentially doing an unnecessary
-			// endianness swap.
+			// endianness swap. The layout is the same either way, the length
+			// followed by the characters with no null terminator.
 
 			// push size of string onto data at the end.
 			// specify unsigned int otherwise it will waste space allocating a
@@ -304,12 +343,11 @@ namespace phx
 			// than the new end.
 			const std::size_t prevEnd = m_buffer.size();
 
-			// +1 for null terminator.
-			m_buffer.resize(m_buffer.size() + data.length() + 1);
+			m_buffer.resize(m_buffer.size() + data.length());
 
 			// convert string to array of std::byte and append to data array.
 			std::transform(data.begin(), data.end(), m_buffer.begin() + prevEnd,
-			               [](char c) { return std::byte(c); });
+			               [](T c) { return std::byte(c); });
 		}
 		else
 		{
@@ -334,10 +372,17 @@ namespace phx
 			T         value;
 		} value;
 
-		std::memcpy(value.bytes, m_buffer.data(), sizeof(T));
+		if (remaining() < sizeof(T))
+		{
+			// ran out of data, don't read past the end of it.
+			m_cursor = readSize();
+			m_failed = true;
+			data     = T {};
+			return;
+		}
 
-		// basically pop front for the amount of bytes of data we're taking.
-		m_buffer.erase(m_buffer.begin(), m_buffer.begin() + sizeof(T));
+		std::memcpy(value.bytes, readData() + m_cursor, sizeof(T));
+		m_cursor += sizeof(T);
 
 		data = data::endian::swapForHost(value.value);
 	}
@@ -354,37 +399,50 @@ namespace phx
 		std::size_t dataCount;
 		pop(dataCount);
 
-		data.reserve(dataCount);
+		if (dataCount > remaining() / sizeof(T))
+		{
+			m_cursor = readSize();
+			m_failed = true;
+			return;
+		}
+
+		const std::byte* begin = readData() + m_cursor;
+
+		data.reserve(data.size() + dataCount);
 		for (std::size_t i = 0; i < dataCount; ++i)
 		{
-			std::memcpy(value.bytes, m_buffer.data() + (i * sizeof(T)),
-			            sizeof(T));
+			std::memcpy(value.bytes, begin + (i * sizeof(T)), sizeof(T));
 
 			value.value = data::endian::swapForHost(value.value);
 
 			data.push_back(value.value);
 		}
 
-		m_buffer.erase(m_buffer.begin(),
-		               m_buffer.begin() + (dataCount * sizeof(T)));
+		m_cursor += dataCount * sizeof(T);
 	}
 
 	template <typename T>
 	void Serializer::pop(std::basic_string<T>& data)
 	{
-		if constexpr (sizeof(T) == CHAR_BIT)
+		if constexpr (sizeof(T) == 1)
 		{
 			unsigned int size;
 			pop(size);
 
-			data.resize(size);
+			if (size > remaining())
+			{
+				m_cursor = readSize();
+				m_failed = true;
+				return;
+			}
+
+			const std::byte* begin = readData() + m_cursor;
 
-			std::transform(m_buffer.begin(), m_buffer.begin() + size,
-			               data.begin(),
-			               [](std::byte byte) { return char(byte); });
+			data.resize(size);
+			std::transform(begin, begin + size, data.begin(),
+			               [](std::byte byte) { return T(byte); });
 
-			// basically pop front for the amount of bytes of data we're taking.
-			m_buffer.erase(m_buffer.begin(), m_buffer.begin() + size);
+			m_cursor += size;
 		}
 		else
 		{
@@ -397,6 +455,13 @@ namespace phx
 			unsigned int size;
 			pop(size);
 
+			if (size > remaining() / sizeof(T))
+			{
+				m_cursor = readSize();
+				m_failed = true;
+				return;
+			}
+
 			data.reserve(size);
 
 			for (unsigned int i = 0; i < size; ++i)
@@ -406,4 +471,167 @@ namespace phx
 			}
 		}
 	}
+
+	inline BitWriter::BitWriter(Serializer& serializer)
+	    : m_serializer(serializer)
+	{
+	}
+
+	inline BitWriter::~BitWriter() { flush(); }
+
+	inline void BitWriter::writeBits(std::uint32_t value, unsigned int bits)
+	{
+		const std::uint64_t mask = (std::uint64_t {1} << bits) - 1;
+		m_scratch |= (value & mask) << m_scratchBits;
+		m_scratchBits += bits;
+
+		while (m_scratchBits >= 8)
+		{
+			m_serializer << static_cast<unsigned char>(m_scratch & 0xFF);
+			m_scratch >>= 8;
+			m_scratchBits -= 8;
+		}
+	}
+
+	inline void BitWriter::writeBool(bool value) { writeBits(value, 1); }
+
+	inline void BitWriter::writeVarint(std::uint64_t value)
+	{
+		while (value >= 0x80)
+		{
+			writeBits(static_cast<std::uint32_t>((value & 0x7F) | 0x80), 8);
+			value >>= 7;
+		}
+		writeBits(static_cast<std::uint32_t>(value), 8);
+	}
+
+	inline void BitWriter::writeSigned(std::int64_t value)
+	{
+		// zigzag encoding, 0, -1, 1, -2... become 0, 1, 2, 3...
+		writeVarint((static_cast<std::uint64_t>(value) << 1) ^
+		            static_cast<std::uint64_t>(value >> 63));
+	}
+
+	inline void BitWriter::writeQuantized(float value, float min, float max,
+	                                      unsigned int bits)
+	{
+		writeBits(quantize(value, min, max, bits), bits);
+	}
+
+	inline void BitWriter::writeSequence(std::uint16_t sequence)
+	{
+		writeBits(sequence, 16);
+	}
+
+	inline void BitWriter::flush()
+	{
+		if (m_scratchBits > 0)
+		{
+			writeBits(0, 8 - m_scratchBits);
+		}
+	}
+
+	inline std::uint32_t BitWriter::quantize(float value, float min,
+	                                         float max, unsigned int bits)
+	{
+		// doubles, a float can't hold every step of 32 bits.
+		const std::uint64_t steps = (std::uint64_t {1} << bits) - 1;
+		const double        t     = (std::clamp(value, min, max) - min) /
+		                   static_cast<double>(max - min);
+		return static_cast<std::uint32_t>(std::llround(t * steps));
+	}
+
+	inline BitReader::BitReader(Serializer& serializer)
+	    : m_serializer(serializer)
+	{
+	}
+
+	inline std::uint32_t BitReader::readBits(unsigned int bits)
+	{
+		while (m_scratchBits < bits)
+		{
+			unsigned char byte = 0;
+			if (m_serializer.empty())
+			{
+				m_overflowed = true;
+			}
+			else
+			{
+				m_serializer >> byte;
+			}
+
+			m_scratch |= static_cast<std::uint64_t>(byte) << m_scratchBits;
+			m_scratchBits += 8;
+		}
+
+		const std::uint64_t mask = (std::uint64_t {1} << bits) - 1;
+		const auto value = static_cast<std::uint32_t>(m_scratch & mask);
+		m_scratch >>= bits;
+		m_scratchBits -= bits;
+		return value;
+	}
+
+	inline bool BitReader::readBool() { return readBits(1) != 0; }
+
+	inline std::uint64_t BitReader::readVarint()
+	{
+		std::uint64_t value = 0;
+		for (unsigned int shift = 0; shift < 64; shift += 7)
+		{
+			const std::uint32_t byte = readBits(8);
+
+			value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+			if ((byte & 0x80) == 0)
+			{
+				break;
+			}
+		}
+		return value;
+	}
+
+	inline std::int64_t BitReader::readSigned()
+	{
+		const std::uint64_t value = readVarint();
+		return static_cast<std::int64_t>((value >> 1) ^ (~(value & 1) + 1));
+	}
+
+	inline float BitReader::readQuantized(float min, float max,
+	                                      unsigned int bits)
+	{
+		return dequantize(readBits(bits), min, max, bits);
+	}
+
+	inline std::uint16_t BitReader::readSequence()
+	{
+		return static_cast<std::uint16_t>(readBits(16));
+	}
+
+	inline std::size_t BitReader::remaining() const
+	{
+		return m_serializer.remaining() * 8 + m_scratchBits;
+	}
+
+	inline float BitReader::dequantize(std::uint32_t step, float min,
+	                                   float max, unsigned int bits)
+	{
+		const std::uint64_t steps = (std::uint64_t {1} << bits) - 1;
+		const double        t     = static_cast<double>(step) / steps;
+		return static_cast<float>(min + (max - min) * t);
+	}
+
+	inline std::size_t BitReader::unwrapSequence(std::uint16_t sequence,
+	                                             std::size_t   reference)
+	{
+		// the difference to the reference, taken the short way round.
+		const auto difference = static_cast<std::int16_t>(
+		    static_cast<std::uint16_t>(sequence - reference));
+
+		if (difference < 0 &&
+		    reference < static_cast<std::size_t>(-difference))
+		{
+			// there is nothing before 0, so it has to be ahead instead.
+			return reference + difference + 0x10000;
+		}
+		return reference + difference;
+	}
 } // namespace phx
@@ -0,0 +1,164 @@
+// Copyright 2019-20 Genten Studios
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors
+// may be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace phx
+{
+	/**
+	 * @brief A fixed set of worker threads running queued jobs.
+	 *
+	 * Jobs are run in the order they were pushed, by whichever worker is free
+	 * first. Jobs that are still queued when the pool is stopped are dropped,
+	 * anything that must happen on shutdown should not rely on a job.
+	 *
+	 * @paragraph Usage
+	 * @code
+	 * ThreadPool pool(2);
+	 * pool.push([]() { doSomethingSlow(); });
+	 * @endcode
+	 */
+	class ThreadPool
+	{
+	public:
+		using Job = std::function<void()>;
+
+		/**
+		 * @brief Starts the worker threads.
+		 * @param threads The amount of workers, at least one is started.
+		 */
+		explicit ThreadPool(std::size_t threads)
+		{
+			if (threads == 0)
+			{
+				threads = 1;
+			}
+
+			m_threads.reserve(threads);
+			for (std::size_t i = 0; i < threads; ++i)
+			{
+				m_threads.emplace_back(&ThreadPool::work, this);
+			}
+		}
+
+		~ThreadPool() { stop(); }
+
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+
+		/**
+		 * @brief Queues a job to be run by one of the workers.
+		 * @param job The job to run.
+		 */
+		void push(Job job)
+		{
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				if (m_stopping)
+				{
+					return;
+				}
+				m_jobs.push(std::move(job));
+			}
+			m_cond.notify_one();
+		}
+
+		/**
+		 * @brief Gets the amount of jobs waiting for a worker.
+		 * @return The amount of queued jobs, not counting running ones.
+		 */
+		std::size_t getQueueDepth() const
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			return m_jobs.size();
+		}
+
+		std::size_t getThreadCount() const { return m_threads.size(); }
+
+		/**
+		 * @brief Drops any queued jobs and waits for the workers to finish
+		 * the jobs they are running.
+		 */
+		void stop()
+		{
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_stopping = true;
+				m_jobs     = {};
+			}
+			m_cond.notify_all();
+
+			for (std::thread& thread : m_threads)
+			{
+				if (thread.joinable())
+				{
+					thread.join();
+				}
+			}
+		}
+
+	private:
+		void work()
+		{
+			while (true)
+			{
+				Job job;
+				{
+					std::unique_lock<std::mutex> lock(m_mutex);
+					m_cond.wait(lock,
+					            [this] { return m_stopping || !m_jobs.empty(); });
+
+					if (m_stopping)
+					{
+						return;
+					}
+
+					job = std::move(m_jobs.front());
+					m_jobs.pop();
+				}
+
+				job();
+			}
+		}
+
+	private:
+		mutable std::mutex       m_mutex;
+		std::condition_variable  m_cond;
+		std::queue<Job>          m_jobs;
+		std::vector<std::thread> m_threads;
+		bool                     m_stopping = false;
+	};
+} // namespace phx
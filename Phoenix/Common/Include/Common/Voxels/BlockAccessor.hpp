@@ -0,0 +1,161 @@
+// Copyright 2019-20 Genten Studios
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors
+// may be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+/**
+ * @file BlockAccessor.hpp
+ * @brief Cheap repeated block reads from a map.
+ *
+ * @copyright Copyright (c) Genten Studios 2019 - 2020
+ *
+ */
+
+#pragma once
+
+#include <Common/Math/Math.hpp>
+#include <Common/Voxels/Block.hpp>
+#include <Common/Voxels/Chunk.hpp>
+#include <Common/Voxels/ChunkPos.hpp>
+
+#include <vector>
+
+namespace phx::voxels
+{
+	class Map;
+
+	/**
+	 * @brief Reads blocks out of a map, remembering the last chunk it read
+	 * from.
+	 *
+	 * Map::getBlockAt has to find the chunk of every block it is asked for.
+	 * Walks like ray casts, collision checks and mods scanning an area ask
+	 * for many blocks in a row that are almost always in the same chunk, an
+	 * accessor only looks the chunk up again when the walk crosses into
+	 * another one. Positions are whole blocks, so nothing is converted from
+	 * floats along the way.
+	 *
+	 * Blocks in chunks that aren't loaded are read as out of bounds, and
+	 * the chunk is requested from the map like Map::getBlockAt does.
+	 *
+	 * @note An accessor holds on to a chunk pointer, so it is meant to live
+	 * for one walk. Don't keep one across Map::tick or unloading chunks,
+	 * either can free the chunk it remembers.
+	 *
+	 * @paragraph Usage
+	 * @code
+	 * BlockAccessor blocks(map);
+	 * for (int y = 0; y < 64; ++y)
+	 * {
+	 *     if (blocks.getTypeAt({x, y, z})->category == BlockCategory::SOLID)
+	 *     {
+	 *         ...
+	 *     }
+	 * }
+	 *
+	 * std::vector<BlockType*> area;
+	 * blocks.getTypes({0, 0, 0}, {7, 7, 7}, area); // 8x8x8 blocks.
+	 * @endcode
+	 */
+	class BlockAccessor
+	{
+	public:
+		explicit BlockAccessor(Map* map);
+
+		/**
+		 * @brief Gets the block at a position, along with its metadata.
+		 *
+		 * @param block The position of the block.
+		 * @return The block, out of bounds if its chunk isn't loaded.
+		 */
+		Block getBlockAt(const math::vec3i& block);
+
+		/**
+		 * @brief Gets the type of the block at a position.
+		 *
+		 * @param block The position of the block.
+		 * @return The type, out of bounds if its chunk isn't loaded.
+		 *
+		 * Skips looking for metadata, prefer this when only the type is
+		 * needed.
+		 */
+		BlockType* getTypeAt(const math::vec3i& block);
+
+		/**
+		 * @brief Gets the type of every block in a box.
+		 *
+		 * @param min The corner of the box with the lowest coordinates.
+		 * @param max The corner of the box with the highest coordinates,
+		 * the box includes it.
+		 * @param types Replaced with the types of the blocks, with x
+		 * changing fastest then y then z, like inside of a chunk.
+		 *
+		 * Every chunk the box touches is only looked up once. A box with
+		 * any side of max below min is empty.
+		 */
+		void getTypes(const math::vec3i& min, const math::vec3i& max,
+		              std::vector<BlockType*>& types);
+
+		/**
+		 * @brief Gets the chunk a block is in.
+		 *
+		 * @param block The position of the block.
+		 * @return The chunk, or nullptr if it isn't loaded.
+		 */
+		Chunk* getChunkAt(const math::vec3i& block);
+
+		/**
+		 * @brief Forgets the remembered chunk, so the next read looks it
+		 * up again.
+		 */
+		void reset();
+
+	private:
+		/**
+		 * @brief Gets a chunk, only asking the map if it isn't the one
+		 * read from last.
+		 *
+		 * @param pos The chunk.
+		 * @return The chunk, or nullptr if it isn't loaded.
+		 */
+		Chunk* getChunk(const ChunkPos& pos);
+
+		static std::size_t toIndex(const math::vec3i& local)
+		{
+			return Chunk::getVectorIndex(static_cast<std::size_t>(local.x),
+			                             static_cast<std::size_t>(local.y),
+			                             static_cast<std::size_t>(local.z));
+		}
+
+	private:
+		Map*       m_map;
+		BlockType* m_outOfBounds;
+
+		ChunkPos m_chunkPos;
+		Chunk*   m_chunk  = nullptr;
+		bool     m_cached = false;
+	};
+} // namespace phx::voxels
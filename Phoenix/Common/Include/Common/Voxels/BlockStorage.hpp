@@ -0,0 +1,220 @@
+// Copyright 2019-20 Genten Studios
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors
+// may be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+/**
+ * @file BlockStorage.hpp
+ * @brief Paletted, bit-packed storage for the blocks in a chunk.
+ *
+ * @copyright Copyright (c) Genten Studios 2019 - 2020
+ *
+ */
+
+#pragma once
+
+#include <Common/Voxels/Block.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace phx::voxels
+{
+	/**
+	 * @brief Stores a fixed amount of blocks as indices into a small palette.
+	 *
+	 * Rather than storing a pointer for every single block (8 bytes each),
+	 * every *different* block type is stored once in a palette and each block
+	 * only stores an index into that palette. The indices are bit-packed, the
+	 * width growing from 1 to 2, 4, 8 and finally 16 bits as the palette
+	 * grows. A chunk made entirely out of one block (all air, all stone, etc.)
+	 * stores no indices at all, just a palette with one entry.
+	 *
+	 * Index widths are always a power of two, so an index never straddles two
+	 * words of the backing array.
+	 *
+	 * @paragraph Usage
+	 * @code
+	 * BlockStorage storage(4096, air);
+	 * storage.set(10, stone);
+	 *
+	 * storage.get(10); // stone
+	 * storage.get(11); // air
+	 *
+	 * // reading the packed form directly, no pointer chasing per block.
+	 * const auto& palette = storage.getPalette();
+	 * for (std::size_t i = 0; i < storage.size(); ++i)
+	 * {
+	 *     BlockType* block = palette[storage.getPaletteIndex(i)];
+	 * }
+	 * @endcode
+	 */
+	class BlockStorage
+	{
+	public:
+		using PaletteIndex = std::uint16_t;
+		using Palette      = std::vector<BlockType*>;
+
+	public:
+		/**
+		 * @brief Creates storage where every block is the same.
+		 * @param size The amount of blocks being stored.
+		 * @param fill The block every position is filled with.
+		 */
+		BlockStorage(std::size_t size, BlockType* fill);
+
+		~BlockStorage()                         = default;
+		BlockStorage(const BlockStorage& other) = default;
+		BlockStorage& operator=(const BlockStorage& other) = default;
+		BlockStorage(BlockStorage&& other) noexcept        = default;
+		BlockStorage& operator=(BlockStorage&& other) noexcept = default;
+
+		/**
+		 * @brief Gets the block at a position.
+		 * @param index The flattened position of the block.
+		 * @return The block at that position.
+		 */
+		BlockType* get(std::size_t index) const
+		{
+			return m_palette[getPaletteIndex(index)];
+		}
+
+		/**
+		 * @brief Sets the block at a position.
+		 * @param index The flattened position of the block.
+		 * @param block The block to place at that position.
+		 *
+		 * If the block is not yet in the palette, unused palette entries are
+		 * dropped before the index width is grown.
+		 */
+		void set(std::size_t index, BlockType* block);
+
+		/**
+		 * @brief Replaces every block with the same block.
+		 * @param block The block to fill the storage with.
+		 *
+		 * This drops back down to the single value representation.
+		 */
+		void fill(BlockType* block);
+
+		/**
+		 * @brief Gets the palette index stored at a position.
+		 * @param index The flattened position of the block.
+		 * @return The index into the palette for that block.
+		 */
+		PaletteIndex getPaletteIndex(std::size_t index) const
+		{
+			if (m_bitsPerBlock == 0)
+			{
+				return 0;
+			}
+
+			const std::uint64_t word  = m_data[index >> m_indicesShift];
+			const std::size_t   shift = (index & m_indicesMask) * m_bitsPerBlock;
+			return static_cast<PaletteIndex>((word >> shift) & m_valueMask);
+		}
+
+		/**
+		 * @brief Sets the palette index stored at a position.
+		 * @param index The flattened position of the block.
+		 * @param paletteIndex An index previously returned by add().
+		 */
+		void setPaletteIndex(std::size_t index, PaletteIndex paletteIndex);
+
+		/**
+		 * @brief Finds a block in the palette, adding it if required.
+		 * @param block The block to find in the palette.
+		 * @return The index of the block within the palette.
+		 *
+		 * This may widen the stored indices but never reorders the palette,
+		 * so previously returned indices stay valid.
+		 */
+		PaletteIndex add(BlockType* block);
+
+		/**
+		 * @brief Gets the palette used by the stored indices.
+		 * @return The palette, indexed by getPaletteIndex().
+		 */
+		const Palette& getPalette() const { return m_palette; }
+
+		/**
+		 * @brief Gets how many bits are used for each block.
+		 * @return 0 for single value storage, otherwise 1, 2, 4, 8 or 16.
+		 */
+		unsigned int getBitsPerBlock() const { return m_bitsPerBlock; }
+
+		/**
+		 * @brief Checks whether every block is the same.
+		 * @return true if all the blocks share one palette entry.
+		 */
+		bool isSingleValue() const { return m_bitsPerBlock == 0; }
+
+		/**
+		 * @brief Gets the amount of blocks being stored.
+		 * @return The amount of blocks being stored.
+		 */
+		std::size_t size() const { return m_size; }
+
+		/**
+		 * @brief Gets the approximate heap memory this storage is using.
+		 * @return The amount of heap memory in use, in bytes.
+		 */
+		std::size_t getMemoryUsage() const;
+
+	private:
+		/**
+		 * @brief Drops palette entries that are no longer referenced.
+		 *
+		 * This will fall back to the single value representation if only one
+		 * block type remains.
+		 */
+		void compact();
+
+		/**
+		 * @brief Repacks the stored indices with a new width.
+		 * @param bitsPerBlock The new width of each index.
+		 */
+		void repack(unsigned int bitsPerBlock);
+
+		/**
+		 * @brief Gets the smallest supported width for a palette size.
+		 * @param paletteSize The amount of entries in the palette.
+		 * @return The amount of bits needed per block.
+		 */
+		static unsigned int bitsFor(std::size_t paletteSize);
+
+	private:
+		std::size_t                m_size;
+		Palette                    m_palette;
+		std::vector<std::uint64_t> m_data;
+
+		unsigned int  m_bitsPerBlock = 0;
+		unsigned int  m_indicesShift = 0;
+		std::size_t   m_indicesMask  = 0;
+		std::uint64_t m_valueMask    = 0;
+	};
+} // namespace phx::voxels
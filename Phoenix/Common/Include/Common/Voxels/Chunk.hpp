@@ -32,6 +32,7 @@
 #include <Common/Math/Math.hpp>
 #include <Common/Voxels/Block.hpp>
 #include <Common/Voxels/BlockReferrer.hpp>
+#include <Common/Voxels/BlockStorage.hpp>
 #include <Common/Registry.hpp>
 #include <Common/Metadata.hpp>
 
@@ -80,9 +81,6 @@ namespace phx::voxels
 	 */
 	class Chunk : public ISerializable
 	{
-	public:
-		using BlockList = std::vector<BlockType*>;
-		
 	public:
 		Chunk() = delete;
 
@@ -100,11 +98,15 @@ namespace phx::voxels
 		math::vec3 getChunkPos() const;
 
 		/**
-		 * @brief Get a vector of pointers to all the blocks in the chunk.
-		 * @return std::vector<BlockType*>& Vector of pointers to all the
-		 * blocks in the chunk.
+		 * @brief Get the paletted storage of all the blocks in the chunk.
+		 * @return BlockStorage& The storage holding every block in the chunk.
+		 *
+		 * Prefer reading through BlockStorage::getPalette() and
+		 * BlockStorage::getPaletteIndex() when walking the whole chunk, it
+		 * avoids resolving a pointer for every single block.
 		 */
-		BlockList& getBlocks();
+		BlockStorage&       getBlocks();
+		const BlockStorage& getBlocks() const;
 
 		/**
 		 * @brief Gets the Block at the supplied position.
@@ -185,6 +187,16 @@ namespace phx::voxels
 			                      static_cast<std::size_t>(pos.z));
 		}
 
+		/**
+		 * @brief Marks chunks serialized in the binary format.
+		 *
+		 * The binary format is the position, this marker, the palette of
+		 * block IDs, varint encoded runs of palette indices and then any
+		 * metadata. Chunks from before it have the length of the first
+		 * block's ID where the marker is, which is never this large.
+		 */
+		static constexpr std::uint32_t BINARY_FORMAT_MARKER = 0xFFFF0001;
+
 		// serialize.
 		Serializer& operator>>(Serializer& ser) const override;
 
@@ -192,12 +204,16 @@ namespace phx::voxels
 		Serializer& operator<<(Serializer& ser) override;
 
 	private:
-		///@brief Utility function for serialization
-		bool canRepeat(std::size_t i) const;
+		/**
+		 * @brief Reads the string based format chunks used to be saved in.
+		 * @param ser The serializer to read from.
+		 * @param idLength The length of the first block ID, already read.
+		 */
+		void readLegacy(Serializer& ser, std::uint32_t idLength);
 
 	private:
 		math::vec3                                m_pos;
-		BlockList                                 m_blocks;
+		BlockStorage                              m_blocks;
 		std::unordered_map<std::size_t, Metadata> m_metadata;
 		BlockReferrer*                            m_referrer;
 	};
@@ -0,0 +1,150 @@
+// Copyright 2019-20 Genten Studios
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors
+// may be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+/**
+ * @file ChunkPos.hpp
+ * @brief Integer chunk coordinates, for keying chunks in hash maps.
+ *
+ * @copyright Copyright (c) Genten Studios 2019 - 2020
+ *
+ */
+
+#pragma once
+
+#include <Common/Math/Math.hpp>
+#include <Common/Voxels/Chunk.hpp>
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+namespace phx::voxels
+{
+	/**
+	 * @brief The position of a chunk counted in chunks along each axis,
+	 * rather than in blocks like Chunk::getChunkPos.
+	 *
+	 * The chunk at blocks (16, 0, -16) is at (1, 0, -1). Being whole
+	 * numbers, these compare exactly and are cheap to hash.
+	 */
+	using ChunkPos = math::vec3i;
+
+	/**
+	 * @brief 'Hash' parameter to use when keying a hash map by ChunkPos.
+	 *
+	 * Vector3Hasher is made for any vector, this mixes every bit of every
+	 * axis into the low bits as well, which flat hash maps index with.
+	 */
+	struct ChunkPosHasher
+	{
+		std::size_t operator()(const ChunkPos& pos) const
+		{
+			constexpr std::uint64_t golden = 0x9E3779B97F4A7C15ull;
+
+			std::uint64_t hash = static_cast<std::uint32_t>(pos.x);
+			hash = hash * golden + static_cast<std::uint32_t>(pos.y);
+			hash = hash * golden + static_cast<std::uint32_t>(pos.z);
+
+			// the finalizer from splitmix64.
+			hash = (hash ^ (hash >> 30)) * 0xBF58476D1CE4E5B9ull;
+			hash = (hash ^ (hash >> 27)) * 0x94D049BB133111EBull;
+			return static_cast<std::size_t>(hash ^ (hash >> 31));
+		}
+	};
+
+	/**
+	 * @brief Gets the block a position is in.
+	 *
+	 * @param position The position, in blocks.
+	 * @return The block, rounded towards zero like the map always has.
+	 */
+	inline math::vec3i toBlockPos(const math::vec3& position)
+	{
+		return {static_cast<int>(position.x), static_cast<int>(position.y),
+		        static_cast<int>(position.z)};
+	}
+
+	/**
+	 * @brief Gets the chunk a block is in.
+	 *
+	 * @param block The position of the block.
+	 * @return The chunk the block is in.
+	 */
+	inline ChunkPos getChunkPos(const math::vec3i& block)
+	{
+		return {math::floorDiv(block.x, Chunk::CHUNK_WIDTH),
+		        math::floorDiv(block.y, Chunk::CHUNK_HEIGHT),
+		        math::floorDiv(block.z, Chunk::CHUNK_DEPTH)};
+	}
+
+	/**
+	 * @brief Gets the position of a block inside of its chunk.
+	 *
+	 * @param block The position of the block.
+	 * @return The position inside of the chunk, never negative.
+	 */
+	inline math::vec3i getLocalPos(const math::vec3i& block)
+	{
+		return {math::floorMod(block.x, Chunk::CHUNK_WIDTH),
+		        math::floorMod(block.y, Chunk::CHUNK_HEIGHT),
+		        math::floorMod(block.z, Chunk::CHUNK_DEPTH)};
+	}
+
+	/**
+	 * @brief Gets the chunk at a position in blocks, like the one given by
+	 * Chunk::getChunkPos.
+	 *
+	 * @param position The position of the chunk, in blocks.
+	 * @return The chunk.
+	 */
+	inline ChunkPos toChunkPos(const math::vec3& position)
+	{
+		// chunk positions are always a multiple of the chunk size, but round
+		// anyway so float error can't put a chunk in the wrong place.
+		return {static_cast<int>(
+		            std::floor(position.x / Chunk::CHUNK_WIDTH + 0.5f)),
+		        static_cast<int>(
+		            std::floor(position.y / Chunk::CHUNK_HEIGHT + 0.5f)),
+		        static_cast<int>(
+		            std::floor(position.z / Chunk::CHUNK_DEPTH + 0.5f))};
+	}
+
+	/**
+	 * @brief Gets the position of a chunk in blocks, like the one given by
+	 * Chunk::getChunkPos.
+	 *
+	 * @param pos The chunk.
+	 * @return The position of the chunk, in blocks.
+	 */
+	inline math::vec3 toPosition(const ChunkPos& pos)
+	{
+		return {static_cast<float>(pos.x * Chunk::CHUNK_WIDTH),
+		        static_cast<float>(pos.y * Chunk::CHUNK_HEIGHT),
+		        static_cast<float>(pos.z * Chunk::CHUNK_DEPTH)};
+	}
+} // namespace phx::voxels
@@ -0,0 +1,176 @@
+// Copyright 2019-20 Genten Studios
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors
+// may be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+/**
+ * @file ChunkViewTracker.hpp
+ * @brief Tracks which chunks are in range of a moving viewer.
+ *
+ * @copyright Copyright (c) Genten Studios 2019 - 2020
+ *
+ */
+
+#pragma once
+
+#include <Common/Math/Math.hpp>
+#include <Common/Voxels/ChunkPos.hpp>
+
+#include <cstddef>
+#include <functional>
+#include <unordered_set>
+#include <vector>
+
+namespace phx::voxels
+{
+	/**
+	 * @brief Keeps track of the chunks around a viewer, working out which
+	 * chunks to load and unload as it moves.
+	 *
+	 * Chunks are referred to by their ChunkPos, rather than their position
+	 * in blocks. Everything within the view distance of the
+	 * viewer's chunk is wanted, and loaded chunks are kept until they are
+	 * further away than the unload distance.
+	 *
+	 * Only the chunks that cross in or out of range are looked at when the
+	 * viewer moves into another chunk, so a step costs the size of one face
+	 * of the view rather than the whole of it. Chunks are loaded and
+	 * unloaded nearest first.
+	 *
+	 * @paragraph Usage
+	 * @code
+	 * ChunkViewTracker tracker(8, 9);
+	 *
+	 * // every tick.
+	 * tracker.move(playerChunk);
+	 * tracker.load([&](const ChunkPos& index) {
+	 *     return map->getChunk(toPosition(index)) != nullptr;
+	 * });
+	 * for (const ChunkPos& index : tracker.takeUnloaded())
+	 * {
+	 *     map->unloadChunk(toPosition(index));
+	 * }
+	 * @endcode
+	 */
+	class ChunkViewTracker
+	{
+	public:
+		/// @brief Tries to load a chunk, false if it isn't available yet.
+		using Loader = std::function<bool(const ChunkPos&)>;
+
+		using IndexSet = std::unordered_set<ChunkPos, ChunkPosHasher,
+		                                    math::Vector3KeyComparator>;
+
+	public:
+		/**
+		 * @brief Creates a tracker that hasn't been placed anywhere yet.
+		 * @param viewDistance How many chunks away chunks are wanted.
+		 * @param unloadDistance How many chunks away loaded chunks are
+		 * kept, at least the view distance.
+		 */
+		ChunkViewTracker(int viewDistance, int unloadDistance);
+
+		/**
+		 * @brief Moves the viewer, working out which chunks have come into
+		 * and gone out of range.
+		 * @param centre The index of the chunk the viewer is in.
+		 * @return false if the viewer was already in that chunk, nothing
+		 * changes then.
+		 */
+		bool move(const ChunkPos& centre);
+
+		/**
+		 * @brief Tries to load the wanted chunks, nearest first.
+		 * @param loader Called for every wanted chunk until it returns true
+		 * for it, the chunk is loaded from then on.
+		 * @return The amount of chunks that were loaded.
+		 */
+		std::size_t load(const Loader& loader);
+
+		/**
+		 * @brief Takes the loaded chunks that have gone out of range since
+		 * this was last called, nearest first.
+		 * @return The indices of the chunks, which are no longer loaded.
+		 */
+		std::vector<ChunkPos> takeUnloaded();
+
+		/**
+		 * @brief Forgets every loaded and wanted chunk, the next move starts
+		 * from scratch.
+		 */
+		void clear();
+
+		/**
+		 * @brief Gets whether a chunk is close enough to be kept loaded.
+		 * @param index The index of the chunk.
+		 * @return true if it's within the unload distance of the viewer.
+		 */
+		bool isInRange(const ChunkPos& index) const;
+
+		bool isLoaded(const ChunkPos& index) const;
+
+		const IndexSet&              getLoaded() const;
+		const std::vector<ChunkPos>& getWanted() const;
+		const ChunkPos&              getCentre() const;
+
+	private:
+		/**
+		 * @brief A cube of chunks.
+		 */
+		struct Box
+		{
+			ChunkPos min;
+			ChunkPos max;
+
+			bool contains(const ChunkPos& index) const;
+		};
+
+		/**
+		 * @brief Calls a function for every chunk in one box that isn't in
+		 * another, without visiting the chunks they share.
+		 * @param box The chunks to visit.
+		 * @param exclude The chunks to skip.
+		 * @param function Called with the index of each chunk.
+		 */
+		template <typename F>
+		static void forEachOutside(const Box& box, const Box& exclude,
+		                           const F& function);
+
+		Box  around(const ChunkPos& centre, int distance) const;
+		void sortNearestFirst(std::vector<ChunkPos>& indices) const;
+
+	private:
+		int m_viewDistance;
+		int m_unloadDistance;
+
+		bool     m_placed = false;
+		ChunkPos m_centre;
+
+		IndexSet              m_loaded;
+		std::vector<ChunkPos> m_wanted;
+		std::vector<ChunkPos> m_unloaded;
+	};
+} // namespace phx::voxels
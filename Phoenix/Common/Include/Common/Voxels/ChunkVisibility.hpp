@@ -0,0 +1,140 @@
+// Copyright 2019-20 Genten Studios
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors
+// may be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+/**
+ * @file ChunkVisibility.hpp
+ * @brief Which faces of a chunk can see each other, for occlusion culling.
+ *
+ * @copyright Copyright (c) Genten Studios 2019 - 2020
+ *
+ */
+
+#pragma once
+
+#include <Common/Math/Math.hpp>
+#include <Common/Voxels/BlockStorage.hpp>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace phx::voxels
+{
+	/**
+	 * @brief Which faces of a chunk can be seen from which others, looking
+	 * through the blocks that aren't opaque.
+	 *
+	 * Faces are indexed the same as the client's BlockFace: -z, -x, +z, +x,
+	 * +y and then -y. Two faces are connected if a flood fill through the
+	 * blocks that aren't opaque reaches both of them.
+	 *
+	 * Every frame, findVisible walks outwards from the chunk the camera is
+	 * in. A chunk is only entered if the face it was entered through is
+	 * connected to the face it's being left through, and the walk never
+	 * turns back towards the camera. Chunks that are buried behind solid
+	 * rock are never reached, so they don't need to be drawn.
+	 *
+	 * @paragraph Usage
+	 * @code
+	 * // when the chunk is meshed.
+	 * ChunkVisibility visibility =
+	 *     ChunkVisibility::compute(chunk->getBlocks(), opaque);
+	 *
+	 * // every frame.
+	 * std::vector<math::vec3> visible;
+	 * ChunkVisibility::findVisible(cameraChunk, lookup, inView, visible);
+	 * @endcode
+	 */
+	class ChunkVisibility
+	{
+	public:
+		/// @brief Gets the visibility of the chunk at a position, nullptr if
+		/// there isn't one, which stops the walk there.
+		using Lookup = std::function<const ChunkVisibility*(const math::vec3&)>;
+
+		/// @brief Whether a chunk is in view at all, so the walk doesn't go
+		/// through chunks behind the camera.
+		using Filter = std::function<bool(const math::vec3&)>;
+
+		static constexpr std::size_t FACE_COUNT = 6;
+
+	public:
+		/**
+		 * @brief Creates visibility where no faces are connected, like a
+		 * chunk made completely out of opaque blocks.
+		 */
+		ChunkVisibility() = default;
+
+		/**
+		 * @brief Creates visibility where every face is connected, like a
+		 * chunk made completely out of air.
+		 * @return The visibility.
+		 */
+		static ChunkVisibility all();
+
+		/**
+		 * @brief Flood fills a chunk to find which faces are connected.
+		 * @param blocks The blocks of the chunk.
+		 * @param opaque Whether each entry in the palette of the blocks
+		 * hides what is behind it.
+		 * @return The visibility of the chunk.
+		 */
+		static ChunkVisibility compute(const BlockStorage&      blocks,
+		                               const std::vector<bool>& opaque);
+
+		/**
+		 * @brief Finds the chunks that might be visible from a chunk.
+		 * @param start The position of the chunk the camera is in.
+		 * @param lookup Gets the visibility of each chunk.
+		 * @param inView Whether a chunk is in view, empty if all are.
+		 * @param visible Filled with the positions of the chunks that might
+		 * be visible, starting with the camera's chunk.
+		 * @return false if the camera's chunk isn't known, nothing is culled
+		 * in that case and visible is left empty.
+		 */
+		static bool findVisible(const math::vec3& start, const Lookup& lookup,
+		                        const Filter&            inView,
+		                        std::vector<math::vec3>& visible);
+
+		/**
+		 * @brief Gets the face on the other side of the chunk.
+		 * @param face The face to get the opposite of.
+		 * @return The opposite face.
+		 */
+		static std::size_t opposite(std::size_t face);
+
+		void connect(std::size_t from, std::size_t to);
+		bool connects(std::size_t from, std::size_t to) const;
+
+	private:
+		// a bit for each face that each face is connected to.
+		std::array<std::uint8_t, FACE_COUNT> m_connections {};
+	};
+} // namespace phx::voxels
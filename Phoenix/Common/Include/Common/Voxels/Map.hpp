@@ -31,13 +31,23 @@
 #include <Common/Math/Math.hpp>
 #include <Common/Save.hpp>
 #include <Common/Utility/BlockingQueue.hpp>
+#include <Common/Utility/Compression.hpp>
+#include <Common/Utility/FlatHashMap.hpp>
+#include <Common/Utility/ThreadPool.hpp>
 #include <Common/Voxels/BlockReferrer.hpp>
 #include <Common/Voxels/Chunk.hpp>
+#include <Common/Voxels/ChunkPos.hpp>
+#include <Common/Voxels/RegionFile.hpp>
 
+#include <chrono>
 #include <cstddef>
 #include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
 #include <string_view>
 #include <unordered_map>
+#include <unordered_set>
 #include <utility>
 
 namespace phx::voxels
@@ -59,6 +69,41 @@ namespace phx::voxels
 
 		Event                                            type;
 		std::variant<voxels::BlockType*, voxels::Chunk*> data;
+
+		// the block the event happened at, within its chunk.
+		math::vec3 position;
+	};
+
+	/**
+	 * @brief Where a chunk is in the process of being loaded.
+	 */
+	enum class ChunkState
+	{
+		UNLOADED,
+		PENDING,
+		LOADED
+	};
+
+	/**
+	 * @brief Statistics on the asynchronous chunk loading of a map.
+	 *
+	 * Latencies are measured from the chunk first being requested to it being
+	 * published to the map by Map::tick, in milliseconds.
+	 */
+	struct ChunkIOStats
+	{
+		// requests still waiting for a worker thread.
+		std::size_t queued = 0;
+		// requests that have not been published to the map yet.
+		std::size_t pending = 0;
+		// chunks finished by a worker, waiting to be published.
+		std::size_t completed = 0;
+		// chunks published since the map was created.
+		std::size_t published = 0;
+
+		float lastLatency    = 0.f;
+		float averageLatency = 0.f;
+		float maxLatency     = 0.f;
 	};
 
 	class MapEventSubscriber
@@ -70,23 +115,256 @@ namespace phx::voxels
 	class Map
 	{
 	public:
+		/**
+		 * @brief Creates a map backed by a save.
+		 *
+		 * @param save The save the map belongs to.
+		 * @param name The name of the map inside the save.
+		 * @param referrer The blocks that can exist in the map.
+		 * @param ioThreads The amount of threads loading and generating
+		 * chunks in the background. If 0, chunks are loaded on the calling
+		 * thread as soon as they are asked for.
+		 */
 		Map(Save* save, const std::string& name,
-		    voxels::BlockReferrer* referrer);
+		    voxels::BlockReferrer* referrer, std::size_t ioThreads = 0);
 		Map(BlockingQueue<std::pair<math::vec3, std::vector<std::byte>>>* queue,
 		    voxels::BlockReferrer* referrer);
+		~Map();
 
+		Map(const Map&) = delete;
+		Map& operator=(const Map&) = delete;
+
+		/**
+		 * @brief Gets a chunk, requesting it if it isn't loaded.
+		 *
+		 * @param pos The position of the chunk.
+		 * @return The chunk, or nullptr if it isn't available yet.
+		 *
+		 * When loading in the background, a chunk that isn't loaded is
+		 * queued for the worker threads and nullptr is returned until
+		 * tick() has published it, so callers are expected to ask again
+		 * later, like they already do when networked.
+		 */
 		Chunk* getChunk(const math::vec3& pos);
+
+		/**
+		 * @brief Gets whether a chunk is loaded, being loaded or neither.
+		 *
+		 * @param pos The position of the chunk.
+		 * @return The state of the chunk.
+		 */
+		ChunkState getChunkState(const math::vec3& pos) const;
+
+		/**
+		 * @brief Gets a chunk if it is loaded, without requesting it.
+		 *
+		 * @param pos The chunk.
+		 * @return The chunk, or nullptr if it isn't loaded.
+		 */
+		Chunk* findChunk(const ChunkPos& pos) const;
+
+		/**
+		 * @brief Publishes chunks finished by the worker threads and saves
+		 * edited chunks that are due to be written back.
+		 *
+		 * @param budget How long to spend publishing chunks, anything left
+		 * over is published on the next tick.
+		 * @return The amount of chunks published.
+		 */
+		std::size_t tick(std::chrono::microseconds budget);
+
+		/**
+		 * @brief Sets when edited chunks are written back to the save.
+		 *
+		 * @param interval How long a chunk can stay edited before it is
+		 * saved by tick().
+		 * @param maxDirty How many edited chunks can be waiting to be saved
+		 * before the oldest is saved straight away.
+		 *
+		 * Any number of edits to a chunk that is already waiting are saved
+		 * together. An interval and limit of 0 saves on every edit.
+		 */
+		void setWriteBack(std::chrono::milliseconds interval,
+		                  std::size_t               maxDirty);
+
+		/**
+		 * @brief Sets how chunks are compressed when they are saved.
+		 * @param codec The codec to compress with.
+		 * @param level The codec specific level, 0 uses the codec's default.
+		 *
+		 * Saved chunks carry the codec they were written with, so changing
+		 * this never stops older saves from loading.
+		 */
+		void setCompression(data::Codec codec, int level);
+
+		/**
+		 * @brief Saves every edited chunk that is waiting to be saved.
+		 *
+		 * @return false if any chunk failed to save, those chunks stay
+		 * waiting and are tried again later.
+		 */
+		bool flush();
+
+		/**
+		 * @brief Removes a chunk from memory, saving it first if edited.
+		 *
+		 * @param pos The position of the chunk.
+		 * @return false if the chunk is edited and could not be saved, it
+		 * is kept in memory rather than losing the edits.
+		 */
+		bool unloadChunk(const math::vec3& pos);
+
+		/**
+		 * @brief Removes every chunk that isn't needed from memory, saving
+		 * the edited ones first.
+		 *
+		 * @param isNeeded Whether a chunk at a position needs to stay
+		 * loaded.
+		 * @return The amount of chunks that were unloaded, edited chunks
+		 * that could not be saved are kept.
+		 */
+		std::size_t unloadChunks(
+		    const std::function<bool(const math::vec3&)>& isNeeded);
+
+		/**
+		 * @brief Gets the amount of chunks in memory.
+		 *
+		 * @return The amount of loaded chunks.
+		 */
+		std::size_t getLoadedChunkCount() const;
+
+		/**
+		 * @brief Gets roughly how much memory the loaded chunks use.
+		 *
+		 * @return The size of the chunks and their block storage, in bytes.
+		 * Metadata isn't counted.
+		 */
+		std::size_t getMemoryUsage() const;
+
+		/**
+		 * @brief Gets statistics on the background loading of chunks.
+		 *
+		 * @return The current statistics.
+		 */
+		ChunkIOStats getIOStats() const;
+
+		/**
+		 * @brief Gets the blocks that can exist in the map.
+		 *
+		 * @return The block referrer the map was created with.
+		 */
+		BlockReferrer* getReferrer() const;
+
+		/**
+		 * @brief Splits a position into the chunk it's in and where it is
+		 * inside of that chunk.
+		 *
+		 * @param position The position, in blocks.
+		 * @return The position of the chunk and of the block inside of it,
+		 * both in blocks.
+		 */
 		static std::pair<math::vec3, math::vec3> getBlockPos(
 		    math::vec3 position);
 		Block getBlockAt(math::vec3 position);
 		void  setBlockAt(math::vec3 pos, const Block& block);
-		void  save(const math::vec3& pos);
+
+		/**
+		 * @brief Saves a chunk to its region file.
+		 *
+		 * @param pos The position of the chunk.
+		 * @return true if the chunk was written. A chunk that fails to
+		 * save stays waiting to be saved.
+		 */
+		bool save(const math::vec3& pos);
 
 		void registerEventSubscriber(MapEventSubscriber* subscriber);
 
+		/**
+		 * @brief Packs the old one file per chunk saves into region files.
+		 *
+		 * @param save The name of the save to migrate.
+		 * @param mapName The name of the map inside the save.
+		 * @return The amount of chunks that were migrated.
+		 *
+		 * Every migrated chunk file is deleted once it has been written to
+		 * its region, so this can safely be run more than once.
+		 */
+		static std::size_t migrateLegacySaves(const std::string& save,
+		                                      const std::string& mapName);
+
 	private:
+		using Clock = std::chrono::steady_clock;
+
+		// what came of trying to load a chunk from the save.
+		enum class LoadResult
+		{
+			LOADED,
+			// not saved yet, or damaged beyond use, so it's generated.
+			MISSING,
+			// saved with a codec this build can't read. It is left alone,
+			// generating it would save over data another build can read.
+			UNREADABLE
+		};
+
+		// a chunk finished by a worker, waiting to be published. BlockingQueue
+		// copies its elements out, so the chunk is shared rather than unique.
+		struct LoadedChunk
+		{
+			std::shared_ptr<Chunk> chunk;
+			bool                   generated  = false;
+			bool                   unreadable = false;
+			// the request this chunk was loaded for, see PendingChunk.
+			std::size_t generation = 0;
+		};
+
+		// a chunk requested from the worker threads. The generation tells
+		// requests for the same position apart, a result is only published
+		// if its request is still the pending one, so a copy loaded before
+		// the chunk was loaded on this thread, edited and unloaded again is
+		// never brought back.
+		struct PendingChunk
+		{
+			Clock::time_point requested;
+			std::size_t       generation;
+		};
+
 		void dispatchToSubscriber(const MapEvent& mapEvent) const;
 
+		/**
+		 * @brief Get a chunk, loading it on this thread if it isn't loaded.
+		 *
+		 * @param pos The position of the chunk.
+		 * @return The chunk, or nullptr if networked and not received yet or
+		 * if the saved chunk can't be read by this build.
+		 */
+		Chunk* getChunkNow(const math::vec3& pos);
+
+		/**
+		 * @brief Queue a chunk to be loaded by the worker threads.
+		 *
+		 * @param pos The position of the chunk.
+		 */
+		void requestChunk(const math::vec3& pos);
+
+		/**
+		 * @brief Add a chunk to the loaded chunks, saving it if it was just
+		 * generated.
+		 *
+		 * @param chunk The chunk to add.
+		 * @param generated Whether the chunk was generated rather than
+		 * loaded from the save.
+		 * @return The chunk now owned by the map.
+		 */
+		Chunk* publishChunk(Chunk&& chunk, bool generated);
+
+		/**
+		 * @brief Remember that a chunk needs saving, saving the oldest
+		 * edited chunk if too many are waiting.
+		 *
+		 * @param pos The position of the chunk.
+		 */
+		void markDirty(const math::vec3& pos);
+
 		/**
 		 * @brief Update the loaded chunks from the queue of incoming chunks.
 		 */
@@ -95,34 +373,59 @@ namespace phx::voxels
 		/**
 		 * @brief Load a chunk from the save files.
 		 *
-		 * @param chunkPos The coordinates of the chunk.
-		 * @return true if chunk was loaded from save, otherwise false.
+		 * @param chunk The chunk to load into, its position is the one
+		 * loaded.
+		 * @return Whether the chunk was loaded, needs generating or can't be
+		 * used at all.
+		 *
+		 * This is safe to call from the worker threads.
 		 */
-		bool loadChunk(const phx::math::vec3& chunkPos);
+		LoadResult loadChunk(Chunk& chunk);
 
 		/**
-		 * @brief Create a new chunk and write a save file for it.
+		 * @brief Fill in a newly created chunk.
+		 *
+		 * @param chunk The chunk to generate, its position is used to
+		 * decide what to generate.
+		 *
+		 * This is safe to call from the worker threads.
+		 */
+		void generateChunk(Chunk& chunk) const;
+
+		/**
+		 * @brief Get the region file holding a chunk, opening it if needed.
 		 *
 		 * @param chunkPos The coordinates of the chunk.
+		 * @return The region file, or nullptr if it could not be opened.
 		 */
-		void generateChunk(const phx::math::vec3& chunkPos);
+		RegionFile* getRegion(const phx::math::vec3& chunkPos);
 
 		/**
-		 * @brief Get the save filepath for a chunk position.
+		 * @brief Get the filepath of a region file.
 		 *
-		 * @param chunkPos The integer coordinates of the chunk.
+		 * @param save The name of the save.
+		 * @param mapName The name of the map.
+		 * @param regionPos The integer coordinates of the region.
 		 * @return Relative path to the save directory.
 		 */
-		std::filesystem::path toSavePath(
-		    const phx::math::vec3i& chunkPos) const;
+		static std::filesystem::path toRegionPath(
+		    const std::string& save, const std::string& mapName,
+		    const phx::math::vec3i& regionPos);
 
 	private:
-		std::unordered_map<math::vec3, Chunk, math::Vector3Hasher,
-		                   math::Vector3KeyComparator>
+		// the chunks are boxed so they stay put when the table grows, other
+		// things keep pointers to them.
+		FlatHashMap<ChunkPos, std::unique_ptr<Chunk>, ChunkPosHasher,
+		            math::Vector3KeyComparator>
 		    m_chunks;
 
 		BlockReferrer* m_referrer;
 
+		std::unordered_map<math::vec3i, std::unique_ptr<RegionFile>,
+		                   math::Vector3Hasher, math::Vector3KeyComparator>
+		    m_regions;
+		mutable std::mutex m_regionMutex;
+
 		Save*       m_save = nullptr;
 		std::string m_mapName;
 
@@ -130,5 +433,33 @@ namespace phx::voxels
 		    nullptr;
 
 		std::vector<MapEventSubscriber*> m_subscribers;
+
+		// chunks that have been requested from the worker threads.
+		std::unordered_map<math::vec3, PendingChunk, math::Vector3Hasher,
+		                   math::Vector3KeyComparator>
+		    m_pending;
+		std::size_t                m_nextGeneration = 0;
+		BlockingQueue<LoadedChunk> m_completed;
+		ChunkIOStats               m_stats;
+
+		// chunks that can't be read by this build, they are never loaded
+		// (and so never saved over) rather than tried again on every access.
+		std::unordered_set<math::vec3, math::Vector3Hasher,
+		                   math::Vector3KeyComparator>
+		    m_unreadable;
+
+		// edited chunks waiting to be saved, and when they were first edited.
+		std::unordered_map<math::vec3, Clock::time_point, math::Vector3Hasher,
+		                   math::Vector3KeyComparator>
+		    m_dirty;
+		std::chrono::milliseconds m_flushInterval {5000};
+		std::size_t               m_maxDirty = 64;
+
+		data::Codec m_codec            = data::Codec::DEFLATE;
+		int         m_compressionLevel = 1;
+
+		// declared last so the workers are stopped before anything they
+		// use is destroyed.
+		std::unique_ptr<ThreadPool> m_pool;
 	};
 } // namespace phx::voxels
@@ -0,0 +1,193 @@
+// Copyright 2019-20 Genten Studios
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors
+// may be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+/**
+ * @file RegionFile.hpp
+ * @brief Container file holding the saves of a cube of chunks.
+ *
+ * @copyright Copyright (c) Genten Studios 2019 - 2020
+ *
+ */
+
+#pragma once
+
+#include <Common/Math/Math.hpp>
+#include <Common/Utility/Internal/SharedTypes.hpp>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <vector>
+
+namespace phx::voxels
+{
+	/**
+	 * @brief A single file holding the saves of REGION_SIZE^3 chunks.
+	 *
+	 * Keeping one file per chunk turns a large world into hundreds of
+	 * thousands of tiny files, and every load pays for an open, seek, read
+	 * and close. A region keeps a cube of chunks in one file that stays open:
+	 *
+	 * - The first sector holds a magic number and the format version.
+	 * - The next sectors hold a table with a (first sector, byte length)
+	 *   pair for every chunk in the region. A length of 0 means the chunk
+	 *   has never been saved.
+	 * - Every chunk payload starts on a sector boundary and takes up as many
+	 *   whole sectors as it needs. Since version 2 every payload is a
+	 *   data::Compression frame, the region itself never looks inside them.
+	 *
+	 * A chunk is rewritten in place while it still fits the sectors it
+	 * already has, otherwise it moves to the first free run of sectors big
+	 * enough for it, or to the end of the file.
+	 *
+	 * All integers in the header are stored in network (big endian) order.
+	 * Reading and writing is thread safe.
+	 *
+	 * @paragraph Usage
+	 * @code
+	 * RegionFile region("Saves/save1/map1.0_0_0.region");
+	 *
+	 * const std::size_t index = RegionFile::toLocalIndex({1, 2, 3});
+	 * region.write(index, serializer.getBuffer());
+	 *
+	 * data::Data data;
+	 * if (region.read(index, data))
+	 * {
+	 *     // use data.
+	 * }
+	 * @endcode
+	 */
+	class RegionFile
+	{
+	public:
+		// amount of chunks along each axis of a region.
+		static constexpr int         REGION_SIZE = 16;
+		static constexpr std::size_t REGION_MAX_CHUNKS =
+		    REGION_SIZE * REGION_SIZE * REGION_SIZE;
+
+		static constexpr std::size_t SECTOR_SIZE = 4096;
+
+		// one sector for the magic number and version, followed by the table.
+		static constexpr std::size_t HEADER_SECTORS =
+		    1 + (REGION_MAX_CHUNKS * 2 * sizeof(std::uint32_t)) / SECTOR_SIZE;
+
+		static constexpr std::uint32_t MAGIC   = 0x50485852; // "PHXR"
+		static constexpr std::uint32_t VERSION = 2;
+
+	public:
+		/**
+		 * @brief Opens a region file, creates it if it doesn't exist yet.
+		 * @param path The path of the region file.
+		 *
+		 * If the file exists but has an invalid header, it is treated as
+		 * empty and will be overwritten as chunks are saved to it. Version 1
+		 * files are upgraded by wrapping their payloads in frames, written to
+		 * a new file that replaces the old one once it is complete.
+		 */
+		explicit RegionFile(const std::filesystem::path& path);
+		~RegionFile();
+
+		RegionFile(const RegionFile&) = delete;
+		RegionFile& operator=(const RegionFile&) = delete;
+
+		/**
+		 * @brief Whether the file could be opened.
+		 * @return true if the file can be read from and written to.
+		 */
+		bool isOpen() const;
+
+		/**
+		 * @brief Whether a chunk has been saved to this region.
+		 * @param index The index of the chunk inside the region.
+		 * @return true if the chunk has been saved before.
+		 */
+		bool has(std::size_t index) const;
+
+		/**
+		 * @brief Reads the saved data of a chunk.
+		 * @param index The index of the chunk inside the region.
+		 * @param data The buffer to read the data into.
+		 * @return true if the chunk was saved and could be read.
+		 */
+		bool read(std::size_t index, data::Data& data);
+
+		/**
+		 * @brief Writes the data of a chunk.
+		 * @param index The index of the chunk inside the region.
+		 * @param data The serialized chunk.
+		 * @return true if the data was written.
+		 */
+		bool write(std::size_t index, const data::Data& data);
+
+		/**
+		 * @brief Flushes any buffered writes to disk.
+		 */
+		void flush();
+
+		/**
+		 * @brief Gets the position of the region holding a chunk.
+		 * @param chunkIndex The position of the chunk, in chunks (not blocks).
+		 * @return The position of the region, in regions.
+		 */
+		static math::vec3i toRegionPos(const math::vec3i& chunkIndex);
+
+		/**
+		 * @brief Gets the index of a chunk inside its region.
+		 * @param chunkIndex The position of the chunk, in chunks (not blocks).
+		 * @return The index of the chunk inside the region's table.
+		 */
+		static std::size_t toLocalIndex(const math::vec3i& chunkIndex);
+
+	private:
+		struct Entry
+		{
+			std::uint32_t sector = 0;
+			std::uint32_t length = 0;
+		};
+
+		static std::size_t sectorsFor(std::size_t length);
+
+		std::uint32_t readHeader();
+		void          upgradeFromVersion1(const std::filesystem::path& path);
+		void          writeHeader();
+		void          writeEntry(std::size_t index);
+		std::uint32_t allocate(std::size_t sectors);
+		void markSectors(std::uint32_t sector, std::size_t count, bool used);
+
+	private:
+		mutable std::mutex                    m_mutex;
+		std::fstream                          m_file;
+		std::array<Entry, REGION_MAX_CHUNKS> m_entries;
+
+		// one flag for every sector in the file, header included.
+		std::vector<bool> m_usedSectors;
+	};
+} // namespace phx::voxels
@@ -32,6 +32,9 @@
 #include <Common/PlayerView.hpp>
 #include <Common/Position.hpp>
 #include <Common/Voxels/Block.hpp>
+#include <Common/Voxels/BlockAccessor.hpp>
+
+#include <optional>
 
 using namespace phx;
 
@@ -49,9 +52,9 @@ void ActorSystem::tick(entt::registry* registry, entt::entity entity,
 {
 	auto& pos = registry->get<Position>(entity);
 
-	/// conversion from 1/1000 of degrees to rad
-	pos.rotation.x = static_cast<float>(input.rotation.x) / 360000.0;
-	pos.rotation.y = static_cast<float>(input.rotation.y) / 360000.0;
+	const math::vec3 rotation = input.getRotation();
+	pos.rotation.x            = rotation.x;
+	pos.rotation.y            = rotation.y;
 	const auto moveSpeed =
 	    static_cast<float>(registry->get<Movement>(entity).moveSpeed);
 
@@ -83,63 +86,85 @@ void ActorSystem::tick(entt::registry* registry, entt::entity entity,
 	}
 }
 
-static const float RAY_INCREMENT = 0.5f;
-
-math::Ray ActorSystem::getTarget(entt::registry* registry, entt::entity entity)
+namespace
 {
-	math::vec3   pos = (registry->get<Position>(entity).position / 2.f) + .5f;
-	voxels::Map* map = registry->get<PlayerView>(entity).map;
-
-	math::Ray ray(pos, registry->get<Position>(entity).getDirection());
+	// where the eyes of an actor are, in blocks.
+	math::vec3 getEye(const Position& position)
+	{
+		return position.position / 2.f + .5f;
+	}
 
-	while (ray.getLength() < m_reach)
+	math::RayHit castTarget(voxels::BlockAccessor& blocks,
+	                        const Position&        position)
 	{
-		pos.floor();
+		const auto isSolid = [&blocks](const math::vec3i& block) {
+			return blocks.getTypeAt(block)->category ==
+			       voxels::BlockCategory::SOLID;
+		};
+
+		return math::Ray(getEye(position), position.getDirection())
+		    .traverse(ActorSystem::m_reach, isSolid);
+	}
+} // namespace
 
-		if (map->getBlockAt(pos).type->category == voxels::BlockCategory::SOLID)
+math::RayHit ActorSystem::getTarget(entt::registry* registry,
+                                    entt::entity    entity)
+{
+	voxels::BlockAccessor blocks(registry->get<PlayerView>(entity).map);
+	return castTarget(blocks, registry->get<Position>(entity));
+}
+
+std::vector<math::RayHit> ActorSystem::getTargets(
+    entt::registry* registry, const std::vector<entt::entity>& entities)
+{
+	std::vector<math::RayHit> targets;
+	targets.reserve(entities.size());
+
+	// actors near each other look through the same chunks, so one accessor
+	// is shared for as long as the actors are in the same map.
+	voxels::Map*                         map = nullptr;
+	std::optional<voxels::BlockAccessor> blocks;
+	for (const entt::entity entity : entities)
+	{
+		voxels::Map* actorMap = registry->get<PlayerView>(entity).map;
+		if (!blocks || actorMap != map)
 		{
-			return ray;
+			map = actorMap;
+			blocks.emplace(map);
 		}
 
-		pos = ray.advance(RAY_INCREMENT);
+		targets.push_back(castTarget(*blocks, registry->get<Position>(entity)));
 	}
 
-	return ray;
+	return targets;
 }
 
 bool ActorSystem::action1(voxels::BlockReferrer* blockReferrer,
                           entt::registry* registry, entt::entity entity)
 {
-	math::vec3   pos = (registry->get<Position>(entity).position / 2.f) + .5f;
-	voxels::Map* map = registry->get<PlayerView>(entity).map;
-
-	math::Ray ray(pos, registry->get<Position>(entity).getDirection());
+	const Position&       position = registry->get<Position>(entity);
+	voxels::Map*          map      = registry->get<PlayerView>(entity).map;
+	voxels::BlockAccessor blocks(map);
 
 	Hand         hand = registry->get<Hand>(entity);
 	voxels::Item item = hand.getHand();
 
-	while (ray.getLength() < m_reach)
+	const math::RayHit target = castTarget(blocks, position);
+	if (target.hit)
 	{
-		pos.floor();
-
-		const auto* currentBlock = map->getBlockAt(pos).type;
-		if (currentBlock->category == voxels::BlockCategory::SOLID)
+		const math::vec3 pos(target.block);
+		if (item.type)
 		{
-			if (item.type)
+			if (item.type->onPrimary)
 			{
-				if (item.type->onPrimary)
-				{
-					item.type->onPrimary(pos);
-					return true;
-				}
+				item.type->onPrimary(pos);
+				return true;
 			}
-			map->setBlockAt(
-			    pos, {blockReferrer->blocks.get(voxels::BlockType::AIR_BLOCK),
-			          nullptr});
-			return true;
 		}
-
-		pos = ray.advance(RAY_INCREMENT);
+		map->setBlockAt(
+		    pos, {blockReferrer->blocks.get(voxels::BlockType::AIR_BLOCK),
+		          nullptr});
+		return true;
 	}
 	/* TODO: This doesn't feel right but IDK how to get the position to the
 	 * callback otherwise
@@ -148,7 +173,8 @@ bool ActorSystem::action1(voxels::BlockReferrer* blockReferrer,
 	{
 		if (item.type->onPrimary)
 		{
-			item.type->onPrimary(pos);
+			item.type->onPrimary(getEye(position) +
+			                     position.getDirection() * m_reach);
 			return true;
 		}
 	}
@@ -158,9 +184,11 @@ bool ActorSystem::action1(voxels::BlockReferrer* blockReferrer,
 bool ActorSystem::action2(voxels::BlockReferrer* blockReferrer,
                           entt::registry* registry, entt::entity entity)
 {
-	math::vec3 pos = (registry->get<Position>(entity).position / 2.f) + .5f;
-	const math::vec3& dir = registry->get<Position>(entity).getDirection();
-	voxels::Map*      map = registry->get<PlayerView>(entity).map;
+	const Position&   position = registry->get<Position>(entity);
+	const math::vec3& dir      = position.getDirection();
+	voxels::Map*      map      = registry->get<PlayerView>(entity).map;
+
+	voxels::BlockAccessor blocks(map);
 
 	Hand         hand = registry->get<Hand>(entity);
 	voxels::Item item = hand.getHand();
@@ -169,62 +197,54 @@ bool ActorSystem::action2(voxels::BlockReferrer* blockReferrer,
 		return false;
 	}
 
-	math::Ray ray(pos, dir);
-
-	while (ray.getLength() < m_reach)
+	const math::RayHit target = castTarget(blocks, position);
+	if (target.hit)
 	{
-		pos.floor();
-
-		const auto currentBlock = map->getBlockAt(pos).type;
-		if (currentBlock->category == voxels::BlockCategory::SOLID)
+		// the block is placed against the face the ray went in through.
+		const math::vec3 back(target.block + target.normal);
+		if (!item.type->places.empty() && target.normal != math::vec3i {})
 		{
-			math::vec3 back = ray.backtrace(RAY_INCREMENT);
-			back.floor();
-			if (!item.type->places.empty())
+			if (!m_creative)
 			{
-				if (!m_creative)
+				hand.inventory->removeItem(hand.getHandSlot(), false);
+			}
+			voxels::Block block {blockReferrer->getByID(item.type->places),
+			                     nullptr};
+			Metadata      data;
+			if (block.type->rotH)
+			{
+				math::vec3 rotation;
+				if (dir.x > 0)
 				{
-					hand.inventory->removeItem(hand.getHandSlot(), false);
+					rotation.x += 180;
 				}
-				voxels::Block block {blockReferrer->getByID(item.type->places),
-				                     nullptr};
-				Metadata      data;
-				if (block.type->rotH)
+				if (dir.z > 0)
 				{
-					math::vec3 rotation;
-					if (dir.x > 0)
-					{
-						rotation.x += 180;
-					}
-					if (dir.z > 0)
-					{
-						rotation.x += 90;
-					}
-					if (rotation.x > 0)
-					{
-						data.set("core.rotation", rotation);
-					}
+					rotation.x += 90;
 				}
-				if (data.size() > 0)
+				if (rotation.x > 0)
 				{
-					block.metadata = &data;
+					data.set("core.rotation", rotation);
 				}
-
-				map->setBlockAt(back, block);
 			}
-			if (item.type->onSecondary)
+			if (data.size() > 0)
 			{
-				item.type->onSecondary(back);
+				block.metadata = &data;
 			}
 
-			return true;
+			map->setBlockAt(back, block);
+		}
+		if (item.type->onSecondary)
+		{
+			item.type->onSecondary(back);
 		}
 
-		pos = ray.advance(RAY_INCREMENT);
+		return true;
 	}
+
 	if (item.type->onSecondary)
 	{
-		item.type->onSecondary(pos);
+		item.type->onSecondary(getEye(position) + dir * m_reach);
 	}
 
 	return false;
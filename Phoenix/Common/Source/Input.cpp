@@ -28,14 +28,210 @@
 
 #include <Common/Input.hpp>
 
-phx::Serializer& phx::InputState::operator>>(Serializer& serializer) const
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+using namespace phx;
+
+namespace
+{
+	constexpr unsigned int KEY_BITS      = 6;
+	constexpr unsigned int COUNT_BITS    = 5;
+	constexpr std::size_t  SEQUENCE_MASK = 0xFFFF;
+
+	constexpr float TWO_PI = math::PI * 2.f;
+
+	// every state after the newest starts with the keys that changed since
+	// the state after it, and whether anything else did.
+	constexpr unsigned int ROTATED = 1 << 0;
+	constexpr unsigned int SKIPPED = 1 << 1;
+
+	std::uint32_t getKeys(const InputState& state)
+	{
+		return static_cast<std::uint32_t>(
+		    state.forward << 0 | state.backward << 1 | state.left << 2 |
+		    state.right << 3 | state.up << 4 | state.down << 5);
+	}
+
+	void setKeys(InputState& state, std::uint32_t keys)
+	{
+		state.forward  = (keys & 1 << 0) != 0;
+		state.backward = (keys & 1 << 1) != 0;
+		state.left     = (keys & 1 << 2) != 0;
+		state.right    = (keys & 1 << 3) != 0;
+		state.up       = (keys & 1 << 4) != 0;
+		state.down     = (keys & 1 << 5) != 0;
+	}
+
+	// rotations are steps of 16 bits, so the difference between two is
+	// taken the short way around.
+	std::int16_t getTurn(std::int32_t from, std::int32_t to)
+	{
+		return static_cast<std::int16_t>(static_cast<std::uint16_t>(to - from));
+	}
+
+	std::int32_t turn(std::int32_t from, std::int64_t by)
+	{
+		return static_cast<std::int32_t>((from + by) & 0xFFFF);
+	}
+
+	void writeState(BitWriter& bits, const InputState& state)
+	{
+		bits.writeSequence(static_cast<std::uint16_t>(state.sequence));
+		bits.writeBits(getKeys(state), KEY_BITS);
+		bits.writeBits(state.rotation.x, InputState::ROTATION_BITS);
+		bits.writeBits(state.rotation.y, InputState::ROTATION_BITS);
+	}
+
+	void readState(BitReader& bits, InputState& state)
+	{
+		state.sequence = bits.readSequence();
+		setKeys(state, bits.readBits(KEY_BITS));
+		state.rotation.x =
+		    static_cast<std::int32_t>(bits.readBits(InputState::ROTATION_BITS));
+		state.rotation.y =
+		    static_cast<std::int32_t>(bits.readBits(InputState::ROTATION_BITS));
+	}
+} // namespace
+
+void InputState::setRotation(const math::vec3& angles)
+{
+	float yaw = std::fmod(angles.x, TWO_PI);
+	if (yaw < 0.f)
+	{
+		yaw += TWO_PI;
+	}
+
+	rotation.x = static_cast<std::int32_t>(
+	    BitWriter::quantize(yaw, 0.f, TWO_PI, ROTATION_BITS));
+	rotation.y = static_cast<std::int32_t>(BitWriter::quantize(
+	    angles.y, -math::PIDIV2, math::PIDIV2, ROTATION_BITS));
+}
+
+phx::math::vec3 InputState::getRotation() const
+{
+	return {BitReader::dequantize(static_cast<std::uint32_t>(rotation.x), 0.f,
+	                              TWO_PI, ROTATION_BITS),
+	        BitReader::dequantize(static_cast<std::uint32_t>(rotation.y),
+	                              -math::PIDIV2, math::PIDIV2, ROTATION_BITS),
+	        0.f};
+}
+
+Serializer& InputState::operator>>(Serializer& serializer) const
+{
+	BitWriter bits(serializer);
+	writeState(bits, *this);
+	return serializer;
+}
+
+Serializer& InputState::operator<<(Serializer& serializer)
 {
-	return serializer << forward << backward << left << right << up << down
-	                  << rotation.x << rotation.y << sequence;
+	BitReader bits(serializer);
+	readState(bits, *this);
+	return serializer;
 }
 
-phx::Serializer& phx::InputState::operator<<(Serializer& serializer)
+Serializer& InputBatch::operator>>(Serializer& serializer) const
 {
-	return serializer >> forward >> backward >> left >> right >> up >> down >>
-	       rotation.x >> rotation.y >> sequence;
+	const std::size_t count = std::min(states.size(), MAX_STATES);
+	if (count == 0)
+	{
+		return serializer;
+	}
+
+	BitWriter bits(serializer);
+	bits.writeBits(static_cast<std::uint32_t>(count - 1), COUNT_BITS);
+	writeState(bits, states.front());
+
+	for (std::size_t i = 1; i < count; ++i)
+	{
+		const InputState& newer = states[i - 1];
+		const InputState& state = states[i];
+
+		bits.writeBits(getKeys(state) ^ getKeys(newer), KEY_BITS);
+
+		unsigned int flags = 0;
+		if (state.rotation.x != newer.rotation.x ||
+		    state.rotation.y != newer.rotation.y)
+		{
+			flags |= ROTATED;
+		}
+
+		// states are normally captured one sequence apart.
+		const std::size_t gap = newer.sequence - state.sequence;
+		if (gap != 1)
+		{
+			flags |= SKIPPED;
+		}
+
+		bits.writeBits(flags, 2);
+		if ((flags & SKIPPED) != 0)
+		{
+			bits.writeVarint(gap & SEQUENCE_MASK);
+		}
+		if ((flags & ROTATED) != 0)
+		{
+			bits.writeSigned(getTurn(newer.rotation.x, state.rotation.x));
+			bits.writeSigned(getTurn(newer.rotation.y, state.rotation.y));
+		}
+	}
+
+	return serializer;
+}
+
+Serializer& InputBatch::operator<<(Serializer& serializer)
+{
+	states.clear();
+	if (serializer.empty())
+	{
+		return serializer;
+	}
+
+	BitReader         bits(serializer);
+	const std::size_t count = bits.readBits(COUNT_BITS) + 1;
+
+	InputState state;
+	readState(bits, state);
+
+	states.reserve(count);
+	states.push_back(state);
+
+	for (std::size_t i = 1; i < count; ++i)
+	{
+		const std::uint32_t changed = bits.readBits(KEY_BITS);
+		const std::uint32_t flags   = bits.readBits(2);
+
+		std::uint64_t gap = 1;
+		if ((flags & SKIPPED) != 0)
+		{
+			gap = bits.readVarint();
+		}
+
+		// a batch that goes back further than the receiver could unwrap is
+		// damaged.
+		if (gap == 0 || gap > SEQUENCE_MASK / 2)
+		{
+			states.clear();
+			return serializer;
+		}
+
+		state.sequence = (state.sequence - gap) & SEQUENCE_MASK;
+		setKeys(state, getKeys(state) ^ changed);
+
+		if ((flags & ROTATED) != 0)
+		{
+			state.rotation.x = turn(state.rotation.x, bits.readSigned());
+			state.rotation.y = turn(state.rotation.y, bits.readSigned());
+		}
+
+		states.push_back(state);
+	}
+
+	if (bits.overflowed())
+	{
+		states.clear();
+	}
+
+	return serializer;
 }
@@ -0,0 +1,167 @@
+// Copyright 2019-20 Genten Studios
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors
+// may be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include <Common/Math/Frustum.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+#define INDEX_2D(x, y) (x + ((y) *4))
+
+using namespace phx::math;
+
+void PackedBoxes::push(const vec3& min)
+{
+	x.push_back(min.x);
+	y.push_back(min.y);
+	z.push_back(min.z);
+}
+
+void PackedBoxes::clear()
+{
+	x.clear();
+	y.clear();
+	z.clear();
+}
+
+std::size_t PackedBoxes::size() const { return x.size(); }
+
+Frustum::Frustum()
+{
+	for (auto& plane : m_planes)
+	{
+		plane[0] = 0.f;
+		plane[1] = 0.f;
+		plane[2] = 0.f;
+		plane[3] = 1.f;
+	}
+}
+
+Frustum::Frustum(const detail::Matrix4x4& viewProjection)
+{
+	const float* m = viewProjection.elements;
+
+	// a point is inside when -w <= x, y, z <= w after being transformed, so
+	// each plane is the last row plus or minus one of the others.
+	for (int i = 0; i < 6; ++i)
+	{
+		const int   row  = i / 2;
+		const float sign = i % 2 == 0 ? 1.f : -1.f;
+
+		float length = 0.f;
+		for (int column = 0; column < 4; ++column)
+		{
+			m_planes[i][column] = m[INDEX_2D(3, column)] +
+			                      sign * m[INDEX_2D(row, column)];
+
+			if (column < 3)
+			{
+				length += m_planes[i][column] * m_planes[i][column];
+			}
+		}
+
+		// normalized so distances to the planes are in world units.
+		length = std::sqrt(length);
+		if (length > 0.f)
+		{
+			for (float& component : m_planes[i])
+			{
+				component /= length;
+			}
+		}
+	}
+}
+
+bool Frustum::intersects(const vec3& min, const vec3& max) const
+{
+	for (const auto& plane : m_planes)
+	{
+		// the corner of the box furthest along the plane's normal, if even
+		// that is outside then so is the rest of the box.
+		const float x = plane[0] >= 0.f ? max.x : min.x;
+		const float y = plane[1] >= 0.f ? max.y : min.y;
+		const float z = plane[2] >= 0.f ? max.z : min.z;
+
+		if (plane[0] * x + plane[1] * y + plane[2] * z + plane[3] < 0.f)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+std::size_t Frustum::cull(const PackedBoxes&         boxes,
+                          std::vector<std::uint8_t>& visible) const
+{
+	const std::size_t count = boxes.size();
+	visible.resize(count);
+
+	// every box has the same size, so the corner furthest along a plane's
+	// normal is always the same distance from the minimum corner, and only
+	// the minimum corner has to be checked against each plane.
+	float a[6];
+	float b[6];
+	float c[6];
+	float d[6];
+	for (int i = 0; i < 6; ++i)
+	{
+		a[i] = m_planes[i][0];
+		b[i] = m_planes[i][1];
+		c[i] = m_planes[i][2];
+		d[i] = std::max(a[i], 0.f) * boxes.extent.x +
+		       std::max(b[i], 0.f) * boxes.extent.y +
+		       std::max(c[i], 0.f) * boxes.extent.z + m_planes[i][3];
+	}
+
+	const float* x = boxes.x.data();
+	const float* y = boxes.y.data();
+	const float* z = boxes.z.data();
+
+	std::uint8_t* out = visible.data();
+
+	// no branches, so the loop can be vectorized.
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		bool inside = true;
+		for (int j = 0; j < 6; ++j)
+		{
+			inside &= a[j] * x[i] + b[j] * y[i] + c[j] * z[i] + d[j] >= 0.f;
+		}
+
+		out[i] = inside ? 1 : 0;
+	}
+
+	std::size_t inside = 0;
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		inside += out[i];
+	}
+
+	return inside;
+}
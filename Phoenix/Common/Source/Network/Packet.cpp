@@ -29,14 +29,75 @@
 #include <Common/Logger.hpp>
 #include <Common/Network/Packet.hpp>
 
+#include <cstring>
+#include <mutex>
+
 using namespace phx::net;
 
+namespace
+{
+	// the buffers of sent packets, waiting to be written into again.
+	constexpr std::size_t MAX_POOLED_BUFFERS = 64;
+	// big buffers, like the ones chunks are sent in, aren't worth holding on
+	// to for the small packets sent every tick.
+	constexpr std::size_t MAX_POOLED_CAPACITY = 16 * 1024;
+
+	std::mutex                poolMutex;
+	std::vector<Packet::Data> pool;
+
+	void releaseBuffer(ENetPacket* packet)
+	{
+		auto* buffer     = static_cast<Packet::Data*>(packet->userData);
+		packet->userData = nullptr;
+
+		// this can be called from whichever thread ENet destroys the packet
+		// on, so the pool is locked.
+		if (buffer->capacity() <= MAX_POOLED_CAPACITY)
+		{
+			std::lock_guard<std::mutex> lock(poolMutex);
+			if (pool.size() < MAX_POOLED_BUFFERS)
+			{
+				buffer->clear();
+				pool.push_back(std::move(*buffer));
+			}
+		}
+
+		delete buffer;
+	}
+
+	// the buffer a packet was given if it was made from one, otherwise the
+	// data is owned by ENet.
+	Packet::Data* getBuffer(ENetPacket* packet)
+	{
+		if (packet->freeCallback != &releaseBuffer)
+		{
+			return nullptr;
+		}
+
+		return static_cast<Packet::Data*>(packet->userData);
+	}
+} // namespace
+
 Packet::Packet(const Data& data, PacketFlags flags)
 {
 	// unreliable is fake just cos so removing it.
 	create(data, flags & ~PacketFlags::UNRELIABLE);
 }
 
+Packet::Packet(Data&& data, PacketFlags flags)
+{
+	auto* buffer = new Data(std::move(data));
+
+	// ENet points at the buffer rather than copying it, the buffer is only
+	// let go of once ENet destroys the packet.
+	m_packet = enet_packet_create(
+	    buffer->data(), buffer->size(),
+	    static_cast<enet_uint32>(flags & ~PacketFlags::UNRELIABLE) |
+	        ENET_PACKET_FLAG_NO_ALLOCATE);
+	m_packet->userData     = buffer;
+	m_packet->freeCallback = &releaseBuffer;
+}
+
 Packet::Packet(std::size_t size, PacketFlags flags)
     : Packet(*enet_packet_create(
           nullptr, size,
@@ -67,13 +128,12 @@ void Packet::setData(const Data& data)
 
 	if (data.size() != m_packet->dataLength)
 	{
-		enet_packet_resize(m_packet, data.size());
+		resize(data.size());
 	}
 
-	for (std::size_t i = 0; i < data.size(); ++i)
+	if (!data.empty())
 	{
-		enet_uint8* ptr = m_packet->data + i;
-		*ptr            = static_cast<enet_uint8>(data[i]);
+		std::memcpy(m_packet->data, data.data(), data.size());
 	}
 }
 
@@ -98,6 +158,11 @@ Packet::Data Packet::getData() const
 	    reinterpret_cast<std::byte*>(m_packet->data + m_packet->dataLength)};
 }
 
+const std::byte* Packet::getRawData() const
+{
+	return reinterpret_cast<const std::byte*>(m_packet->data);
+}
+
 void Packet::resize(std::size_t size)
 {
 	if (m_sent)
@@ -107,6 +172,17 @@ void Packet::resize(std::size_t size)
 		return;
 	}
 
+	// ENet won't grow data it doesn't own, so a packet made from a buffer
+	// resizes the buffer itself.
+	Data* buffer = getBuffer(m_packet);
+	if (buffer != nullptr)
+	{
+		buffer->resize(size);
+		m_packet->data       = reinterpret_cast<enet_uint8*>(buffer->data());
+		m_packet->dataLength = size;
+		return;
+	}
+
 	enet_packet_resize(m_packet, size);
 }
 
@@ -114,6 +190,19 @@ std::size_t Packet::getSize() const { return m_packet->dataLength; }
 
 void Packet::prepareForSend() { m_sent = true; }
 
+Packet::Data Packet::acquireBuffer()
+{
+	std::lock_guard<std::mutex> lock(poolMutex);
+	if (pool.empty())
+	{
+		return {};
+	}
+
+	Data buffer = std::move(pool.back());
+	pool.pop_back();
+	return buffer;
+}
+
 void Packet::create(const Data& data, PacketFlags flags)
 {
 	m_packet = enet_packet_create(data.data(), data.size(),
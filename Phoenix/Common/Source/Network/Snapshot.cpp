@@ -0,0 +1,405 @@
+// Copyright 2019-20 Genten Studios
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors
+// may be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include <Common/Network/Snapshot.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+using namespace phx::net;
+using namespace phx;
+
+namespace
+{
+	// a changed entity is written as its ID, these flags, and then the
+	// difference on every axis that has a flag.
+	constexpr std::uint32_t NEW_ENTITY = 1 << 6;
+	constexpr unsigned int  FLAG_BITS  = 7;
+	constexpr int           AXES       = 6;
+
+	// a baseline is always one of the last HISTORY snapshots.
+	constexpr unsigned int AGE_BITS = 6;
+	static_assert(SnapshotSender::HISTORY < 1 << AGE_BITS,
+	              "The age of a baseline has to fit in its bits.");
+
+	// the fewest bits a change or removal can be written in.
+	constexpr std::size_t CHANGE_BITS = 8 + FLAG_BITS;
+	constexpr std::size_t REMOVE_BITS = 8;
+
+	void getAxes(const EntityState& state, std::int32_t (&axes)[AXES])
+	{
+		axes[0] = state.position.x;
+		axes[1] = state.position.y;
+		axes[2] = state.position.z;
+		axes[3] = state.rotation.x;
+		axes[4] = state.rotation.y;
+		axes[5] = state.rotation.z;
+	}
+
+	void setAxes(EntityState& state, const std::int32_t (&axes)[AXES])
+	{
+		state.position = {axes[0], axes[1], axes[2]};
+		state.rotation = {axes[3], axes[4], axes[5]};
+	}
+
+	std::vector<EntityState>::const_iterator findEntity(
+	    const std::vector<EntityState>& entities, std::uint32_t id)
+	{
+		const auto it = std::lower_bound(
+		    entities.begin(), entities.end(), id,
+		    [](const EntityState& entity, std::uint32_t value) {
+			    return entity.id < value;
+		    });
+
+		return it != entities.end() && it->id == id ? it : entities.end();
+	}
+
+	const Snapshot* findTick(const std::deque<Snapshot>& history,
+	                         std::uint32_t               tick)
+	{
+		for (const Snapshot& snapshot : history)
+		{
+			if (snapshot.tick == tick)
+			{
+				return &snapshot;
+			}
+		}
+		return nullptr;
+	}
+
+	void writeSnapshot(const Snapshot* baseline, const Snapshot& snapshot,
+	                   BitWriter& bits)
+	{
+		bits.writeVarint(snapshot.tick);
+		bits.writeBits(baseline != nullptr ? snapshot.tick - baseline->tick : 0,
+		               AGE_BITS);
+		bits.writeSequence(static_cast<std::uint16_t>(snapshot.sequence));
+		bits.writeVarint(snapshot.self);
+
+		static const std::vector<EntityState> none;
+		const std::vector<EntityState>&       before =
+		    baseline != nullptr ? baseline->entities : none;
+		const std::vector<EntityState>& after = snapshot.entities;
+
+		// both lists are sorted by ID, so walking them together finds the
+		// changed, new and removed entities.
+		std::vector<std::pair<const EntityState*, const EntityState*>> changed;
+		std::vector<std::uint32_t>                                     removed;
+		auto old = before.begin();
+		for (const EntityState& entity : after)
+		{
+			while (old != before.end() && old->id < entity.id)
+			{
+				removed.push_back(old->id);
+				++old;
+			}
+
+			if (old != before.end() && old->id == entity.id)
+			{
+				if (!(*old == entity))
+				{
+					changed.emplace_back(&*old, &entity);
+				}
+				++old;
+			}
+			else
+			{
+				changed.emplace_back(nullptr, &entity);
+			}
+		}
+		for (; old != before.end(); ++old)
+		{
+			removed.push_back(old->id);
+		}
+
+		bits.writeVarint(changed.size());
+		std::uint32_t previous = 0;
+		for (const auto& change : changed)
+		{
+			static const EntityState zero;
+			std::int32_t             from[AXES];
+			std::int32_t             to[AXES];
+			getAxes(change.first != nullptr ? *change.first : zero, from);
+			getAxes(*change.second, to);
+
+			std::uint32_t flags = change.first != nullptr ? 0 : NEW_ENTITY;
+			for (int axis = 0; axis < AXES; ++axis)
+			{
+				if (from[axis] != to[axis])
+				{
+					flags |= 1 << axis;
+				}
+			}
+
+			bits.writeVarint(change.second->id - previous);
+			previous = change.second->id;
+
+			bits.writeBits(flags, FLAG_BITS);
+			for (int axis = 0; axis < AXES; ++axis)
+			{
+				if ((flags & (1 << axis)) != 0)
+				{
+					bits.writeSigned(std::int64_t {to[axis]} - from[axis]);
+				}
+			}
+		}
+
+		bits.writeVarint(removed.size());
+		previous = 0;
+		for (const std::uint32_t id : removed)
+		{
+			bits.writeVarint(id - previous);
+			previous = id;
+		}
+	}
+
+	bool readSnapshot(const Snapshot* baseline, Snapshot& snapshot,
+	                  BitReader& bits)
+	{
+		snapshot.sequence = bits.readSequence();
+		snapshot.self     = static_cast<std::uint32_t>(bits.readVarint());
+
+		static const std::vector<EntityState> none;
+		const std::vector<EntityState>&       before =
+		    baseline != nullptr ? baseline->entities : none;
+
+		// a count larger than the changes that could fit in the rest of the
+		// packet can only come from a corrupt one.
+		const std::uint64_t changeCount = bits.readVarint();
+		if (changeCount > bits.remaining() / CHANGE_BITS)
+		{
+			return false;
+		}
+
+		std::vector<EntityState> changed;
+		changed.reserve(static_cast<std::size_t>(changeCount));
+		std::uint32_t previous = 0;
+		for (std::uint64_t i = 0; i < changeCount; ++i)
+		{
+			const auto id =
+			    static_cast<std::uint32_t>(previous + bits.readVarint());
+			if (i > 0 && id <= previous)
+			{
+				return false;
+			}
+			previous = id;
+
+			const std::uint32_t flags = bits.readBits(FLAG_BITS);
+
+			EntityState entity;
+			if ((flags & NEW_ENTITY) == 0)
+			{
+				const auto it = findEntity(before, id);
+				if (it == before.end())
+				{
+					return false;
+				}
+				entity = *it;
+			}
+			entity.id = id;
+
+			std::int32_t axes[AXES];
+			getAxes(entity, axes);
+			for (int axis = 0; axis < AXES; ++axis)
+			{
+				if ((flags & (1 << axis)) != 0)
+				{
+					axes[axis] += static_cast<std::int32_t>(bits.readSigned());
+				}
+			}
+			setAxes(entity, axes);
+
+			changed.push_back(entity);
+		}
+
+		const std::uint64_t removeCount = bits.readVarint();
+		if (removeCount > bits.remaining() / REMOVE_BITS)
+		{
+			return false;
+		}
+
+		std::vector<std::uint32_t> removed;
+		removed.reserve(static_cast<std::size_t>(removeCount));
+		previous = 0;
+		for (std::uint64_t i = 0; i < removeCount; ++i)
+		{
+			previous += static_cast<std::uint32_t>(bits.readVarint());
+			removed.push_back(previous);
+		}
+
+		// the entities of the baseline that weren't changed or removed,
+		// merged with the changed ones, keeps everything sorted by ID.
+		snapshot.entities.clear();
+		snapshot.entities.reserve(before.size() + changed.size());
+		auto change = changed.begin();
+		auto remove = removed.begin();
+		for (const EntityState& entity : before)
+		{
+			while (change != changed.end() && change->id < entity.id)
+			{
+				snapshot.entities.push_back(*change++);
+			}
+			while (remove != removed.end() && *remove < entity.id)
+			{
+				++remove;
+			}
+
+			if (change != changed.end() && change->id == entity.id)
+			{
+				snapshot.entities.push_back(*change++);
+			}
+			else if (remove == removed.end() || *remove != entity.id)
+			{
+				snapshot.entities.push_back(entity);
+			}
+		}
+		snapshot.entities.insert(snapshot.entities.end(), change,
+		                         changed.end());
+
+		return true;
+	}
+} // namespace
+
+EntityState EntityState::quantize(std::uint32_t id, const Position& position)
+{
+	const auto scale = [](float value, float steps) {
+		return static_cast<std::int32_t>(std::lround(value * steps));
+	};
+
+	EntityState state;
+	state.id       = id;
+	state.position = {scale(position.position.x, POSITION_SCALE),
+	                  scale(position.position.y, POSITION_SCALE),
+	                  scale(position.position.z, POSITION_SCALE)};
+	state.rotation = {scale(position.rotation.x, ROTATION_SCALE),
+	                  scale(position.rotation.y, ROTATION_SCALE),
+	                  scale(position.rotation.z, ROTATION_SCALE)};
+	return state;
+}
+
+Position EntityState::dequantize() const
+{
+	Position state;
+	state.position = {position.x / POSITION_SCALE, position.y / POSITION_SCALE,
+	                  position.z / POSITION_SCALE};
+	state.rotation = {rotation.x / ROTATION_SCALE, rotation.y / ROTATION_SCALE,
+	                  rotation.z / ROTATION_SCALE};
+	return state;
+}
+
+const EntityState* Snapshot::find(std::uint32_t id) const
+{
+	const auto it = findEntity(entities, id);
+	return it != entities.end() ? &*it : nullptr;
+}
+
+void SnapshotSender::write(Snapshot snapshot, Serializer& ser)
+{
+	snapshot.tick = ++m_tick;
+
+	// if the acknowledged snapshot has fallen out of the history, the whole
+	// snapshot is sent until the client catches up.
+	BitWriter bits(ser);
+	writeSnapshot(findTick(m_history, m_acknowledged), snapshot, bits);
+	bits.flush();
+
+	m_history.push_back(std::move(snapshot));
+	if (m_history.size() > HISTORY)
+	{
+		m_history.pop_front();
+	}
+}
+
+void SnapshotSender::acknowledge(std::uint32_t tick)
+{
+	if (tick <= m_acknowledged || tick > m_tick)
+	{
+		return;
+	}
+
+	m_acknowledged = tick;
+
+	// deltas are only ever written against the newest acknowledgement.
+	while (!m_history.empty() && m_history.front().tick < tick)
+	{
+		m_history.pop_front();
+	}
+}
+
+bool SnapshotReceiver::read(Serializer& ser)
+{
+	Snapshot  snapshot;
+	BitReader bits(ser);
+
+	snapshot.tick           = static_cast<std::uint32_t>(bits.readVarint());
+	const std::uint32_t age = bits.readBits(AGE_BITS);
+
+	if (snapshot.tick == 0 || age > snapshot.tick)
+	{
+		return false;
+	}
+
+	// unreliable packets can turn up late, the newer snapshot already
+	// replaced this one.
+	if (!m_history.empty() && snapshot.tick <= m_history.back().tick)
+	{
+		return false;
+	}
+
+	const Snapshot* baseline = nullptr;
+	if (age != 0)
+	{
+		baseline = findTick(m_history, snapshot.tick - age);
+		if (baseline == nullptr)
+		{
+			return false;
+		}
+	}
+
+	if (!readSnapshot(baseline, snapshot, bits) || bits.overflowed())
+	{
+		return false;
+	}
+
+	m_history.push_back(std::move(snapshot));
+	if (m_history.size() > SnapshotSender::HISTORY)
+	{
+		m_history.pop_front();
+	}
+	return true;
+}
+
+const Snapshot* SnapshotReceiver::getLatest() const
+{
+	return m_history.empty() ? nullptr : &m_history.back();
+}
+
+std::uint32_t SnapshotReceiver::getAcknowledgement() const
+{
+	return m_history.empty() ? 0 : m_history.back().tick;
+}
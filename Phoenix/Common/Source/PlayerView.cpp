@@ -38,58 +38,50 @@ std::vector<voxels::Chunk*> PlayerView::update(entt::registry* registry,
 
 	PlayerView& view = registry->get<PlayerView>(entity);
 
-	// this gets the raw player position in voxel-world coordinates.
-	math::vec3 playerPos =
-	    (registry->get<Position>(entity).position / 2.f) + 0.5f;
-	const int posX = static_cast<int>(playerPos.x) / voxels::Chunk::CHUNK_WIDTH;
-	const int posY =
-	    static_cast<int>(playerPos.y) / voxels::Chunk::CHUNK_HEIGHT;
-	const int posZ = static_cast<int>(playerPos.z) / voxels::Chunk::CHUNK_DEPTH;
+	// only the chunks that crossed into view are looked at when the player
+	// moves into another chunk.
+	view.tracker.move(getChunkPos(registry, entity));
+
+	view.tracker.load([&view, &newChunks](const voxels::ChunkPos& pos) {
+		voxels::Chunk* chunk = view.map->getChunk(voxels::toPosition(pos));
+		if (chunk != nullptr)
+		{
+			newChunks.push_back(chunk);
+		}
+		return chunk != nullptr;
+	});
 
-	// TODO move this to a config or add as a parameter
-	const int viewDistance = 3;
+	return newChunks;
+}
 
-	// TODO remove chunks that are out of view
+std::vector<math::vec3> PlayerView::evict(entt::registry* registry,
+                                          entt::entity    entity)
+{
+	PlayerView& view = registry->get<PlayerView>(entity);
+	view.tracker.move(getChunkPos(registry, entity));
 
-	for (int x = -viewDistance; x <= viewDistance; x++)
+	std::vector<math::vec3> evicted;
+	for (const voxels::ChunkPos& pos : view.tracker.takeUnloaded())
 	{
-		for (int y = -viewDistance; y <= viewDistance; y++)
-		{
-			for (int z = -viewDistance; z <= viewDistance; z++)
-			{
-				math::vec3 chunkToCheck = {static_cast<float>(x + posX),
-				                           static_cast<float>(y + posY),
-				                           static_cast<float>(z + posZ)};
+		evicted.push_back(voxels::toPosition(pos));
+	}
 
-				// this will allow it to work if we choose to make chunks non cube.
-				chunkToCheck =
-				    chunkToCheck * math::vec3 {voxels::Chunk::CHUNK_WIDTH,
-				                               voxels::Chunk::CHUNK_HEIGHT,
-				                               voxels::Chunk::CHUNK_DEPTH};
-				
-				bool hasChunk = false;
-				for (const auto chunk : view.chunks)
-				{
-					if (chunk == chunkToCheck)
-					{
-						hasChunk = true;
-						break;
-					}
-				}
+	return evicted;
+}
 
-				if (!hasChunk)
-				{
-					voxels::Chunk* chunk = view.map->getChunk(chunkToCheck);
-					if (chunk != nullptr)
-					{
-						view.chunks.emplace_back(chunkToCheck);
-						newChunks.emplace_back(
-						    view.map->getChunk(chunkToCheck));
-					}
-				}
-			}
-		}
-	}
+bool PlayerView::isInRange(entt::registry* registry, entt::entity entity,
+                           const math::vec3& chunkPos)
+{
+	return registry->get<PlayerView>(entity).tracker.isInRange(
+	    voxels::toChunkPos(chunkPos));
+}
 
-	return newChunks;
+voxels::ChunkPos PlayerView::getChunkPos(entt::registry* registry,
+                                         entt::entity    entity)
+{
+	// this gets the raw player position in voxel-world coordinates.
+	math::vec3 playerPos =
+	    (registry->get<Position>(entity).position / 2.f) + 0.5f;
+
+	return voxels::getChunkPos(voxels::toBlockPos(playerPos));
 }
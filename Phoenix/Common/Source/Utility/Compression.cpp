@@ -0,0 +1,198 @@
+// Copyright 2019-20 Genten Studios
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors
+// may be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include <Common/Logger.hpp>
+#include <Common/Utility/Compression.hpp>
+#include <Common/Utility/Internal/Endian.hpp>
+
+#include <cstring>
+
+#ifdef PHX_HAS_ZLIB
+#	include <zlib.h>
+#endif
+
+using namespace phx::data;
+
+namespace
+{
+	void writeHeader(Data& frame, Codec codec, std::size_t rawSize)
+	{
+		const std::uint32_t size =
+		    endian::swapForNetwork(static_cast<std::uint32_t>(rawSize));
+
+		frame[0] = static_cast<std::byte>(codec);
+		std::memcpy(frame.data() + 1, &size, sizeof(size));
+	}
+
+	Data storeFrame(const std::byte* data, std::size_t size)
+	{
+		Data frame(Compression::HEADER_SIZE + size);
+		writeHeader(frame, Codec::NONE, size);
+		std::memcpy(frame.data() + Compression::HEADER_SIZE, data, size);
+		return frame;
+	}
+} // namespace
+
+Data Compression::compress(const std::byte* data, std::size_t size,
+                           Codec codec, int level)
+{
+	if (size > MAX_RAW_SIZE || !isSupported(codec))
+	{
+		return storeFrame(data, size);
+	}
+
+	switch (codec)
+	{
+#ifdef PHX_HAS_ZLIB
+	case Codec::DEFLATE:
+	{
+		uLongf compressedSize = compressBound(static_cast<uLong>(size));
+
+		Data frame(HEADER_SIZE + compressedSize);
+		const int result = compress2(
+		    reinterpret_cast<Bytef*>(frame.data() + HEADER_SIZE),
+		    &compressedSize, reinterpret_cast<const Bytef*>(data),
+		    static_cast<uLong>(size), level == 0 ? Z_DEFAULT_COMPRESSION : level);
+
+		// not worth it if it didn't get any smaller.
+		if (result != Z_OK || compressedSize >= size)
+		{
+			return storeFrame(data, size);
+		}
+
+		frame.resize(HEADER_SIZE + compressedSize);
+		writeHeader(frame, Codec::DEFLATE, size);
+		return frame;
+	}
+#endif
+	default:
+		return storeFrame(data, size);
+	}
+}
+
+Data Compression::compress(const Data& data, Codec codec, int level)
+{
+	return compress(data.data(), data.size(), codec, level);
+}
+
+FrameStatus Compression::decompress(const std::byte* frame, std::size_t size,
+                                    Data& data)
+{
+	if (size < HEADER_SIZE)
+	{
+		return FrameStatus::DAMAGED;
+	}
+
+	const Codec   codec = static_cast<Codec>(frame[0]);
+	std::uint32_t rawSize;
+	std::memcpy(&rawSize, frame + 1, sizeof(rawSize));
+	rawSize = endian::swapForHost(rawSize);
+
+	if (rawSize > MAX_RAW_SIZE)
+	{
+		return FrameStatus::DAMAGED;
+	}
+
+	const std::byte*  payload     = frame + HEADER_SIZE;
+	const std::size_t payloadSize = size - HEADER_SIZE;
+
+	switch (codec)
+	{
+	case Codec::NONE:
+		if (payloadSize != rawSize)
+		{
+			return FrameStatus::DAMAGED;
+		}
+
+		data.assign(payload, payload + payloadSize);
+		return FrameStatus::OK;
+#ifdef PHX_HAS_ZLIB
+	case Codec::DEFLATE:
+	{
+		data.resize(rawSize);
+
+		uLongf    inflatedSize = rawSize;
+		const int result =
+		    uncompress(reinterpret_cast<Bytef*>(data.data()), &inflatedSize,
+		               reinterpret_cast<const Bytef*>(payload),
+		               static_cast<uLong>(payloadSize));
+
+		return result == Z_OK && inflatedSize == rawSize
+		           ? FrameStatus::OK
+		           : FrameStatus::DAMAGED;
+	}
+#endif
+	default:
+		LOG_WARNING("COMPRESSION")
+		    << "Cannot decompress a frame using unsupported codec "
+		    << static_cast<int>(codec);
+		return FrameStatus::UNSUPPORTED;
+	}
+}
+
+bool Compression::isSupported(Codec codec)
+{
+	return (getSupportedCodecs() & (1u << static_cast<unsigned int>(codec))) !=
+	       0;
+}
+
+std::uint32_t Compression::getSupportedCodecs()
+{
+	std::uint32_t codecs = 1u << static_cast<unsigned int>(Codec::NONE);
+#ifdef PHX_HAS_ZLIB
+	codecs |= 1u << static_cast<unsigned int>(Codec::DEFLATE);
+#endif
+	return codecs;
+}
+
+Codec Compression::negotiate(std::uint32_t peerCodecs)
+{
+	const std::uint32_t shared = peerCodecs & getSupportedCodecs();
+	if ((shared & (1u << static_cast<unsigned int>(Codec::DEFLATE))) != 0)
+	{
+		return Codec::DEFLATE;
+	}
+
+	return Codec::NONE;
+}
+
+Codec Compression::fromName(const std::string& name)
+{
+	if (name == "deflate")
+	{
+		return Codec::DEFLATE;
+	}
+
+	if (name != "none")
+	{
+		LOG_WARNING("COMPRESSION") << "Unknown codec " << name
+		                           << ", chunks will not be compressed.";
+	}
+
+	return Codec::NONE;
+}
@@ -0,0 +1,164 @@
+// Copyright 2019-20 Genten Studios
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors
+// may be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include <Common/Voxels/BlockAccessor.hpp>
+#include <Common/Voxels/Map.hpp>
+
+#include <algorithm>
+
+using namespace phx::voxels;
+using namespace phx;
+
+BlockAccessor::BlockAccessor(Map* map)
+    : m_map(map),
+      m_outOfBounds(
+          map->getReferrer()->blocks.get(BlockType::OUT_OF_BOUNDS_BLOCK))
+{
+}
+
+Block BlockAccessor::getBlockAt(const math::vec3i& block)
+{
+	Chunk* chunk = getChunk(voxels::getChunkPos(block));
+	if (chunk == nullptr)
+	{
+		return {m_outOfBounds, nullptr};
+	}
+
+	return chunk->getBlockAt(toIndex(getLocalPos(block)));
+}
+
+BlockType* BlockAccessor::getTypeAt(const math::vec3i& block)
+{
+	Chunk* chunk = getChunk(voxels::getChunkPos(block));
+	if (chunk == nullptr)
+	{
+		return m_outOfBounds;
+	}
+
+	return chunk->getBlocks().get(toIndex(getLocalPos(block)));
+}
+
+void BlockAccessor::getTypes(const math::vec3i& min, const math::vec3i& max,
+                             std::vector<BlockType*>& types)
+{
+	types.clear();
+	if (max.x < min.x || max.y < min.y || max.z < min.z)
+	{
+		return;
+	}
+
+	const std::size_t width  = static_cast<std::size_t>(max.x - min.x) + 1;
+	const std::size_t height = static_cast<std::size_t>(max.y - min.y) + 1;
+	const std::size_t depth  = static_cast<std::size_t>(max.z - min.z) + 1;
+	types.resize(width * height * depth);
+
+	// go chunk by chunk, so each is only looked up once and the blocks
+	// inside of it are read straight out of its palette.
+	const ChunkPos first = voxels::getChunkPos(min);
+	const ChunkPos last  = voxels::getChunkPos(max);
+	for (int cz = first.z; cz <= last.z; ++cz)
+	{
+		for (int cy = first.y; cy <= last.y; ++cy)
+		{
+			for (int cx = first.x; cx <= last.x; ++cx)
+			{
+				Chunk* chunk = getChunk({cx, cy, cz});
+
+				const math::vec3i origin = {cx * Chunk::CHUNK_WIDTH,
+				                            cy * Chunk::CHUNK_HEIGHT,
+				                            cz * Chunk::CHUNK_DEPTH};
+
+				// the part of the box inside of this chunk.
+				const math::vec3i from = {std::max(min.x, origin.x),
+				                          std::max(min.y, origin.y),
+				                          std::max(min.z, origin.z)};
+				const math::vec3i to = {
+				    std::min(max.x, origin.x + Chunk::CHUNK_WIDTH - 1),
+				    std::min(max.y, origin.y + Chunk::CHUNK_HEIGHT - 1),
+				    std::min(max.z, origin.z + Chunk::CHUNK_DEPTH - 1)};
+				const int run = to.x - from.x + 1;
+
+				for (int z = from.z; z <= to.z; ++z)
+				{
+					for (int y = from.y; y <= to.y; ++y)
+					{
+						auto out = types.begin() + (from.x - min.x) +
+						           width * ((y - min.y) + height * (z - min.z));
+
+						if (chunk == nullptr)
+						{
+							std::fill_n(out, run, m_outOfBounds);
+							continue;
+						}
+
+						const BlockStorage& blocks  = chunk->getBlocks();
+						const auto&         palette = blocks.getPalette();
+
+						const std::size_t index = toIndex(
+						    {from.x - origin.x, y - origin.y, z - origin.z});
+						for (int x = 0; x < run; ++x)
+						{
+							out[x] = palette[blocks.getPaletteIndex(index + x)];
+						}
+					}
+				}
+			}
+		}
+	}
+}
+
+Chunk* BlockAccessor::getChunkAt(const math::vec3i& block)
+{
+	return getChunk(voxels::getChunkPos(block));
+}
+
+void BlockAccessor::reset()
+{
+	m_chunk  = nullptr;
+	m_cached = false;
+}
+
+Chunk* BlockAccessor::getChunk(const ChunkPos& pos)
+{
+	if (m_cached && pos == m_chunkPos)
+	{
+		return m_chunk;
+	}
+
+	m_chunk = m_map->findChunk(pos);
+	if (m_chunk == nullptr)
+	{
+		// asks for the chunk to be loaded, and loads it straight away if the
+		// map doesn't load in the background.
+		m_chunk = m_map->getChunk(toPosition(pos));
+	}
+
+	m_chunkPos = pos;
+	m_cached   = true;
+	return m_chunk;
+}
@@ -0,0 +1,218 @@
+// Copyright 2019-20 Genten Studios
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors
+// may be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include <Common/Voxels/BlockStorage.hpp>
+
+#include <algorithm>
+
+using namespace phx::voxels;
+
+BlockStorage::BlockStorage(std::size_t size, BlockType* fill) : m_size(size)
+{
+	m_palette.push_back(fill);
+}
+
+void BlockStorage::set(std::size_t index, BlockType* block)
+{
+	const auto it = std::find(m_palette.begin(), m_palette.end(), block);
+	if (it != m_palette.end())
+	{
+		setPaletteIndex(index, static_cast<PaletteIndex>(
+		                           std::distance(m_palette.begin(), it)));
+		return;
+	}
+
+	// the palette is about to need wider indices, try to make space by
+	// getting rid of blocks that have since been overwritten first.
+	if (m_palette.size() >= (std::size_t(1) << m_bitsPerBlock))
+	{
+		compact();
+	}
+
+	setPaletteIndex(index, add(block));
+}
+
+void BlockStorage::fill(BlockType* block)
+{
+	m_palette.clear();
+	m_palette.push_back(block);
+
+	m_data.clear();
+	m_data.shrink_to_fit();
+
+	m_bitsPerBlock = 0;
+	m_indicesShift = 0;
+	m_indicesMask  = 0;
+	m_valueMask    = 0;
+}
+
+void BlockStorage::setPaletteIndex(std::size_t index, PaletteIndex paletteIndex)
+{
+	if (m_bitsPerBlock == 0)
+	{
+		// single value storage, there is only one possible index.
+		return;
+	}
+
+	std::uint64_t&    word  = m_data[index >> m_indicesShift];
+	const std::size_t shift = (index & m_indicesMask) * m_bitsPerBlock;
+
+	word &= ~(m_valueMask << shift);
+	word |= (static_cast<std::uint64_t>(paletteIndex) & m_valueMask) << shift;
+}
+
+BlockStorage::PaletteIndex BlockStorage::add(BlockType* block)
+{
+	const auto it = std::find(m_palette.begin(), m_palette.end(), block);
+	if (it != m_palette.end())
+	{
+		return static_cast<PaletteIndex>(std::distance(m_palette.begin(), it));
+	}
+
+	m_palette.push_back(block);
+
+	const unsigned int bits = bitsFor(m_palette.size());
+	if (bits != m_bitsPerBlock)
+	{
+		repack(bits);
+	}
+
+	return static_cast<PaletteIndex>(m_palette.size() - 1);
+}
+
+std::size_t BlockStorage::getMemoryUsage() const
+{
+	return sizeof(BlockStorage) + m_palette.capacity() * sizeof(BlockType*) +
+	       m_data.capacity() * sizeof(std::uint64_t);
+}
+
+void BlockStorage::compact()
+{
+	if (m_bitsPerBlock == 0)
+	{
+		return;
+	}
+
+	std::vector<bool> used(m_palette.size(), false);
+	for (std::size_t i = 0; i < m_size; ++i)
+	{
+		used[getPaletteIndex(i)] = true;
+	}
+
+	// map old palette indices onto their new position.
+	std::vector<PaletteIndex> remap(m_palette.size(), 0);
+	Palette                   palette;
+	for (std::size_t i = 0; i < m_palette.size(); ++i)
+	{
+		if (used[i])
+		{
+			remap[i] = static_cast<PaletteIndex>(palette.size());
+			palette.push_back(m_palette[i]);
+		}
+	}
+
+	if (palette.size() == m_palette.size())
+	{
+		// nothing to get rid of.
+		return;
+	}
+
+	if (palette.size() == 1)
+	{
+		fill(palette.front());
+		return;
+	}
+
+	std::vector<PaletteIndex> indices(m_size);
+	for (std::size_t i = 0; i < m_size; ++i)
+	{
+		indices[i] = remap[getPaletteIndex(i)];
+	}
+
+	m_palette = std::move(palette);
+	repack(bitsFor(m_palette.size()));
+
+	for (std::size_t i = 0; i < m_size; ++i)
+	{
+		setPaletteIndex(i, indices[i]);
+	}
+}
+
+void BlockStorage::repack(unsigned int bitsPerBlock)
+{
+	// keep hold of the old layout so we can read from it while writing.
+	const std::vector<std::uint64_t> oldData        = std::move(m_data);
+	const unsigned int               oldBitsPerBlock = m_bitsPerBlock;
+	const unsigned int               oldIndicesShift = m_indicesShift;
+	const std::size_t                oldIndicesMask  = m_indicesMask;
+	const std::uint64_t              oldValueMask    = m_valueMask;
+
+	// an index width of a power of two always divides a 64 bit word evenly.
+	const std::size_t indicesPerWord = 64 / bitsPerBlock;
+
+	m_bitsPerBlock = bitsPerBlock;
+	m_indicesShift = 0;
+	while ((std::size_t(1) << m_indicesShift) < indicesPerWord)
+	{
+		++m_indicesShift;
+	}
+	m_indicesMask = indicesPerWord - 1;
+	m_valueMask   = (std::uint64_t(1) << bitsPerBlock) - 1;
+
+	m_data.assign((m_size + indicesPerWord - 1) / indicesPerWord, 0);
+
+	if (oldBitsPerBlock == 0)
+	{
+		// everything was index 0, which is what we just zeroed to.
+		return;
+	}
+
+	for (std::size_t i = 0; i < m_size; ++i)
+	{
+		const std::uint64_t word  = oldData[i >> oldIndicesShift];
+		const std::size_t   shift = (i & oldIndicesMask) * oldBitsPerBlock;
+		setPaletteIndex(
+		    i, static_cast<PaletteIndex>((word >> shift) & oldValueMask));
+	}
+}
+
+unsigned int BlockStorage::bitsFor(std::size_t paletteSize)
+{
+	if (paletteSize <= 1)
+		return 0;
+	if (paletteSize <= 2)
+		return 1;
+	if (paletteSize <= 4)
+		return 2;
+	if (paletteSize <= 16)
+		return 4;
+	if (paletteSize <= 256)
+		return 8;
+
+	return 16;
+}
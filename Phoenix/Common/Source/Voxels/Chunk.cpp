@@ -29,16 +29,21 @@
 #include <Common/Logger.hpp>
 #include <Common/Voxels/Chunk.hpp>
 
+#include <algorithm>
+#include <cstdint>
+
 using namespace phx::voxels;
 
 Chunk::Chunk(const phx::math::vec3& chunkPos, BlockReferrer* referrer)
-    : m_pos(chunkPos), m_referrer(referrer)
+    : m_pos(chunkPos),
+      m_blocks(CHUNK_MAX_BLOCKS, referrer->blocks.get(BlockType::AIR_BLOCK)),
+      m_referrer(referrer)
 {
-	m_blocks.reserve(CHUNK_WIDTH * CHUNK_HEIGHT * CHUNK_DEPTH);
 }
 
-phx::math::vec3   Chunk::getChunkPos() const { return m_pos; }
-Chunk::BlockList& Chunk::getBlocks() { return m_blocks; }
+phx::math::vec3     Chunk::getChunkPos() const { return m_pos; }
+BlockStorage&       Chunk::getBlocks() { return m_blocks; }
+const BlockStorage& Chunk::getBlocks() const { return m_blocks; }
 
 Block Chunk::getBlockAt(std::size_t index)
 {
@@ -46,9 +51,9 @@ Block Chunk::getBlockAt(std::size_t index)
 	{
 		if (m_metadata.find(index) != m_metadata.end())
 		{
-			return {m_blocks[index], &m_metadata.at(index)};
+			return {m_blocks.get(index), &m_metadata.at(index)};
 		}
-		return {m_blocks[index], nullptr};
+		return {m_blocks.get(index), nullptr};
 	}
 
 	return {m_referrer->blocks.get(BlockType::OUT_OF_BOUNDS_BLOCK), nullptr};
@@ -70,7 +75,7 @@ void Chunk::setBlockAt(const phx::math::vec3& position, Block newBlock)
 			LOG_DEBUG("Chunk.cpp") << "Here is breaking an old " << oldBlock.type->displayName;
 			oldBlock.type->onBreak(position);
 		}
-		m_blocks[getVectorIndex(position)] = newBlock.type;
+		m_blocks.set(getVectorIndex(position), newBlock.type);
 		if (newBlock.metadata != nullptr)
 		{
 			m_metadata[getVectorIndex(position)] = *newBlock.metadata;
@@ -104,58 +109,231 @@ bool Chunk::setMetadataAt(const phx::math::vec3& position,
 	return false;
 }
 
-bool Chunk::canRepeat(std::size_t i) const
+namespace
 {
-	if (i + 1 >= CHUNK_MAX_BLOCKS)
-		return false;
-	if (m_blocks[i + 1]->id != m_blocks[i]->id)
-		return false;
-	if (m_metadata.find(i + 1) != m_metadata.end())
-		return false;
-	return true;
-};
+	void writeVarint(phx::Serializer& ser, std::size_t value)
+	{
+		while (value >= 0x80)
+		{
+			ser << static_cast<unsigned char>((value & 0x7F) | 0x80);
+			value >>= 7;
+		}
+		ser << static_cast<unsigned char>(value);
+	}
+
+	std::size_t readVarint(phx::Serializer& ser)
+	{
+		std::size_t value = 0;
+		for (unsigned int shift = 0; shift < 64; shift += 7)
+		{
+			unsigned char byte;
+			ser >> byte;
+
+			value |= static_cast<std::size_t>(byte & 0x7F) << shift;
+			if ((byte & 0x80) == 0)
+			{
+				break;
+			}
+		}
+		return value;
+	}
+} // namespace
 
 phx::Serializer& Chunk::operator>>(phx::Serializer& ser) const
 {
-
 	ser << m_pos.x << m_pos.y << m_pos.z;
-	for (int i = 0; i < CHUNK_MAX_BLOCKS; i++)
-	// for (const BlockType* block : m_blocks)
+	ser << BINARY_FORMAT_MARKER;
+
+	// the storage's palette can hold blocks that are no longer used, so only
+	// the used ones are written, in the order they first appear.
+	const BlockStorage::Palette&  storagePalette = m_blocks.getPalette();
+	std::vector<std::size_t>      remap(storagePalette.size(), SIZE_MAX);
+	std::vector<const BlockType*> palette;
+
+	// pairs of (palette index, run length).
+	std::vector<std::pair<std::size_t, std::size_t>> runs;
+	for (std::size_t i = 0; i < CHUNK_MAX_BLOCKS;)
 	{
-		ser << m_blocks[i]->id;
-		if (m_metadata.find(i) != m_metadata.end())
+		const BlockStorage::PaletteIndex index = m_blocks.getPaletteIndex(i);
+
+		std::size_t end = i + 1;
+		while (end < CHUNK_MAX_BLOCKS && m_blocks.getPaletteIndex(end) == index)
 		{
-			ser << '+' << m_metadata.at(i);
+			++end;
 		}
-		else if (canRepeat(i))
+
+		if (remap[index] == SIZE_MAX)
 		{
-			std::size_t j = i;
-			while (canRepeat(i))
-			{
-				i++;
-			}
-			ser << '*' << i - j;
+			remap[index] = palette.size();
+			palette.push_back(storagePalette[index]);
 		}
-		else
+
+		runs.emplace_back(remap[index], end - i);
+		i = end;
+	}
+
+	writeVarint(ser, palette.size());
+	for (const BlockType* block : palette)
+	{
+		ser << block->id;
+	}
+
+	writeVarint(ser, runs.size());
+	for (const auto& run : runs)
+	{
+		writeVarint(ser, run.first);
+		writeVarint(ser, run.second);
+	}
+
+	writeVarint(ser, m_metadata.size());
+	for (const auto& metadata : m_metadata)
+	{
+		writeVarint(ser, metadata.first);
+		ser << metadata.second;
+	}
+
+	return ser;
+}
+
+phx::Serializer& Chunk::operator<<(phx::Serializer& ser)
+{
+	ser >> m_pos.x >> m_pos.y >> m_pos.z;
+
+	std::uint32_t marker;
+	ser >> marker;
+	if (marker != BINARY_FORMAT_MARKER)
+	{
+		readLegacy(ser, marker);
+		return ser;
+	}
+
+	m_metadata.clear();
+
+	// every ID is only looked up once, runs refer to the palette by index.
+	const std::size_t       paletteSize = readVarint(ser);
+	std::vector<BlockType*> palette;
+	palette.reserve(paletteSize);
+	for (std::size_t i = 0; i < paletteSize && !ser.empty(); ++i)
+	{
+		std::string id;
+		ser >> id;
+		palette.push_back(m_referrer->getByID(id));
+	}
+
+	// the chunk is left half read, the serializer is marked as failed so
+	// whoever is reading it knows not to use it.
+	const auto corrupt = [this, &ser]() -> phx::Serializer& {
+		LOG_WARNING("CHUNK") << "Chunk at " << m_pos.x << ", " << m_pos.y
+		                     << ", " << m_pos.z << " is corrupt.";
+		ser.fail();
+		return ser;
+	};
+
+	// pairs of (palette index, run length).
+	const std::size_t                                runCount = readVarint(ser);
+	std::vector<std::pair<std::size_t, std::size_t>> runs;
+	std::vector<std::size_t>                         counts(palette.size(), 0);
+	std::size_t                                      total = 0;
+	for (std::size_t i = 0; i < runCount && !ser.failed(); ++i)
+	{
+		const std::size_t index  = readVarint(ser);
+		const std::size_t length = readVarint(ser);
+
+		if (index >= palette.size() || length > CHUNK_MAX_BLOCKS - total)
+		{
+			return corrupt();
+		}
+
+		runs.emplace_back(index, length);
+		counts[index] += length;
+		total += length;
+	}
+
+	// the runs always cover the whole chunk.
+	if (ser.failed() || palette.size() != paletteSize ||
+	    total != CHUNK_MAX_BLOCKS)
+	{
+		return corrupt();
+	}
+
+	// start out filled with the most common block, so only the runs of the
+	// other blocks have to be written.
+	const std::size_t common = static_cast<std::size_t>(
+	    std::max_element(counts.begin(), counts.end()) - counts.begin());
+	m_blocks.fill(palette[common]);
+
+	std::vector<BlockStorage::PaletteIndex> indices;
+	indices.reserve(palette.size());
+	for (BlockType* block : palette)
+	{
+		indices.push_back(m_blocks.add(block));
+	}
+
+	std::size_t position = 0;
+	for (const auto& run : runs)
+	{
+		const BlockStorage::PaletteIndex index = indices[run.first];
+		if (index != indices[common])
 		{
-			ser << ';';
+			for (std::size_t j = position; j < position + run.second; ++j)
+			{
+				m_blocks.setPaletteIndex(j, index);
+			}
 		}
+
+		position += run.second;
 	}
+
+	const std::size_t metadataCount = readVarint(ser);
+	for (std::size_t i = 0; i < metadataCount && !ser.empty(); ++i)
+	{
+		const std::size_t index = readVarint(ser);
+
+		Metadata data;
+		ser >> data;
+		m_metadata[index] = data;
+	}
+
+	if (ser.failed() || m_metadata.size() != metadataCount)
+	{
+		return corrupt();
+	}
+
 	return ser;
 }
 
-phx::Serializer& Chunk::operator<<(phx::Serializer& ser)
+void Chunk::readLegacy(phx::Serializer& ser, std::uint32_t idLength)
 {
-	m_blocks.clear();
-	m_blocks.reserve(4096);
+	m_metadata.clear();
 
-	ser >> m_pos.x >> m_pos.y >> m_pos.z;
 	for (int i = 0; i < CHUNK_MAX_BLOCKS; i++)
 	{
 		std::string id;
-		ser >> id;
-		m_blocks.push_back(
-		    m_referrer->blocks.get(*m_referrer->referrer.get(id)));
+		if (i == 0)
+		{
+			// the length of the first ID was read looking for the marker.
+			id.resize(idLength);
+			for (char& c : id)
+			{
+				ser >> c;
+			}
+		}
+		else
+		{
+			ser >> id;
+		}
+
+		BlockType* block = m_referrer->getByID(id);
+		if (i == 0)
+		{
+			// start from a single value chunk, a chunk that is one long run
+			// never needs to grow its indices.
+			m_blocks.fill(block);
+		}
+
+		const BlockStorage::PaletteIndex index = m_blocks.add(block);
+		m_blocks.setPaletteIndex(i, index);
+
 		char c;
 		ser >> c;
 		if (c == ';')
@@ -171,14 +349,11 @@ phx::Serializer& Chunk::operator<<(phx::Serializer& ser)
 		{
 			std::size_t rep;
 			ser >> rep;
-			for (std::size_t j = 0; j < rep; j++)
+			for (std::size_t j = 0; j < rep && i + 1 < CHUNK_MAX_BLOCKS; j++)
 			{
-				m_blocks.push_back(
-				    m_referrer->blocks.get(*m_referrer->referrer.get(id)));
 				i++;
+				m_blocks.setPaletteIndex(i, index);
 			}
 		}
 	}
-
-	return ser;
 }
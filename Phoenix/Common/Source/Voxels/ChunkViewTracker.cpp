@@ -0,0 +1,231 @@
+// Copyright 2019-20 Genten Studios
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors
+// may be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include <Common/Voxels/ChunkViewTracker.hpp>
+
+#include <algorithm>
+#include <tuple>
+#include <utility>
+
+using namespace phx::voxels;
+
+ChunkViewTracker::ChunkViewTracker(int viewDistance, int unloadDistance)
+    : m_viewDistance(viewDistance),
+      m_unloadDistance(std::max(viewDistance, unloadDistance))
+{
+}
+
+bool ChunkViewTracker::move(const ChunkPos& centre)
+{
+	if (m_placed && centre == m_centre)
+	{
+		return false;
+	}
+
+	// nothing was in view before the first move.
+	const Box oldView =
+	    m_placed ? around(m_centre, m_viewDistance)
+	             : Box {{1, 1, 1}, {0, 0, 0}};
+	const Box oldKeep = around(m_centre, m_unloadDistance);
+
+	const Box view = around(centre, m_viewDistance);
+	const Box keep = around(centre, m_unloadDistance);
+
+	m_wanted.erase(std::remove_if(m_wanted.begin(), m_wanted.end(),
+	                              [&view](const ChunkPos& index) {
+		                              return !view.contains(index);
+	                              }),
+	               m_wanted.end());
+
+	// chunks that were kept while out of view might not need loading.
+	forEachOutside(view, oldView, [this](const ChunkPos& index) {
+		if (m_loaded.find(index) == m_loaded.end())
+		{
+			m_wanted.push_back(index);
+		}
+	});
+
+	if (m_placed)
+	{
+		forEachOutside(oldKeep, keep, [this](const ChunkPos& index) {
+			if (m_loaded.erase(index) != 0)
+			{
+				m_unloaded.push_back(index);
+			}
+		});
+	}
+
+	m_centre = centre;
+	m_placed = true;
+
+	sortNearestFirst(m_wanted);
+
+	return true;
+}
+
+std::size_t ChunkViewTracker::load(const Loader& loader)
+{
+	// the chunks that are still wanted are moved down, keeping their order.
+	std::size_t wanted = 0;
+	for (std::size_t i = 0; i < m_wanted.size(); ++i)
+	{
+		if (loader(m_wanted[i]))
+		{
+			m_loaded.insert(m_wanted[i]);
+		}
+		else
+		{
+			m_wanted[wanted++] = m_wanted[i];
+		}
+	}
+
+	const std::size_t loaded = m_wanted.size() - wanted;
+	m_wanted.resize(wanted);
+	return loaded;
+}
+
+std::vector<ChunkPos> ChunkViewTracker::takeUnloaded()
+{
+	sortNearestFirst(m_unloaded);
+
+	std::vector<ChunkPos> unloaded;
+	unloaded.swap(m_unloaded);
+	return unloaded;
+}
+
+void ChunkViewTracker::clear()
+{
+	m_placed = false;
+	m_loaded.clear();
+	m_wanted.clear();
+	m_unloaded.clear();
+}
+
+bool ChunkViewTracker::isInRange(const ChunkPos& index) const
+{
+	return m_placed && around(m_centre, m_unloadDistance).contains(index);
+}
+
+bool ChunkViewTracker::isLoaded(const ChunkPos& index) const
+{
+	return m_loaded.find(index) != m_loaded.end();
+}
+
+const ChunkViewTracker::IndexSet& ChunkViewTracker::getLoaded() const
+{
+	return m_loaded;
+}
+
+const std::vector<ChunkPos>& ChunkViewTracker::getWanted() const
+{
+	return m_wanted;
+}
+
+const ChunkPos& ChunkViewTracker::getCentre() const
+{
+	return m_centre;
+}
+
+bool ChunkViewTracker::Box::contains(const ChunkPos& index) const
+{
+	return index.x >= min.x && index.x <= max.x && index.y >= min.y &&
+	       index.y <= max.y && index.z >= min.z && index.z <= max.z;
+}
+
+template <typename F>
+void ChunkViewTracker::forEachOutside(const Box& box, const Box& exclude,
+                                      const F& function)
+{
+	for (int x = box.min.x; x <= box.max.x; ++x)
+	{
+		const bool sharedX = x >= exclude.min.x && x <= exclude.max.x;
+		for (int y = box.min.y; y <= box.max.y; ++y)
+		{
+			const bool sharedY = y >= exclude.min.y && y <= exclude.max.y;
+			if (!sharedX || !sharedY)
+			{
+				for (int z = box.min.z; z <= box.max.z; ++z)
+				{
+					function(ChunkPos {x, y, z});
+				}
+				continue;
+			}
+
+			// only the ends of the row stick out of the excluded box.
+			const int below = std::min(box.max.z, exclude.min.z - 1);
+			for (int z = box.min.z; z <= below; ++z)
+			{
+				function(ChunkPos {x, y, z});
+			}
+
+			const int above = std::max(box.min.z, exclude.max.z + 1);
+			for (int z = above; z <= box.max.z; ++z)
+			{
+				function(ChunkPos {x, y, z});
+			}
+		}
+	}
+}
+
+ChunkViewTracker::Box ChunkViewTracker::around(const ChunkPos& centre,
+                                               int distance) const
+{
+	return {{centre.x - distance, centre.y - distance, centre.z - distance},
+	        {centre.x + distance, centre.y + distance, centre.z + distance}};
+}
+
+void ChunkViewTracker::sortNearestFirst(std::vector<ChunkPos>& indices) const
+{
+	// the distances are worked out once up front rather than on every
+	// comparison, ties are broken by position so the order is always the
+	// same.
+	std::vector<std::pair<int, ChunkPos>> sorted;
+	sorted.reserve(indices.size());
+	for (const ChunkPos& index : indices)
+	{
+		const int x = index.x - m_centre.x;
+		const int y = index.y - m_centre.y;
+		const int z = index.z - m_centre.z;
+		sorted.emplace_back(x * x + y * y + z * z, index);
+	}
+
+	std::sort(sorted.begin(), sorted.end(),
+	          [](const auto& a, const auto& b) {
+		          if (a.first != b.first)
+		          {
+			          return a.first < b.first;
+		          }
+		          return std::tie(a.second.x, a.second.y, a.second.z) <
+		                 std::tie(b.second.x, b.second.y, b.second.z);
+	          });
+
+	for (std::size_t i = 0; i < sorted.size(); ++i)
+	{
+		indices[i] = sorted[i].second;
+	}
+}
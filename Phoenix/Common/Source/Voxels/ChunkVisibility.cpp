@@ -0,0 +1,240 @@
+// Copyright 2019-20 Genten Studios
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors
+// may be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include <Common/Voxels/Chunk.hpp>
+#include <Common/Voxels/ChunkVisibility.hpp>
+
+#include <deque>
+#include <unordered_set>
+
+using namespace phx::voxels;
+
+namespace
+{
+	// the position of the chunk next to each face, in blocks.
+	const phx::math::vec3 FACE_OFFSETS[] = {
+	    {0, 0, -Chunk::CHUNK_DEPTH}, {-Chunk::CHUNK_WIDTH, 0, 0},
+	    {0, 0, Chunk::CHUNK_DEPTH},  {Chunk::CHUNK_WIDTH, 0, 0},
+	    {0, Chunk::CHUNK_HEIGHT, 0}, {0, -Chunk::CHUNK_HEIGHT, 0},
+	};
+
+	// the faces of the chunk that a block touches, as a bit for each face.
+	std::uint8_t touchedFaces(int x, int y, int z)
+	{
+		std::uint8_t faces = 0;
+		faces |= (z == 0) << 0;
+		faces |= (x == 0) << 1;
+		faces |= (z == Chunk::CHUNK_DEPTH - 1) << 2;
+		faces |= (x == Chunk::CHUNK_WIDTH - 1) << 3;
+		faces |= (y == Chunk::CHUNK_HEIGHT - 1) << 4;
+		faces |= (y == 0) << 5;
+		return faces;
+	}
+} // namespace
+
+ChunkVisibility ChunkVisibility::all()
+{
+	ChunkVisibility visibility;
+	visibility.m_connections.fill((1 << FACE_COUNT) - 1);
+	return visibility;
+}
+
+ChunkVisibility ChunkVisibility::compute(const BlockStorage&      blocks,
+                                         const std::vector<bool>& opaque)
+{
+	// resolve the palette once, so the fill only looks at bytes.
+	std::vector<std::uint8_t> solid(Chunk::CHUNK_MAX_BLOCKS);
+	std::size_t               solidCount = 0;
+	for (std::size_t i = 0; i < solid.size(); ++i)
+	{
+		solid[i] = opaque[blocks.getPaletteIndex(i)] ? 1 : 0;
+		solidCount += solid[i];
+	}
+
+	// cutting off any face from another takes at least a line of blocks
+	// across every layer of the chunk, so with fewer than a face's worth of
+	// opaque blocks everything has to be connected.
+	if (solidCount < Chunk::CHUNK_WIDTH * Chunk::CHUNK_HEIGHT)
+	{
+		return all();
+	}
+
+	ChunkVisibility visibility;
+
+	// opaque blocks are never filled, so they count as visited already.
+	std::vector<std::uint8_t> visited = solid;
+	std::vector<int>          stack;
+
+	for (int start = 0; start < Chunk::CHUNK_MAX_BLOCKS; ++start)
+	{
+		if (visited[start] != 0)
+		{
+			continue;
+		}
+
+		std::uint8_t faces = 0;
+
+		visited[start] = 1;
+		stack.push_back(start);
+		while (!stack.empty())
+		{
+			const int index = stack.back();
+			stack.pop_back();
+
+			// indices are x + WIDTH * (y + HEIGHT * z).
+			const int x = index % Chunk::CHUNK_WIDTH;
+			const int y = (index / Chunk::CHUNK_WIDTH) % Chunk::CHUNK_HEIGHT;
+			const int z = index / (Chunk::CHUNK_WIDTH * Chunk::CHUNK_HEIGHT);
+
+			faces |= touchedFaces(x, y, z);
+
+			const int step[] = {
+			    x > 0 ? -1 : 0,
+			    x < Chunk::CHUNK_WIDTH - 1 ? 1 : 0,
+			    y > 0 ? -Chunk::CHUNK_WIDTH : 0,
+			    y < Chunk::CHUNK_HEIGHT - 1 ? Chunk::CHUNK_WIDTH : 0,
+			    z > 0 ? -Chunk::CHUNK_WIDTH * Chunk::CHUNK_HEIGHT : 0,
+			    z < Chunk::CHUNK_DEPTH - 1
+			        ? Chunk::CHUNK_WIDTH * Chunk::CHUNK_HEIGHT
+			        : 0,
+			};
+
+			for (int offset : step)
+			{
+				// a step of 0 is the edge of the chunk, the block itself is
+				// visited already.
+				const int next = index + offset;
+				if (visited[next] == 0)
+				{
+					visited[next] = 1;
+					stack.push_back(next);
+				}
+			}
+		}
+
+		// every face this pocket of air touches can see every other one.
+		for (std::size_t from = 0; from < FACE_COUNT; ++from)
+		{
+			if ((faces >> from) & 1)
+			{
+				visibility.m_connections[from] |= faces;
+			}
+		}
+	}
+
+	return visibility;
+}
+
+bool ChunkVisibility::findVisible(const math::vec3& start,
+                                  const Lookup& lookup, const Filter& inView,
+                                  std::vector<math::vec3>& visible)
+{
+	visible.clear();
+
+	if (lookup(start) == nullptr)
+	{
+		return false;
+	}
+
+	struct Step
+	{
+		math::vec3 pos;
+
+		// the face the chunk was entered through, FACE_COUNT for the
+		// camera's chunk which can be left through any face.
+		std::size_t entry;
+
+		// every direction taken to get here, as a bit for each face that was
+		// left through.
+		std::uint8_t directions;
+	};
+
+	std::unordered_set<math::vec3, math::Vector3Hasher,
+	                   math::Vector3KeyComparator>
+	    seen;
+
+	std::deque<Step> queue;
+	queue.push_back({start, FACE_COUNT, 0});
+	seen.insert(start);
+
+	while (!queue.empty())
+	{
+		const Step step = queue.front();
+		queue.pop_front();
+
+		visible.push_back(step.pos);
+
+		const ChunkVisibility* visibility = lookup(step.pos);
+		for (std::size_t face = 0; face < FACE_COUNT; ++face)
+		{
+			// never go back towards the camera, anything seen that way is
+			// reached through another chunk.
+			if ((step.directions >> opposite(face)) & 1)
+			{
+				continue;
+			}
+
+			if (step.entry != FACE_COUNT &&
+			    !visibility->connects(step.entry, face))
+			{
+				continue;
+			}
+
+			const math::vec3 next = step.pos + FACE_OFFSETS[face];
+			if (seen.find(next) != seen.end() || lookup(next) == nullptr ||
+			    (inView && !inView(next)))
+			{
+				continue;
+			}
+
+			seen.insert(next);
+			queue.push_back({next, opposite(face),
+			                 static_cast<std::uint8_t>(step.directions |
+			                                           (1 << face))});
+		}
+	}
+
+	return true;
+}
+
+std::size_t ChunkVisibility::opposite(std::size_t face)
+{
+	// -z and +z, -x and +x are two apart, +y and -y are next to each other.
+	return face < 4 ? (face + 2) % 4 : 9 - face;
+}
+
+void ChunkVisibility::connect(std::size_t from, std::size_t to)
+{
+	m_connections[from] |= 1 << to;
+	m_connections[to] |= 1 << from;
+}
+
+bool ChunkVisibility::connects(std::size_t from, std::size_t to) const
+{
+	return (m_connections[from] >> to) & 1;
+}
@@ -32,18 +32,26 @@
 #include <Common/Utility/Serializer.hpp>
 #include <Common/Voxels/Map.hpp>
 
+#include <algorithm>
 #include <cstddef>
 #include <filesystem>
+#include <fstream>
 #include <iostream>
+#include <sstream>
 #include <string>
 #include <string_view>
 #include <utility>
 
 using namespace phx::voxels;
 
-Map::Map(phx::Save* save, const std::string& name, BlockReferrer* referrer)
+Map::Map(phx::Save* save, const std::string& name, BlockReferrer* referrer,
+         std::size_t ioThreads)
     : m_referrer(referrer), m_save(save), m_mapName(name)
 {
+	if (ioThreads > 0)
+	{
+		m_pool = std::make_unique<ThreadPool>(ioThreads);
+	}
 }
 
 Map::Map(phx::BlockingQueue<std::pair<phx::math::vec3, std::vector<std::byte>>>*
@@ -53,6 +61,14 @@ Map::Map(phx::BlockingQueue<std::pair<phx::math::vec3, std::vector<std::byte>>>*
 {
 }
 
+Map::~Map()
+{
+	// stop the workers before anything they might be using goes away.
+	m_pool.reset();
+
+	flush();
+}
+
 /*
     Chunks are kept in an unordered map of vec3 : Chunk. The algorithm looks
     first in the map. The next behavior depends on whether we are in online or
@@ -60,93 +76,261 @@ Map::Map(phx::BlockingQueue<std::pair<phx::math::vec3, std::vector<std::byte>>>*
     chunks from the server, then if it still isn't found, nullptr is returned.
     If we are not networked, the chunk is loaded from the save files. If the
     save file does not exist yet or is damaged, a new chunk will be generated.
+    If it was saved with a codec this build can't read, nullptr is returned
+    and the chunk is never generated, so the saved copy is never replaced.
+    When the map has worker threads, loading and generating happens on them
+    instead, and nullptr is returned until tick() publishes the chunk.
 */
 Chunk* Map::getChunk(const phx::math::vec3& pos)
 {
-	if (m_chunks.find(pos) != m_chunks.end())
+	if (m_pool == nullptr)
+	{
+		return getChunkNow(pos);
+	}
+
+	Chunk* chunk = findChunk(toChunkPos(pos));
+	if (chunk != nullptr)
+	{
+		return chunk;
+	}
+
+	requestChunk(pos);
+	return nullptr;
+}
+
+Chunk* Map::findChunk(const ChunkPos& pos) const
+{
+	const auto it = m_chunks.find(pos);
+	return it != m_chunks.end() ? it->second.get() : nullptr;
+}
+
+Chunk* Map::getChunkNow(const phx::math::vec3& pos)
+{
+	Chunk* chunk = findChunk(toChunkPos(pos));
+	if (chunk != nullptr)
 	{
-		return &m_chunks.at(pos);
+		return chunk;
 	}
 
 	if (m_queue)
 	{
 		updateChunkQueue();
-		if (m_chunks.find(pos) != m_chunks.end())
-		{
-			return &m_chunks.at(pos);
-		}
+		return findChunk(toChunkPos(pos));
+	}
 
+	if (m_unreadable.find(pos) != m_unreadable.end())
+	{
 		return nullptr;
 	}
 
-	// Chunk isn't in memory and we aren't networked, so lets create one
-	if (!loadChunk(pos))
+	// Chunk isn't in memory and we aren't networked, so lets create one. If
+	// a worker is loading this chunk too, the request is forgotten so its
+	// copy is thrown away by tick().
+	m_pending.erase(pos);
+
+	Chunk            created {pos, m_referrer};
+	const LoadResult result = loadChunk(created);
+	if (result == LoadResult::LOADED)
 	{
-		// save doesn't exist, generate it.
-		generateChunk(pos);
+		return publishChunk(std::move(created), false);
 	}
 
-	return &m_chunks.at(pos);
+	if (result == LoadResult::UNREADABLE)
+	{
+		m_unreadable.insert(pos);
+		return nullptr;
+	}
+
+	// save doesn't exist, generate it.
+	generateChunk(created);
+	return publishChunk(std::move(created), true);
 }
 
-std::pair<phx::math::vec3, phx::math::vec3> Map::getBlockPos(
-    phx::math::vec3 position)
+ChunkState Map::getChunkState(const phx::math::vec3& pos) const
+{
+	if (findChunk(toChunkPos(pos)) != nullptr)
+	{
+		return ChunkState::LOADED;
+	}
+
+	if (m_pending.find(pos) != m_pending.end())
+	{
+		return ChunkState::PENDING;
+	}
+
+	return ChunkState::UNLOADED;
+}
+
+std::size_t Map::tick(std::chrono::microseconds budget)
 {
-	// This mess converts position types between world and inner chunk
-	// positioning
-	int posX = static_cast<int>(position.x / Chunk::CHUNK_WIDTH);
-	int posY = static_cast<int>(position.y / Chunk::CHUNK_HEIGHT);
-	int posZ = static_cast<int>(position.z / Chunk::CHUNK_DEPTH);
+	const Clock::time_point start = Clock::now();
 
-	position.x =
-	    static_cast<float>(static_cast<int>(position.x) % Chunk::CHUNK_WIDTH);
-	if (position.x < 0)
+	if (!m_dirty.empty())
 	{
-		posX -= 1;
-		position.x += Chunk::CHUNK_WIDTH;
+		std::vector<math::vec3> expired;
+		for (const auto& dirty : m_dirty)
+		{
+			if (start - dirty.second >= m_flushInterval)
+			{
+				expired.push_back(dirty.first);
+			}
+		}
+
+		for (const math::vec3& pos : expired)
+		{
+			save(pos);
+		}
+	}
+
+	if (m_pool == nullptr)
+	{
+		return 0;
+	}
+
+	std::size_t published = 0;
+
+	LoadedChunk loaded;
+	while (Clock::now() - start < budget && m_completed.try_pop(loaded))
+	{
+		const math::vec3 pos = loaded.chunk->getChunkPos();
+
+		// the request is gone if the chunk was loaded on this thread in the
+		// meantime (see getChunkNow), or replaced if it was also unloaded
+		// and requested again. Either way this copy might be out of date.
+		const auto pending = m_pending.find(pos);
+		if (pending == m_pending.end() ||
+		    pending->second.generation != loaded.generation)
+		{
+			continue;
+		}
+
+		using Milliseconds = std::chrono::duration<float, std::milli>;
+		const float latency =
+		    Milliseconds(Clock::now() - pending->second.requested).count();
+
+		m_stats.lastLatency = latency;
+		m_stats.maxLatency  = std::max(m_stats.maxLatency, latency);
+		m_stats.averageLatency =
+		    (m_stats.averageLatency * m_stats.published + latency) /
+		    (m_stats.published + 1);
+		++m_stats.published;
+
+		m_pending.erase(pending);
+
+		if (loaded.unreadable)
+		{
+			m_unreadable.insert(pos);
+			continue;
+		}
+
+		publishChunk(std::move(*loaded.chunk), loaded.generated);
+		++published;
 	}
 
-	position.y =
-	    static_cast<float>(static_cast<int>(position.y) % Chunk::CHUNK_HEIGHT);
-	if (position.y < 0)
+	return published;
+}
+
+ChunkIOStats Map::getIOStats() const
+{
+	ChunkIOStats stats = m_stats;
+	stats.queued       = m_pool != nullptr ? m_pool->getQueueDepth() : 0;
+	stats.pending      = m_pending.size();
+	stats.completed    = m_completed.size();
+	return stats;
+}
+
+BlockReferrer* Map::getReferrer() const { return m_referrer; }
+
+void Map::requestChunk(const phx::math::vec3& pos)
+{
+	if (m_pending.find(pos) != m_pending.end() ||
+	    m_unreadable.find(pos) != m_unreadable.end())
 	{
-		posY -= 1;
-		position.y += Chunk::CHUNK_HEIGHT;
+		return;
 	}
 
-	position.z =
-	    static_cast<float>(static_cast<int>(position.z) % Chunk::CHUNK_DEPTH);
-	if (position.z < 0)
+	const std::size_t generation = m_nextGeneration++;
+	m_pending.emplace(pos, PendingChunk {Clock::now(), generation});
+
+	m_pool->push([this, pos, generation]() {
+		LoadedChunk loaded;
+		loaded.generation = generation;
+		loaded.chunk      = std::make_shared<Chunk>(pos, m_referrer);
+
+		const LoadResult result = loadChunk(*loaded.chunk);
+		if (result == LoadResult::MISSING)
+		{
+			generateChunk(*loaded.chunk);
+			loaded.generated = true;
+		}
+
+		loaded.unreadable = result == LoadResult::UNREADABLE;
+
+		m_completed.push(std::move(loaded));
+	});
+}
+
+Chunk* Map::publishChunk(Chunk&& chunk, bool generated)
+{
+	const math::vec3 pos = chunk.getChunkPos();
+	Chunk* published =
+	    m_chunks
+	        .try_emplace(toChunkPos(pos), std::make_unique<Chunk>(std::move(chunk)))
+	        .first->second.get();
+
+	// generated chunks are saved straight away, this happens here rather
+	// than on the worker so only this thread ever writes to the save.
+	if (generated)
 	{
-		posZ -= 1;
-		position.z += Chunk::CHUNK_DEPTH;
+		save(pos);
 	}
 
-	const math::vec3 chunkPosition =
-	    math::vec3(static_cast<float>(posX * Chunk::CHUNK_WIDTH),
-	               static_cast<float>(posY * Chunk::CHUNK_HEIGHT),
-	               static_cast<float>(posZ * Chunk::CHUNK_DEPTH));
+	return published;
+}
 
-	return {chunkPosition, position};
+std::pair<phx::math::vec3, phx::math::vec3> Map::getBlockPos(
+    phx::math::vec3 position)
+{
+	const math::vec3i block = toBlockPos(position);
+
+	return {toPosition(getChunkPos(block)), math::vec3(getLocalPos(block))};
 }
 
 Block Map::getBlockAt(phx::math::vec3 position)
 {
-	const auto& pos   = getBlockPos(position);
-	Chunk*      chunk = getChunk(pos.first);
+	const math::vec3i block    = toBlockPos(position);
+	const ChunkPos    chunkPos = getChunkPos(block);
+
+	// most lookups land in a loaded chunk, so that's checked first without
+	// going through any float positions.
+	Chunk* chunk = findChunk(chunkPos);
+	if (chunk == nullptr)
+	{
+		chunk = getChunk(toPosition(chunkPos));
+	}
+
 	if (chunk == nullptr)
 	{
 		return {m_referrer->blocks.get(BlockType::OUT_OF_BOUNDS_BLOCK),
 		        nullptr};
 	}
 
-	return chunk->getBlockAt(pos.second);
+	const math::vec3i local = getLocalPos(block);
+	return chunk->getBlockAt(Chunk::getVectorIndex(
+	    static_cast<std::size_t>(local.x), static_cast<std::size_t>(local.y),
+	    static_cast<std::size_t>(local.z)));
 }
 
 void Map::setBlockAt(phx::math::vec3 position, const Block& block)
 {
 	const auto& pos   = getBlockPos(position);
-	Chunk*      chunk = getChunk(pos.first);
+	Chunk*      chunk = getChunkNow(pos.first);
+	if (chunk == nullptr)
+	{
+		LOG_WARNING("MAP") << "Attempted to set a block in a chunk that "
+		                      "has not been received yet or can't be read.";
+		return;
+	}
 
 	dispatchToSubscriber(
 	    {MapEvent::BLOCK_BREAK, chunk->getBlockAt(pos.second).type});
@@ -155,29 +339,262 @@ void Map::setBlockAt(phx::math::vec3 position, const Block& block)
 
 	if (m_queue == nullptr)
 	{
-		save(pos.first);
+		markDirty(pos.first);
 	}
 
-	dispatchToSubscriber({MapEvent::CHUNK_UPDATE, chunk});
+	dispatchToSubscriber({MapEvent::CHUNK_UPDATE, chunk, pos.second});
 	dispatchToSubscriber({MapEvent::BLOCK_PLACE, block.type});
 }
 
-void Map::save(const phx::math::vec3& pos)
+bool Map::save(const phx::math::vec3& pos)
 {
 	if (m_queue != nullptr)
 	{
 		LOG_WARNING("MAP") << "Attempted to save while networked";
-		return;
+		return false;
 	}
 
-	std::ofstream saveFile(toSavePath(static_cast<phx::math::vec3i>(pos)),
-	                       std::ofstream::binary);
+	const Chunk* chunk = findChunk(toChunkPos(pos));
+	if (chunk == nullptr)
+	{
+		LOG_WARNING("MAP") << "Attempted to save a chunk that isn't loaded";
+		m_dirty.erase(pos);
+		return false;
+	}
 
 	Serializer ser;
-	ser << m_chunks.at(pos);
-	saveFile.write((char*) &ser.getBuffer()[0], ser.getBuffer().size());
+	ser << *chunk;
 
-	saveFile.close();
+	const data::Data frame = data::Compression::compress(
+	    ser.getBuffer(), m_codec, m_compressionLevel);
+
+	RegionFile* region = getRegion(pos);
+	if (region == nullptr ||
+	    !region->write(RegionFile::toLocalIndex(toChunkPos(pos)), frame))
+	{
+		LOG_WARNING("MAP") << "Failed to save chunk at " << pos.x << ", "
+		                   << pos.y << ", " << pos.z;
+
+		// the chunk stays edited so it is tried again, but not before
+		// another interval has passed.
+		const auto dirty = m_dirty.find(pos);
+		if (dirty != m_dirty.end())
+		{
+			dirty->second = Clock::now();
+		}
+
+		return false;
+	}
+
+	m_dirty.erase(pos);
+	return true;
+}
+
+void Map::setWriteBack(std::chrono::milliseconds interval,
+                       std::size_t               maxDirty)
+{
+	m_flushInterval = interval;
+	m_maxDirty      = maxDirty;
+
+	// copied, save() erases the entry the key lives in. A chunk that fails
+	// to save stays, so this can't just save until there are few enough.
+	std::vector<math::vec3> waiting;
+	for (const auto& dirty : m_dirty)
+	{
+		waiting.push_back(dirty.first);
+	}
+
+	for (const math::vec3& pos : waiting)
+	{
+		if (m_dirty.size() <= m_maxDirty)
+		{
+			break;
+		}
+
+		save(pos);
+	}
+}
+
+void Map::setCompression(data::Codec codec, int level)
+{
+	m_codec            = codec;
+	m_compressionLevel = level;
+}
+
+bool Map::flush()
+{
+	std::vector<math::vec3> waiting;
+	for (const auto& dirty : m_dirty)
+	{
+		waiting.push_back(dirty.first);
+	}
+
+	bool saved = true;
+	for (const math::vec3& pos : waiting)
+	{
+		saved = save(pos) && saved;
+	}
+
+	std::lock_guard<std::mutex> lock(m_regionMutex);
+	for (auto& region : m_regions)
+	{
+		region.second->flush();
+	}
+
+	return saved;
+}
+
+bool Map::unloadChunk(const phx::math::vec3& pos)
+{
+	if (m_dirty.find(pos) != m_dirty.end() && !save(pos))
+	{
+		LOG_WARNING("MAP") << "Keeping chunk at " << pos.x << ", " << pos.y
+		                   << ", " << pos.z
+		                   << " loaded, its edits could not be saved.";
+		return false;
+	}
+
+	m_chunks.erase(toChunkPos(pos));
+
+	// a load still in flight was started before any of this chunk's edits
+	// were saved.
+	m_pending.erase(pos);
+
+	return true;
+}
+
+std::size_t Map::unloadChunks(
+    const std::function<bool(const phx::math::vec3&)>& isNeeded)
+{
+	std::vector<math::vec3> unneeded;
+	for (const auto& chunk : m_chunks)
+	{
+		const math::vec3 pos = chunk.second->getChunkPos();
+		if (!isNeeded(pos))
+		{
+			unneeded.push_back(pos);
+		}
+	}
+
+	std::size_t unloaded = 0;
+	for (const math::vec3& pos : unneeded)
+	{
+		if (unloadChunk(pos))
+		{
+			++unloaded;
+		}
+	}
+
+	return unloaded;
+}
+
+std::size_t Map::getLoadedChunkCount() const { return m_chunks.size(); }
+
+std::size_t Map::getMemoryUsage() const
+{
+	std::size_t usage = 0;
+	for (const auto& chunk : m_chunks)
+	{
+		// the storage itself is already part of the chunk.
+		usage += sizeof(Chunk) + chunk.second->getBlocks().getMemoryUsage() -
+		         sizeof(BlockStorage);
+	}
+
+	return usage;
+}
+
+void Map::markDirty(const phx::math::vec3& pos)
+{
+	// emplace doesn't replace the time of a chunk that is already waiting,
+	// so a chunk that keeps being edited is still saved on time.
+	m_dirty.emplace(pos, Clock::now());
+
+	if (m_dirty.size() > m_maxDirty)
+	{
+		const auto oldest = std::min_element(
+		    m_dirty.begin(), m_dirty.end(),
+		    [](const auto& a, const auto& b) { return a.second < b.second; });
+
+		const math::vec3 oldestPos = oldest->first;
+		save(oldestPos);
+	}
+}
+
+std::size_t Map::migrateLegacySaves(const std::string& save,
+                                    const std::string& mapName)
+{
+	namespace fs = std::filesystem;
+
+	const fs::path saveFolder = phx::saveDir + save;
+	if (!fs::exists(saveFolder))
+	{
+		LOG_WARNING("MAP") << "Save " << save << " does not exist.";
+		return 0;
+	}
+
+	std::unordered_map<math::vec3i, std::unique_ptr<RegionFile>,
+	                   math::Vector3Hasher, math::Vector3KeyComparator>
+	    regions;
+
+	std::size_t migrated = 0;
+	for (const auto& file : fs::directory_iterator(saveFolder))
+	{
+		// legacy saves are named <map>.<x>_<y>_<z>.save, with the position
+		// of the chunk in blocks.
+		const std::string name = file.path().filename().string();
+		if (file.path().extension() != ".save" ||
+		    name.compare(0, mapName.size() + 1, mapName + '.') != 0)
+		{
+			continue;
+		}
+
+		math::vec3i pos;
+		char        separator1, separator2;
+
+		std::istringstream posString(
+		    name.substr(mapName.size() + 1, name.size() - mapName.size() - 6));
+		posString >> pos.x >> separator1 >> pos.y >> separator2 >> pos.z;
+		if (!posString || separator1 != '_' || separator2 != '_')
+		{
+			LOG_WARNING("MAP") << "Skipping unrecognised save file " << name;
+			continue;
+		}
+
+		std::ifstream saveFile(file.path(), std::ifstream::binary);
+		data::Data    data(static_cast<std::size_t>(fs::file_size(file)));
+		saveFile.read(reinterpret_cast<char*>(data.data()), data.size());
+		saveFile.close();
+
+		// legacy positions are always an exact multiple of the chunk size.
+		const math::vec3i chunkIndex = {pos.x / Chunk::CHUNK_WIDTH,
+		                                pos.y / Chunk::CHUNK_HEIGHT,
+		                                pos.z / Chunk::CHUNK_DEPTH};
+		const math::vec3i regionPos  = RegionFile::toRegionPos(chunkIndex);
+
+		auto region = regions.find(regionPos);
+		if (region == regions.end())
+		{
+			region = regions
+			             .emplace(regionPos,
+			                      std::make_unique<RegionFile>(toRegionPath(
+			                          save, mapName, regionPos)))
+			             .first;
+		}
+
+		// legacy saves were never compressed, so compress them on the way in.
+		const data::Data frame =
+		    data::Compression::compress(data, data::Codec::DEFLATE);
+		if (region->second->write(RegionFile::toLocalIndex(chunkIndex), frame))
+		{
+			fs::remove(file.path());
+			++migrated;
+		}
+	}
+
+	LOG_INFO("MAP") << "Migrated " << migrated << " chunks of " << mapName
+	                << " into " << regions.size() << " region files.";
+
+	return migrated;
 }
 
 void Map::registerEventSubscriber(MapEventSubscriber* subscriber)
@@ -220,49 +637,74 @@ void Map::updateChunkQueue()
 		// We have chunk data.
 		Chunk           chunk {data.first, m_referrer};
 		phx::Serializer ser;
-		ser.setBuffer(data.second);
-		ser << chunk;
+		ser.setView(data.second.data(), data.second.size());
+		ser >> chunk;
 
-		m_chunks.emplace(chunk.getChunkPos(), chunk);
+		m_chunks.try_emplace(toChunkPos(chunk.getChunkPos()),
+		                     std::make_unique<Chunk>(std::move(chunk)));
 	}
 
 	return;
 }
 
-bool Map::loadChunk(const phx::math::vec3& chunkPos)
+Map::LoadResult Map::loadChunk(Chunk& chunk)
 {
-	std::ifstream saveFile(toSavePath(static_cast<phx::math::vec3i>(chunkPos)),
-	                       std::ifstream::binary);
+	const math::vec3 chunkPos = chunk.getChunkPos();
+	RegionFile*      region   = getRegion(chunkPos);
 
-	if (!saveFile)
+	data::Data frame;
+	if (region == nullptr ||
+	    !region->read(RegionFile::toLocalIndex(toChunkPos(chunkPos)), frame))
 	{
-		// File could not be opened.
-		return false;
+		// Chunk has not been saved yet.
+		return LoadResult::MISSING;
 	}
 
-	saveFile.seekg(0, std::ifstream::end);
-	int length = saveFile.tellg();
-	saveFile.seekg(0, std::ifstream::beg);
+	data::Data              data;
+	const data::FrameStatus status =
+	    data::Compression::decompress(frame.data(), frame.size(), data);
+	if (status == data::FrameStatus::UNSUPPORTED)
+	{
+		LOG_WARNING("MAP") << "Chunk at " << chunkPos.x << ", " << chunkPos.y
+		                   << ", " << chunkPos.z
+		                   << " was saved with a codec this build doesn't "
+		                      "support, it will not be loaded.";
+		return LoadResult::UNREADABLE;
+	}
 
-	Serializer ser;
-	// auto data = ser.getBuffer().data();
-	data::Data data(length);
-	// char* data = new char [length];
-	saveFile.read((char*) &data[0], length);
-	ser.setBuffer(data);
+	if (status != data::FrameStatus::OK)
+	{
+		LOG_WARNING("MAP") << "Chunk at " << chunkPos.x << ", " << chunkPos.y
+		                   << ", " << chunkPos.z
+		                   << " is damaged, it will be regenerated.";
+		return LoadResult::MISSING;
+	}
 
-	Chunk chunk {chunkPos, m_referrer};
+	Serializer ser;
+	ser.setBuffer(std::move(data));
 	ser >> chunk;
 
-	m_chunks.emplace(chunkPos, std::move(chunk));
-	return true;
+	if (ser.failed())
+	{
+		LOG_WARNING("MAP") << "Chunk at " << chunkPos.x << ", " << chunkPos.y
+		                   << ", " << chunkPos.z
+		                   << " is damaged, it will be regenerated.";
+
+		// start over, the half read chunk isn't worth keeping any of.
+		chunk = Chunk(chunkPos, m_referrer);
+		return LoadResult::MISSING;
+	}
+
+	return LoadResult::LOADED;
 }
 
 // Creates a new chunk and fills it with either grass or air, depending on its
 // position on the y axis. If it is below y = 0, it will be grass. Otherwise
 // air will be generated.
-void Map::generateChunk(const phx::math::vec3& chunkPos)
+void Map::generateChunk(Chunk& chunk) const
 {
+	const math::vec3 chunkPos = chunk.getChunkPos();
+
 	BlockType* fillBlock {};
 	// Position type needs to be converted.
 	if (chunkPos.y >= 0)
@@ -276,27 +718,48 @@ void Map::generateChunk(const phx::math::vec3& chunkPos)
 		    m_referrer->blocks.get(*m_referrer->referrer.get("core.grass"));
 	}
 
-	Chunk             chunk {chunkPos, m_referrer};
-	Chunk::BlockList& blocks = chunk.getBlocks();
-	for (std::size_t i = 0; i < Chunk::CHUNK_MAX_BLOCKS; ++i)
+	chunk.getBlocks().fill(fillBlock);
+}
+
+RegionFile* Map::getRegion(const phx::math::vec3& chunkPos)
+{
+	const math::vec3i regionPos =
+	    RegionFile::toRegionPos(toChunkPos(chunkPos));
+
+	// the worker threads open regions too.
+	std::lock_guard<std::mutex> lock(m_regionMutex);
+
+	auto it = m_regions.find(regionPos);
+	if (it == m_regions.end())
 	{
-		blocks.push_back(fillBlock);
+		it = m_regions
+		         .emplace(regionPos,
+		                  std::make_unique<RegionFile>(toRegionPath(
+		                      m_save->getName(), m_mapName, regionPos)))
+		         .first;
 	}
 
-	m_chunks.emplace(chunkPos, std::move(chunk));
+	if (!it->second->isOpen())
+	{
+		// opened again next time, so chunks waiting to be saved can be once
+		// whatever stopped it is fixed.
+		m_regions.erase(it);
+		return nullptr;
+	}
 
-	save(chunkPos);
+	return it->second.get();
 }
 
-std::filesystem::path Map::toSavePath(const phx::math::vec3i& chunkPos) const
+std::filesystem::path Map::toRegionPath(const std::string&      save,
+                                        const std::string&      mapName,
+                                        const phx::math::vec3i& regionPos)
 {
-	const std::string posString = std::to_string(chunkPos.x) + '_' +
-	                              std::to_string(chunkPos.y) + '_' +
-	                              std::to_string(chunkPos.z);
+	const std::string posString = std::to_string(regionPos.x) + '_' +
+	                              std::to_string(regionPos.y) + '_' +
+	                              std::to_string(regionPos.z);
 
-	const std::filesystem::path savePath = phx::saveDir + m_save->getName() +
-	                                       '/' + m_mapName + '.' + posString +
-	                                       ".save";
+	const std::filesystem::path savePath =
+	    phx::saveDir + save + '/' + mapName + '.' + posString + ".region";
 
 	return savePath;
 }
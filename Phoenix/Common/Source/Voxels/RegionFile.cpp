@@ -0,0 +1,385 @@
+// Copyright 2019-20 Genten Studios
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors
+// may be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include <Common/Logger.hpp>
+#include <Common/Utility/Compression.hpp>
+#include <Common/Utility/Internal/Endian.hpp>
+#include <Common/Voxels/RegionFile.hpp>
+
+#include <cstring>
+
+using namespace phx::voxels;
+
+namespace
+{
+	int floorDiv(int value, int divisor)
+	{
+		return value >= 0 ? value / divisor : (value + 1) / divisor - 1;
+	}
+
+	int positiveMod(int value, int divisor)
+	{
+		return ((value % divisor) + divisor) % divisor;
+	}
+} // namespace
+
+RegionFile::RegionFile(const std::filesystem::path& path)
+{
+	if (!std::filesystem::exists(path))
+	{
+		// fstream won't create a file when opened for reading too.
+		std::ofstream create(path, std::ofstream::binary);
+	}
+
+	m_file.open(path, std::fstream::in | std::fstream::out |
+	                      std::fstream::binary);
+
+	if (!m_file)
+	{
+		LOG_WARNING("REGION") << "Could not open region file: "
+		                      << path.string();
+		return;
+	}
+
+	if (readHeader() == 1)
+	{
+		upgradeFromVersion1(path);
+	}
+}
+
+RegionFile::~RegionFile() { flush(); }
+
+bool RegionFile::isOpen() const { return m_file.is_open(); }
+
+bool RegionFile::has(std::size_t index) const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return index < REGION_MAX_CHUNKS && m_entries[index].length != 0;
+}
+
+bool RegionFile::read(std::size_t index, phx::data::Data& data)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	if (!isOpen() || index >= REGION_MAX_CHUNKS ||
+	    m_entries[index].length == 0)
+	{
+		return false;
+	}
+
+	const Entry& entry = m_entries[index];
+
+	data.resize(entry.length);
+	m_file.seekg(static_cast<std::streamoff>(entry.sector) * SECTOR_SIZE);
+	m_file.read(reinterpret_cast<char*>(data.data()), entry.length);
+
+	if (m_file.gcount() != static_cast<std::streamsize>(entry.length))
+	{
+		LOG_WARNING("REGION") << "Region file is truncated, could not read "
+		                         "chunk "
+		                      << index;
+		m_file.clear();
+		return false;
+	}
+
+	return true;
+}
+
+bool RegionFile::write(std::size_t index, const phx::data::Data& data)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	if (!isOpen() || index >= REGION_MAX_CHUNKS || data.empty() ||
+	    data.size() > UINT32_MAX)
+	{
+		return false;
+	}
+
+	Entry&            entry   = m_entries[index];
+	const std::size_t needed  = sectorsFor(data.size());
+	const std::size_t current = entry.length != 0 ? sectorsFor(entry.length) : 0;
+
+	std::uint32_t sector;
+	if (current != 0 && needed <= current)
+	{
+		// still fits, rewrite in place and give back what isn't needed.
+		sector = entry.sector;
+		markSectors(sector + static_cast<std::uint32_t>(needed),
+		            current - needed, false);
+	}
+	else
+	{
+		markSectors(entry.sector, current, false);
+		sector = allocate(needed);
+	}
+
+	m_file.seekp(static_cast<std::streamoff>(sector) * SECTOR_SIZE);
+	m_file.write(reinterpret_cast<const char*>(data.data()), data.size());
+
+	// pad up to the sector boundary so the file always ends on one.
+	static const std::array<char, SECTOR_SIZE> padding {};
+	m_file.write(padding.data(), needed * SECTOR_SIZE - data.size());
+
+	entry.sector = sector;
+	entry.length = static_cast<std::uint32_t>(data.size());
+	writeEntry(index);
+
+	if (!m_file)
+	{
+		LOG_WARNING("REGION") << "Failed to write chunk " << index
+		                      << " to region file.";
+		m_file.clear();
+		return false;
+	}
+
+	return true;
+}
+
+void RegionFile::flush()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	if (isOpen())
+	{
+		m_file.flush();
+	}
+}
+
+phx::math::vec3i RegionFile::toRegionPos(const math::vec3i& chunkIndex)
+{
+	return {floorDiv(chunkIndex.x, REGION_SIZE),
+	        floorDiv(chunkIndex.y, REGION_SIZE),
+	        floorDiv(chunkIndex.z, REGION_SIZE)};
+}
+
+std::size_t RegionFile::toLocalIndex(const math::vec3i& chunkIndex)
+{
+	const int x = positiveMod(chunkIndex.x, REGION_SIZE);
+	const int y = positiveMod(chunkIndex.y, REGION_SIZE);
+	const int z = positiveMod(chunkIndex.z, REGION_SIZE);
+
+	return static_cast<std::size_t>(x + REGION_SIZE * (y + REGION_SIZE * z));
+}
+
+std::size_t RegionFile::sectorsFor(std::size_t length)
+{
+	return (length + SECTOR_SIZE - 1) / SECTOR_SIZE;
+}
+
+std::uint32_t RegionFile::readHeader()
+{
+	m_file.seekg(0, std::fstream::end);
+	const std::size_t fileSize = static_cast<std::size_t>(m_file.tellg());
+
+	std::array<std::uint32_t, 2> preamble {};
+	if (fileSize >= HEADER_SECTORS * SECTOR_SIZE)
+	{
+		m_file.seekg(0);
+		m_file.read(reinterpret_cast<char*>(preamble.data()),
+		            sizeof(preamble));
+	}
+
+	const std::uint32_t version = data::endian::swapForHost(preamble[1]);
+	if (data::endian::swapForHost(preamble[0]) != MAGIC ||
+	    (version != VERSION && version != 1))
+	{
+		if (fileSize != 0)
+		{
+			LOG_WARNING("REGION") << "Region file has an invalid header, it "
+			                         "will be overwritten.";
+		}
+
+		m_file.clear();
+		writeHeader();
+		return VERSION;
+	}
+
+	std::vector<std::uint32_t> table(REGION_MAX_CHUNKS * 2);
+	m_file.seekg(SECTOR_SIZE);
+	m_file.read(reinterpret_cast<char*>(table.data()),
+	            table.size() * sizeof(std::uint32_t));
+
+	const std::size_t fileSectors = sectorsFor(fileSize);
+	m_usedSectors.assign(fileSectors, false);
+	markSectors(0, HEADER_SECTORS, true);
+
+	for (std::size_t i = 0; i < REGION_MAX_CHUNKS; ++i)
+	{
+		Entry entry;
+		entry.sector = data::endian::swapForHost(table[i * 2]);
+		entry.length = data::endian::swapForHost(table[i * 2 + 1]);
+
+		if (entry.length == 0)
+		{
+			continue;
+		}
+
+		const std::size_t sectors = sectorsFor(entry.length);
+		if (entry.sector < HEADER_SECTORS ||
+		    entry.sector + sectors > fileSectors)
+		{
+			LOG_WARNING("REGION") << "Chunk " << i
+			                      << " points outside of its region file, "
+			                         "it will be regenerated.";
+			continue;
+		}
+
+		m_entries[i] = entry;
+		markSectors(entry.sector, sectors, true);
+	}
+
+	return version;
+}
+
+void RegionFile::upgradeFromVersion1(const std::filesystem::path& path)
+{
+	// the upgraded region is written to a file of its own and only replaces
+	// this one once it is complete, being stopped part way through leaves
+	// the old file as it was rather than a mix of both versions.
+	std::filesystem::path upgradePath = path;
+	upgradePath += ".upgrade";
+
+	std::error_code error;
+	std::filesystem::remove(upgradePath, error);
+
+	std::size_t upgraded = 0;
+	bool        written  = true;
+	{
+		RegionFile upgrade(upgradePath);
+		written = upgrade.isOpen();
+
+		for (std::size_t i = 0; i < REGION_MAX_CHUNKS && written; ++i)
+		{
+			data::Data data;
+			if (!read(i, data))
+			{
+				continue;
+			}
+
+			// version 1 payloads are the serialized chunk as is.
+			written = upgrade.write(
+			    i, data::Compression::compress(data, data::Codec::NONE));
+			++upgraded;
+		}
+	}
+
+	m_file.close();
+	if (written)
+	{
+		std::filesystem::rename(upgradePath, path, error);
+	}
+
+	if (!written || error)
+	{
+		// left closed, a version 1 payload read as a version 2 one would
+		// look damaged and be regenerated.
+		LOG_WARNING("REGION") << "Could not upgrade region file "
+		                      << path.string() << ", it will not be used.";
+		std::filesystem::remove(upgradePath, error);
+		return;
+	}
+
+	m_file.open(path, std::fstream::in | std::fstream::out |
+	                      std::fstream::binary);
+	if (!m_file)
+	{
+		LOG_WARNING("REGION") << "Could not open region file: "
+		                      << path.string();
+		return;
+	}
+
+	m_entries.fill({});
+	readHeader();
+
+	LOG_INFO("REGION") << "Upgraded " << upgraded
+	                   << " chunks to region format version " << VERSION;
+}
+
+void RegionFile::writeHeader()
+{
+	m_entries.fill({});
+
+	std::vector<char> header(HEADER_SECTORS * SECTOR_SIZE, 0);
+
+	const std::uint32_t preamble[2] = {data::endian::swapForNetwork(MAGIC),
+	                                   data::endian::swapForNetwork(VERSION)};
+	std::memcpy(header.data(), preamble, sizeof(preamble));
+
+	m_file.seekp(0);
+	m_file.write(header.data(), header.size());
+
+	m_usedSectors.assign(HEADER_SECTORS, true);
+}
+
+void RegionFile::writeEntry(std::size_t index)
+{
+	const std::uint32_t raw[2] = {
+	    data::endian::swapForNetwork(m_entries[index].sector),
+	    data::endian::swapForNetwork(m_entries[index].length)};
+
+	m_file.seekp(static_cast<std::streamoff>(SECTOR_SIZE + index * sizeof(raw)));
+	m_file.write(reinterpret_cast<const char*>(raw), sizeof(raw));
+}
+
+std::uint32_t RegionFile::allocate(std::size_t sectors)
+{
+	// first fit, regions are small enough that a linear scan is fine.
+	std::size_t runStart  = HEADER_SECTORS;
+	std::size_t runLength = 0;
+	for (std::size_t i = HEADER_SECTORS; i < m_usedSectors.size(); ++i)
+	{
+		if (m_usedSectors[i])
+		{
+			runStart  = i + 1;
+			runLength = 0;
+			continue;
+		}
+
+		if (++runLength == sectors)
+		{
+			break;
+		}
+	}
+
+	// if no run was big enough, runStart is the beginning of the free space
+	// at the end of the file (or the end itself), so just grow from there.
+	if (runStart + sectors > m_usedSectors.size())
+	{
+		m_usedSectors.resize(runStart + sectors, false);
+	}
+
+	markSectors(static_cast<std::uint32_t>(runStart), sectors, true);
+	return static_cast<std::uint32_t>(runStart);
+}
+
+void RegionFile::markSectors(std::uint32_t sector, std::size_t count,
+                             bool used)
+{
+	for (std::size_t i = sector; i < sector + count && i < m_usedSectors.size();
+	     ++i)
+	{
+		m_usedSectors[i] = used;
+	}
+}
@@ -0,0 +1,169 @@
+#include <catch2/catch.hpp>
+
+#include <Common/Input.hpp>
+
+using namespace phx;
+
+namespace
+{
+	InputBatch roundTrip(const InputBatch& batch, std::size_t* size = nullptr)
+	{
+		Serializer ser;
+		ser << batch;
+		if (size != nullptr)
+		{
+			*size = ser.getBuffer().size();
+		}
+
+		InputBatch result;
+		Serializer in;
+		in.setView(ser.getBuffer().data(), ser.getBuffer().size());
+		in >> result;
+		return result;
+	}
+
+	bool sameState(const InputState& lhs, const InputState& rhs)
+	{
+		return lhs.sequence == rhs.sequence && lhs.forward == rhs.forward &&
+		       lhs.backward == rhs.backward && lhs.left == rhs.left &&
+		       lhs.right == rhs.right && lhs.up == rhs.up &&
+		       lhs.down == rhs.down && lhs.rotation.x == rhs.rotation.x &&
+		       lhs.rotation.y == rhs.rotation.y;
+	}
+} // namespace
+
+SCENARIO("Batching input states.", "[Input]")
+{
+	InputBatch batch;
+	for (std::size_t i = 0; i < 5; ++i)
+	{
+		InputState state;
+		state.sequence = 1000 - i;
+		state.forward  = true;
+		state.setRotation({1.5f, -0.75f, 0.f});
+		batch.states.push_back(state);
+	}
+
+	GIVEN("States where nothing changes.")
+	{
+		InputBatch newest;
+		newest.states.push_back(batch.states.front());
+
+		std::size_t newestSize;
+		roundTrip(newest, &newestSize);
+
+		std::size_t size;
+		InputBatch  result = roundTrip(batch, &size);
+
+		THEN("Every state after the newest takes a byte at most.")
+		{
+			REQUIRE(size <= newestSize + batch.states.size() - 1);
+			REQUIRE(result.states.size() == batch.states.size());
+			for (std::size_t i = 0; i < batch.states.size(); ++i)
+			{
+				REQUIRE(sameState(result.states[i], batch.states[i]));
+			}
+		}
+	}
+
+	GIVEN("States with changing keys, rotations and a skipped sequence.")
+	{
+		batch.states[1].forward    = false;
+		batch.states[1].left       = true;
+		batch.states[2].rotation.x = 100;
+		batch.states[3].up         = true;
+		batch.states[3].rotation.y = 65535;
+		batch.states[3].sequence   = 990;
+		batch.states[4].sequence   = 989;
+
+		InputBatch result = roundTrip(batch);
+
+		THEN("They come back the same.")
+		{
+			REQUIRE(result.states.size() == batch.states.size());
+			for (std::size_t i = 0; i < batch.states.size(); ++i)
+			{
+				REQUIRE(sameState(result.states[i], batch.states[i]));
+			}
+		}
+	}
+
+	GIVEN("Sequences that wrap around 16 bits.")
+	{
+		for (std::size_t i = 0; i < batch.states.size(); ++i)
+		{
+			batch.states[i].sequence = 0x10001 - i;
+		}
+
+		InputBatch result = roundTrip(batch);
+
+		THEN("Only their lowest 16 bits come back.")
+		{
+			REQUIRE(result.states.size() == batch.states.size());
+			REQUIRE(result.states[0].sequence == 1);
+			REQUIRE(result.states[1].sequence == 0);
+			REQUIRE(result.states[2].sequence == 0xFFFF);
+			REQUIRE(BitReader::unwrapSequence(
+			            static_cast<std::uint16_t>(result.states[2].sequence),
+			            0x10001) == 0xFFFF);
+		}
+	}
+
+	GIVEN("A single state.")
+	{
+		Serializer ser;
+		ser << batch.states.front();
+
+		THEN("It fits in a handful of bytes.")
+		{
+			REQUIRE(ser.getBuffer().size() <= 7);
+
+			InputState state;
+			ser >> state;
+			REQUIRE(sameState(state, batch.states.front()));
+		}
+	}
+
+	GIVEN("A rotation that has turned past a whole circle.")
+	{
+		InputState state;
+		state.setRotation({1.5f + 4 * math::PI, -0.75f, 0.f});
+
+		THEN("It is the same as the rotation within the circle.")
+		{
+			REQUIRE(state.rotation.x == batch.states[0].rotation.x);
+			REQUIRE(state.getRotation().x == Approx(1.5f).margin(1e-4f));
+			REQUIRE(state.getRotation().y == Approx(-0.75f).margin(1e-4f));
+		}
+	}
+
+	GIVEN("A batch that was cut short.")
+	{
+		Serializer ser;
+		ser << batch;
+
+		Serializer in;
+		in.setView(ser.getBuffer().data(), ser.getBuffer().size() - 2);
+
+		InputBatch result;
+		in >> result;
+
+		THEN("Nothing is read from it.")
+		{
+			REQUIRE(result.states.empty());
+		}
+	}
+
+	GIVEN("A batch that skips back further than can be unwrapped.")
+	{
+		batch.states[1].sequence = batch.states[0].sequence - 0x9000;
+		batch.states.resize(2);
+
+		InputBatch result = roundTrip(batch);
+
+		THEN("Nothing is read from it.")
+		{
+			REQUIRE(result.states.empty());
+		}
+	}
+}
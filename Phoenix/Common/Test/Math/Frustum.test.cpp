@@ -0,0 +1,139 @@
+#include <catch2/catch.hpp>
+
+#include <Common/Math/Frustum.hpp>
+
+#include <chrono>
+#include <random>
+
+using namespace phx::math;
+using Vec3 = detail::Vector3<float>;
+
+namespace
+{
+	// looking down -z from the origin, like a camera that hasn't moved.
+	detail::Matrix4x4 makeViewProjection()
+	{
+		return detail::Matrix4x4::perspective(16.f / 9.f, 45.f, 1000.f, 0.1f) *
+		       detail::Matrix4x4::lookAt({0, 0, 0}, {0, 0, -1}, {0, 1, 0});
+	}
+} // namespace
+
+TEST_CASE("Frustum keeps boxes in front and culls the ones behind",
+          "[Frustum]")
+{
+	const Frustum frustum(makeViewProjection());
+
+	// in front, behind, past the far plane, off to the side and above.
+	REQUIRE(frustum.intersects({-1, -1, -11}, {1, 1, -9}));
+	REQUIRE_FALSE(frustum.intersects({-1, -1, 9}, {1, 1, 11}));
+	REQUIRE_FALSE(frustum.intersects({-1, -1, -1101}, {1, 1, -1099}));
+	REQUIRE_FALSE(frustum.intersects({99, -1, -11}, {101, 1, -9}));
+	REQUIRE_FALSE(frustum.intersects({-1, 99, -11}, {1, 101, -9}));
+
+	// the camera is inside this one.
+	REQUIRE(frustum.intersects({-5, -5, -5}, {5, 5, 5}));
+
+	// a box only partly inside the left plane.
+	REQUIRE(frustum.intersects({-20, -1, -11}, {-5, 1, -9}));
+}
+
+TEST_CASE("Default frustum contains everything", "[Frustum]")
+{
+	const Frustum frustum;
+
+	REQUIRE(frustum.intersects({-1, -1, 9}, {1, 1, 11}));
+	REQUIRE(frustum.intersects({1e6f, 1e6f, 1e6f}, {1e6f, 1e6f, 1e6f}));
+}
+
+TEST_CASE("Frustum culls packed boxes the same as one at a time",
+          "[Frustum]")
+{
+	const Frustum frustum(makeViewProjection());
+
+	std::mt19937                          rng(7);
+	std::uniform_real_distribution<float> position(-200.f, 200.f);
+
+	PackedBoxes boxes;
+	boxes.extent = {32, 32, 32};
+	for (int i = 0; i < 1000; ++i)
+	{
+		boxes.push({position(rng), position(rng), position(rng)});
+	}
+
+	std::vector<std::uint8_t> visible;
+	const std::size_t         inside = frustum.cull(boxes, visible);
+
+	REQUIRE(visible.size() == boxes.size());
+
+	std::size_t expected = 0;
+	for (std::size_t i = 0; i < boxes.size(); ++i)
+	{
+		const Vec3 min = {boxes.x[i], boxes.y[i], boxes.z[i]};
+		const bool intersects = frustum.intersects(min, min + boxes.extent);
+
+		REQUIRE((visible[i] == 1) == intersects);
+		expected += intersects ? 1 : 0;
+	}
+
+	REQUIRE(inside == expected);
+
+	// about a tenth of random boxes around the camera are in view.
+	REQUIRE(inside > 0);
+	REQUIRE(inside < boxes.size() / 2);
+}
+
+// Compares testing every chunk in a view distance of 16 against the frustum
+// one at a time against culling them all at once. Hidden by default, run with:
+// PhoenixCommon_test "[benchmark]"
+TEST_CASE("Benchmark Frustum Culling", "[.][benchmark]")
+{
+	using Clock = std::chrono::steady_clock;
+
+	const Frustum frustum(makeViewProjection());
+
+	// every chunk within a view distance of 16.
+	PackedBoxes boxes;
+	boxes.extent = {36, 36, 36};
+	for (int x = -16; x <= 16; ++x)
+	{
+		for (int y = -16; y <= 16; ++y)
+		{
+			for (int z = -16; z <= 16; ++z)
+			{
+				boxes.push({x * 32.f - 2.f, y * 32.f - 2.f, z * 32.f - 2.f});
+			}
+		}
+	}
+
+	constexpr int iterations = 100;
+
+	std::size_t single = 0;
+	const auto  start  = Clock::now();
+	for (int i = 0; i < iterations; ++i)
+	{
+		single = 0;
+		for (std::size_t j = 0; j < boxes.size(); ++j)
+		{
+			const Vec3 min = {boxes.x[j], boxes.y[j], boxes.z[j]};
+			single += frustum.intersects(min, min + boxes.extent) ? 1 : 0;
+		}
+	}
+	const std::chrono::duration<float, std::micro> singleTime =
+	    Clock::now() - start;
+
+	std::vector<std::uint8_t> visible;
+	std::size_t               packed      = 0;
+	const auto                packedStart = Clock::now();
+	for (int i = 0; i < iterations; ++i)
+	{
+		packed = frustum.cull(boxes, visible);
+	}
+	const std::chrono::duration<float, std::micro> packedTime =
+	    Clock::now() - packedStart;
+
+	WARN(boxes.size() << " chunks, " << packed << " in view. One at a time: "
+	                  << singleTime.count() / iterations << "us, packed: "
+	                  << packedTime.count() / iterations << "us.");
+
+	REQUIRE(single == packed);
+}
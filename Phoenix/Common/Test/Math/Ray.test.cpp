@@ -0,0 +1,188 @@
+#include <catch2/catch.hpp>
+
+#include <Common/Math/Ray.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <set>
+#include <tuple>
+#include <vector>
+
+using namespace phx::math;
+using namespace phx::math::detail;
+
+namespace
+{
+	using Voxel = std::tuple<int, int, int>;
+
+	Voxel toVoxel(const Vector3<int>& block)
+	{
+		return {block.x, block.y, block.z};
+	}
+} // namespace
+
+SCENARIO("Casting a ray through voxels.", "[Ray]")
+{
+	GIVEN("A ray along the x axis.")
+	{
+		Ray ray({0.5f, 0.5f, 0.5f}, {1.f, 0.f, 0.f});
+
+		WHEN("A voxel in its way stops it.")
+		{
+			const RayHit hit = ray.traverse(
+			    10.f, [](const Vector3<int>& block) { return block.x == 3; });
+
+			THEN("It stops at the face it went in through.")
+			{
+				REQUIRE(hit.hit);
+				REQUIRE(hit.block == Vector3<int> {3, 0, 0});
+				REQUIRE(hit.normal == Vector3<int> {-1, 0, 0});
+				REQUIRE(hit.distance == Approx(2.5f));
+			}
+		}
+
+		WHEN("It runs out before anything stops it.")
+		{
+			std::vector<Vector3<int>> visited;
+			const RayHit              hit =
+			    ray.traverse(2.f, [&visited](const Vector3<int>& block) {
+				    visited.push_back(block);
+				    return false;
+			    });
+
+			THEN("Only the voxels within reach are visited.")
+			{
+				REQUIRE_FALSE(hit.hit);
+				REQUIRE(visited.size() == 3);
+				REQUIRE(hit.block == Vector3<int> {2, 0, 0});
+			}
+		}
+
+		WHEN("The voxel it starts in stops it.")
+		{
+			const RayHit hit =
+			    ray.traverse(10.f, [](const Vector3<int>&) { return true; });
+
+			THEN("There is no face it went in through.")
+			{
+				REQUIRE(hit.hit);
+				REQUIRE(hit.block == Vector3<int> {0, 0, 0});
+				REQUIRE(hit.normal == Vector3<int> {0, 0, 0});
+				REQUIRE(hit.distance == 0.f);
+			}
+		}
+	}
+
+	GIVEN("A ray going down from below the origin.")
+	{
+		Ray ray({-0.5f, -0.25f, -0.5f}, {0.f, -1.f, 0.f});
+
+		THEN("It goes into the voxel below through its top.")
+		{
+			const RayHit hit = ray.traverse(
+			    10.f, [](const Vector3<int>& block) { return block.y == -3; });
+
+			REQUIRE(hit.block == Vector3<int> {-1, -3, -1});
+			REQUIRE(hit.normal == Vector3<int> {0, 1, 0});
+			REQUIRE(hit.distance == Approx(1.75f));
+		}
+	}
+
+	GIVEN("Rays in random directions.")
+	{
+		std::mt19937                          random(5);
+		std::uniform_real_distribution<float> start(-20.f, 20.f);
+		std::uniform_real_distribution<float> direction(-1.f, 1.f);
+
+		THEN("Every voxel they pass through is visited once, in order.")
+		{
+			for (int i = 0; i < 200; ++i)
+			{
+				const Vector3<float> from = {start(random), start(random),
+				                             start(random)};
+				const Vector3<float> dir  = Vector3<float>::normalize(
+				    {direction(random), direction(random), direction(random)});
+
+				std::set<Voxel> visited;
+				Ray(from, dir).traverse(16.f, [&](const Vector3<int>& block) {
+					visited.insert(toVoxel(block));
+					return false;
+				});
+
+				// walking again, stopping at every voxel in turn, gives the
+				// face each one was entered through.
+				Vector3<int> previous = {static_cast<int>(std::floor(from.x)),
+				                         static_cast<int>(std::floor(from.y)),
+				                         static_cast<int>(std::floor(from.z))};
+				std::size_t  count    = 0;
+				Ray(from, dir).traverse(16.f, [&](const Vector3<int>& block) {
+					if (count++ > 0)
+					{
+						const Vector3<int> step = block - previous;
+						REQUIRE(std::abs(step.x) + std::abs(step.y) +
+						            std::abs(step.z) ==
+						        1);
+					}
+					previous = block;
+					return false;
+				});
+				REQUIRE(count == visited.size());
+
+				// any point on the ray is in a visited voxel, as long as it
+				// isn't right on the edge of one.
+				for (float t = 0.f; t < 16.f; t += 0.01f)
+				{
+					const Vector3<float> point = from + dir * t;
+					const Vector3<float> cell  = {std::floor(point.x),
+					                              std::floor(point.y),
+					                              std::floor(point.z)};
+
+					const Vector3<float> offset = point - cell;
+					const float          edge =
+					    std::min({offset.x, offset.y, offset.z, 1.f - offset.x,
+					              1.f - offset.y, 1.f - offset.z});
+					if (edge < 1e-3f || t > 16.f - 1e-3f)
+					{
+						continue;
+					}
+
+					REQUIRE(visited.count({static_cast<int>(cell.x),
+					                       static_cast<int>(cell.y),
+					                       static_cast<int>(cell.z)}) == 1);
+				}
+			}
+		}
+
+		THEN("Each stop is entered from the voxel before it.")
+		{
+			for (int i = 0; i < 200; ++i)
+			{
+				const Vector3<float> from = {start(random), start(random),
+				                             start(random)};
+				const Vector3<float> dir  = Vector3<float>::normalize(
+				    {direction(random), direction(random), direction(random)});
+
+				Vector3<int>      previous;
+				std::size_t       count  = 0;
+				const std::size_t stopAt = i % 12 + 1;
+				const auto stop = [&](const Vector3<int>& block) {
+					if (count++ == stopAt)
+					{
+						return true;
+					}
+					previous = block;
+					return false;
+				};
+
+				const RayHit hit = Ray(from, dir).traverse(16.f, stop);
+
+				if (hit.hit)
+				{
+					REQUIRE(hit.block + hit.normal == previous);
+					REQUIRE(hit.distance <= 16.f);
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,262 @@
+#include <catch2/catch.hpp>
+
+#include <Common/Network/Snapshot.hpp>
+#include <Common/Voxels/ChunkViewTracker.hpp>
+
+#include <random>
+
+using namespace phx;
+using namespace phx::net;
+
+namespace
+{
+	EntityState makeEntity(std::uint32_t id, float x, float y, float z)
+	{
+		Position position;
+		position.position = {x, y, z};
+		return EntityState::quantize(id, position);
+	}
+
+	bool send(SnapshotSender& sender, SnapshotReceiver& receiver,
+	          const Snapshot& snapshot, std::size_t* size = nullptr)
+	{
+		Serializer ser;
+		sender.write(snapshot, ser);
+		if (size != nullptr)
+		{
+			*size = ser.getBuffer().size();
+		}
+
+		Serializer in;
+		in.setView(ser.getBuffer().data(), ser.getBuffer().size());
+		return receiver.read(in);
+	}
+} // namespace
+
+SCENARIO("Sending snapshots to a client.", "[Snapshot]")
+{
+	SnapshotSender   sender;
+	SnapshotReceiver receiver;
+
+	Snapshot snapshot;
+	snapshot.sequence = 7;
+	snapshot.self     = 3;
+	snapshot.entities = {makeEntity(3, 1.f, 2.f, 3.f),
+	                     makeEntity(9, -4.f, 0.5f, 100.f),
+	                     makeEntity(12, 0.f, 0.f, 0.f)};
+
+	GIVEN("A client that hasn't acknowledged anything.")
+	{
+		std::size_t fullSize;
+		REQUIRE(send(sender, receiver, snapshot, &fullSize));
+
+		THEN("It gets the whole snapshot.")
+		{
+			const Snapshot* latest = receiver.getLatest();
+			REQUIRE(latest != nullptr);
+			REQUIRE(latest->tick == 1);
+			REQUIRE(latest->sequence == 7);
+			REQUIRE(latest->self == 3);
+			REQUIRE(latest->entities == snapshot.entities);
+			REQUIRE(latest->find(9)->dequantize().position.z ==
+			        Approx(100.f));
+			REQUIRE(latest->find(4) == nullptr);
+		}
+
+		WHEN("It acknowledges the snapshot and one entity moves.")
+		{
+			sender.acknowledge(receiver.getAcknowledgement());
+
+			snapshot.entities[1] = makeEntity(9, -4.f, 0.5f, 101.f);
+
+			std::size_t deltaSize;
+			REQUIRE(send(sender, receiver, snapshot, &deltaSize));
+
+			THEN("Only the change is sent.")
+			{
+				REQUIRE(deltaSize < fullSize);
+				REQUIRE(receiver.getLatest()->entities == snapshot.entities);
+			}
+		}
+
+		WHEN("Entities come into and go out of view.")
+		{
+			sender.acknowledge(receiver.getAcknowledgement());
+
+			snapshot.entities = {makeEntity(1, 5.f, 5.f, 5.f),
+			                     makeEntity(3, 1.f, 2.f, 3.f),
+			                     makeEntity(12, 0.f, -1.f, 0.f),
+			                     makeEntity(40, 8.f, 8.f, 8.f)};
+			REQUIRE(send(sender, receiver, snapshot));
+
+			THEN("The client sees the same entities as the server.")
+			{
+				REQUIRE(receiver.getLatest()->entities == snapshot.entities);
+			}
+		}
+
+		WHEN("Snapshots are lost before one arrives.")
+		{
+			sender.acknowledge(receiver.getAcknowledgement());
+
+			Serializer lost;
+			snapshot.entities[0] = makeEntity(3, 1.f, 2.f, 4.f);
+			sender.write(snapshot, lost);
+			snapshot.entities[0] = makeEntity(3, 1.f, 2.f, 5.f);
+			sender.write(snapshot, lost);
+
+			snapshot.entities[0] = makeEntity(3, 1.f, 2.f, 6.f);
+			REQUIRE(send(sender, receiver, snapshot));
+
+			THEN("It is still read against the acknowledged snapshot.")
+			{
+				REQUIRE(receiver.getLatest()->tick == 4);
+				REQUIRE(receiver.getLatest()->entities == snapshot.entities);
+			}
+		}
+	}
+
+	GIVEN("A snapshot that turns up after a newer one.")
+	{
+		Serializer late;
+		sender.write(snapshot, late);
+		REQUIRE(send(sender, receiver, snapshot));
+
+		THEN("It is dropped.")
+		{
+			Serializer in;
+			in.setView(late.getBuffer().data(), late.getBuffer().size());
+			REQUIRE_FALSE(receiver.read(in));
+			REQUIRE(receiver.getLatest()->tick == 2);
+		}
+	}
+
+	GIVEN("A delta against a snapshot the client never got.")
+	{
+		SnapshotReceiver other;
+		REQUIRE(send(sender, other, snapshot));
+		sender.acknowledge(1);
+
+		THEN("It can't be read.")
+		{
+			REQUIRE_FALSE(send(sender, receiver, snapshot));
+			REQUIRE(receiver.getLatest() == nullptr);
+		}
+	}
+}
+
+TEST_CASE("Soak Test Snapshots With 64 Players", "[Snapshot]")
+{
+	constexpr std::size_t players   = 64;
+	constexpr int         ticks     = 600;
+	constexpr float       moveSpeed = 10.f * 2.f / 20.f;
+
+	struct SimulatedPlayer
+	{
+		Position                 position;
+		voxels::ChunkViewTracker view {3, 4};
+		SnapshotSender           sender;
+		SnapshotReceiver         receiver;
+	};
+
+	std::mt19937                          random(64);
+	std::uniform_real_distribution<float> spawn(-256.f, 256.f);
+	std::uniform_real_distribution<float> turn(-0.3f, 0.3f);
+	std::bernoulli_distribution           lost(0.05);
+
+	std::vector<SimulatedPlayer> simulated(players);
+	for (SimulatedPlayer& player : simulated)
+	{
+		player.position.position = {spawn(random), 0.f, spawn(random)};
+		player.position.rotation = {turn(random) * 10.f, 0.f, 0.f};
+	}
+
+	std::size_t bytes       = 0;
+	std::size_t received    = 0;
+	std::size_t mismatched  = 0;
+	std::size_t visible     = 0;
+	std::size_t naiveBytes  = 0;
+
+	for (int tick = 0; tick < ticks; ++tick)
+	{
+		std::vector<EntityState> entities;
+		for (std::size_t i = 0; i < players; ++i)
+		{
+			SimulatedPlayer& player = simulated[i];
+
+			// most players are walking in a direction, some are standing
+			// still.
+			if (i % 4 != 0)
+			{
+				player.position.rotation.x += turn(random);
+				player.position.position += player.position.getForward() *
+				                            moveSpeed;
+			}
+
+			player.view.move(voxels::getChunkPos(
+			    voxels::toBlockPos(player.position.position / 2.f)));
+			entities.push_back(EntityState::quantize(
+			    static_cast<std::uint32_t>(i), player.position));
+		}
+
+		for (std::size_t i = 0; i < players; ++i)
+		{
+			SimulatedPlayer& player = simulated[i];
+
+			Snapshot snapshot;
+			snapshot.sequence = static_cast<std::size_t>(tick);
+			snapshot.self     = static_cast<std::uint32_t>(i);
+			for (const EntityState& entity : entities)
+			{
+				const math::vec3 block = math::vec3(entity.position) /
+				                         EntityState::POSITION_SCALE / 2.f;
+				if (entity.id == i || player.view.isInRange(voxels::getChunkPos(
+				                          voxels::toBlockPos(block))))
+				{
+					snapshot.entities.push_back(entity);
+				}
+			}
+			visible += snapshot.entities.size();
+			naiveBytes += sizeof(std::size_t) + players * 3 * sizeof(float);
+
+			Serializer ser;
+			player.sender.write(snapshot, ser);
+			bytes += ser.getBuffer().size();
+
+			if (lost(random))
+			{
+				continue;
+			}
+
+			Serializer in;
+			in.setView(ser.getBuffer().data(), ser.getBuffer().size());
+			if (!player.receiver.read(in))
+			{
+				continue;
+			}
+
+			++received;
+			if (!(player.receiver.getLatest()->entities == snapshot.entities))
+			{
+				++mismatched;
+			}
+
+			// the acknowledgement goes back with the next input, which can
+			// be lost too.
+			if (!lost(random))
+			{
+				player.sender.acknowledge(
+				    player.receiver.getAcknowledgement());
+			}
+		}
+	}
+
+	const std::size_t sent = players * ticks;
+
+	REQUIRE(mismatched == 0);
+	// everything that wasn't lost could be read.
+	REQUIRE(received > sent * 9 / 10);
+	// fewer than every player is visible to every other player.
+	REQUIRE(visible < sent * players / 2);
+	REQUIRE(bytes * 10 < naiveBytes);
+}
@@ -0,0 +1,74 @@
+#include <catch2/catch.hpp>
+
+#include <Common/Utility/Compression.hpp>
+
+using namespace phx::data;
+
+TEST_CASE("Validate Compression Frames")
+{
+	Data raw(4096);
+	for (std::size_t i = 0; i < raw.size(); ++i)
+	{
+		raw[i] = static_cast<std::byte>(i % 7);
+	}
+
+	GIVEN("Data compressed with each codec")
+	{
+		for (Codec codec : {Codec::NONE, Codec::DEFLATE})
+		{
+			const Data frame = Compression::compress(raw, codec);
+
+			THEN("It decompresses back to the original data")
+			{
+				Data result;
+				REQUIRE(Compression::decompress(frame.data(), frame.size(),
+				                                result) == FrameStatus::OK);
+				REQUIRE(result == raw);
+			}
+
+			if (Compression::isSupported(codec) && codec != Codec::NONE)
+			{
+				THEN("Repetitive data gets smaller")
+				{
+					REQUIRE(frame.size() < raw.size());
+				}
+			}
+		}
+	}
+
+	GIVEN("A damaged frame")
+	{
+		Data frame = Compression::compress(raw, Codec::DEFLATE);
+		frame.resize(frame.size() / 2);
+
+		THEN("It is rejected")
+		{
+			Data result;
+			REQUIRE(Compression::decompress(frame.data(), frame.size(),
+			                                result) == FrameStatus::DAMAGED);
+		}
+	}
+
+	GIVEN("A frame using a codec this build doesn't know")
+	{
+		Data frame = Compression::compress(raw, Codec::NONE);
+		frame[0]   = std::byte {0x7f};
+
+		THEN("It is reported as unsupported rather than damaged")
+		{
+			Data result;
+			REQUIRE(Compression::decompress(frame.data(), frame.size(),
+			                                result) == FrameStatus::UNSUPPORTED);
+		}
+	}
+
+	GIVEN("A peer that only supports storing data as is")
+	{
+		const std::uint32_t peerCodecs = 1u << static_cast<int>(Codec::NONE);
+
+		THEN("Nothing gets compressed for it")
+		{
+			REQUIRE(Compression::negotiate(peerCodecs) == Codec::NONE);
+		}
+	}
+}
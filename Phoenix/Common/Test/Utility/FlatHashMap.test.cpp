@@ -0,0 +1,120 @@
+#include <catch2/catch.hpp>
+
+#include <Common/Utility/FlatHashMap.hpp>
+
+#include <memory>
+#include <random>
+#include <unordered_map>
+
+using namespace phx;
+
+namespace
+{
+	// puts every key in one of a few slots, so probing and shifting
+	// elements back on erase are tested properly.
+	struct ClusteringHasher
+	{
+		std::size_t operator()(int key) const
+		{
+			return static_cast<std::size_t>(key % 4);
+		}
+	};
+} // namespace
+
+TEST_CASE("Validate Flat Hash Map")
+{
+	GIVEN("A map filled with keys that collide")
+	{
+		FlatHashMap<int, int, ClusteringHasher> map;
+		std::unordered_map<int, int>            expected;
+
+		std::mt19937                       random(42);
+		std::uniform_int_distribution<int> key(0, 200);
+
+		bool matches = true;
+		for (int i = 0; i < 5000; ++i)
+		{
+			const int k = key(random);
+			if (i % 3 == 0)
+			{
+				matches &= map.erase(k) == expected.erase(k);
+			}
+			else
+			{
+				const bool added = map.try_emplace(k, i).second;
+				matches &= added == expected.emplace(k, i).second;
+			}
+
+			const auto it         = map.find(k);
+			const auto expectedIt = expected.find(k);
+			if (expectedIt == expected.end())
+			{
+				matches &= it == map.end();
+			}
+			else
+			{
+				matches &= it != map.end() && it->second == expectedIt->second;
+			}
+		}
+
+		THEN("It behaves like std::unordered_map")
+		{
+			REQUIRE(matches);
+			REQUIRE(map.size() == expected.size());
+
+			std::size_t visited = 0;
+			for (const auto& element : map)
+			{
+				REQUIRE(expected.at(element.first) == element.second);
+				++visited;
+			}
+			REQUIRE(visited == expected.size());
+		}
+
+		WHEN("Every key is erased")
+		{
+			for (const auto& element : expected)
+			{
+				map.erase(element.first);
+			}
+
+			THEN("It's empty")
+			{
+				REQUIRE(map.empty());
+				REQUIRE(map.begin() == map.end());
+			}
+		}
+	}
+
+	GIVEN("A map of boxed values")
+	{
+		FlatHashMap<int, std::unique_ptr<int>> map;
+		int* first = map.try_emplace(0, std::make_unique<int>(7))
+		                 .first->second.get();
+
+		WHEN("It grows")
+		{
+			for (int i = 1; i < 1000; ++i)
+			{
+				map.try_emplace(i, std::make_unique<int>(i));
+			}
+
+			THEN("The values stay where they are")
+			{
+				REQUIRE(map.find(0)->second.get() == first);
+				REQUIRE(*first == 7);
+			}
+		}
+
+		WHEN("A key that's already there is added")
+		{
+			const auto result = map.try_emplace(0, std::make_unique<int>(8));
+
+			THEN("The old value is kept")
+			{
+				REQUIRE_FALSE(result.second);
+				REQUIRE(*result.first->second == 7);
+			}
+		}
+	}
+}
@@ -0,0 +1,207 @@
+#include <catch2/catch.hpp>
+
+#include "../Voxels/TestBlocks.hpp"
+
+#include <Common/Utility/Serializer.hpp>
+#include <Common/Voxels/Chunk.hpp>
+
+#include <chrono>
+
+using namespace phx;
+
+TEST_CASE("Validate Serializer Reads")
+{
+	Serializer writer;
+	writer << 42 << 1.5f << std::string("core.grass") << ';';
+	const data::Data data = writer.getBuffer();
+
+	// a string is its length and its characters, with no null terminator.
+	REQUIRE(data.size() == sizeof(int) + sizeof(float) +
+	                           sizeof(std::uint32_t) + 10 + sizeof(char));
+
+	GIVEN("A serializer owning a copy of the data")
+	{
+		Serializer ser;
+		ser.setBuffer(data);
+
+		int         number;
+		float       decimal;
+		std::string id;
+		char        c;
+		ser >> number >> decimal >> id >> c;
+
+		THEN("Everything is read back in order")
+		{
+			REQUIRE(number == 42);
+			REQUIRE(decimal == 1.5f);
+			REQUIRE(id == "core.grass");
+			REQUIRE(c == ';');
+			REQUIRE(ser.empty());
+		}
+	}
+
+	GIVEN("A serializer viewing the data")
+	{
+		Serializer ser;
+		ser.setView(data.data(), data.size());
+
+		int number;
+		ser >> number;
+
+		THEN("Reading moves through the data without changing it")
+		{
+			REQUIRE(number == 42);
+			REQUIRE(ser.remaining() == data.size() - sizeof(int));
+			REQUIRE(ser.getBuffer().empty());
+		}
+	}
+
+	GIVEN("A serializer with less data than is read")
+	{
+		Serializer ser;
+		ser.setView(data.data(), 2);
+
+		int number = 5;
+		ser >> number;
+
+		THEN("The value is zeroed and nothing is left to read")
+		{
+			REQUIRE(number == 0);
+			REQUIRE(ser.empty());
+		}
+	}
+
+	GIVEN("A serializer with a string cut short")
+	{
+		Serializer ser;
+		ser.setView(data.data(), data.size() - 2);
+
+		int         number;
+		float       decimal;
+		std::string id;
+		ser >> number >> decimal >> id;
+
+		THEN("The string isn't read past the end of the data")
+		{
+			REQUIRE(id.empty());
+			REQUIRE(ser.empty());
+			REQUIRE(ser.failed());
+		}
+	}
+}
+
+TEST_CASE("Validate Bit Packing")
+{
+	Serializer writer;
+	{
+		BitWriter bits(writer);
+		bits.writeBool(true);
+		bits.writeBits(5, 3);
+		bits.writeVarint(300);
+		bits.writeSigned(-2);
+		bits.writeQuantized(0.25f, -1.f, 1.f, 10);
+		bits.writeSequence(0xFFFE);
+	}
+	writer << 42;
+	const data::Data data = writer.getBuffer();
+
+	GIVEN("The values read back with a bit reader")
+	{
+		Serializer ser;
+		ser.setView(data.data(), data.size());
+
+		BitReader bits(ser);
+
+		THEN("Everything comes back in as many bits as it was written in")
+		{
+			REQUIRE(bits.readBool());
+			REQUIRE(bits.readBits(3) == 5);
+			REQUIRE(bits.readVarint() == 300);
+			REQUIRE(bits.readSigned() == -2);
+			REQUIRE(bits.readQuantized(-1.f, 1.f, 10) ==
+			        Approx(0.25f).margin(1.f / 1023));
+			REQUIRE(bits.readSequence() == 0xFFFE);
+			REQUIRE(!bits.overflowed());
+
+			// 1 + 3 + 16 + 8 + 10 + 16 bits, padded to the byte.
+			REQUIRE(data.size() == 7 + sizeof(int));
+
+			int number;
+			ser >> number;
+			REQUIRE(number == 42);
+		}
+	}
+
+	GIVEN("More bits read than were written")
+	{
+		Serializer ser;
+		ser.setView(data.data(), 2);
+
+		BitReader bits(ser);
+		bits.readBits(16);
+		REQUIRE(!bits.overflowed());
+
+		THEN("The reader gives zeroes and says it overflowed")
+		{
+			REQUIRE(bits.readBits(8) == 0);
+			REQUIRE(bits.overflowed());
+		}
+	}
+
+	GIVEN("Sequences that wrapped around")
+	{
+		THEN("They are unwrapped to the closest to the reference")
+		{
+			REQUIRE(BitReader::unwrapSequence(0xFFFE, 0x10003) == 0xFFFE);
+			REQUIRE(BitReader::unwrapSequence(2, 0x1FFFE) == 0x20002);
+			REQUIRE(BitReader::unwrapSequence(7, 5) == 7);
+			REQUIRE(BitReader::unwrapSequence(0xFFFF, 2) == 0xFFFF);
+		}
+	}
+}
+
+// Deserializes a chunk where no two neighbouring blocks are the same, so no
+// runs can be used and every block is read on its own. Hidden by default, run
+// with: PhoenixCommon_test "[benchmark]"
+TEST_CASE("Benchmark Chunk Deserialization", "[.][benchmark]")
+{
+	using namespace phx::voxels;
+	using Clock = std::chrono::steady_clock;
+
+	BlockReferrer referrer;
+	test::addTestBlock(referrer, "core.grass");
+	test::addTestBlock(referrer, "core.stone");
+
+	Chunk chunk({0, 0, 0}, &referrer);
+	chunk.getBlocks().fill(referrer.getByID("core.grass"));
+	for (int i = 0; i < Chunk::CHUNK_MAX_BLOCKS; i += 2)
+	{
+		chunk.getBlocks().set(i, referrer.getByID("core.stone"));
+	}
+
+	Serializer writer;
+	writer << chunk;
+	const data::Data data = writer.getBuffer();
+
+	constexpr int iterations = 100;
+
+	const auto start = Clock::now();
+	for (int i = 0; i < iterations; ++i)
+	{
+		Chunk      loaded({0, 0, 0}, &referrer);
+		Serializer ser;
+		ser.setView(data.data(), data.size());
+		ser >> loaded;
+	}
+	const std::chrono::duration<float, std::micro> time = Clock::now() - start;
+
+	WARN("Deserialized a " << data.size() << " byte chunk in "
+	                       << time.count() / iterations << "us.");
+
+	Chunk      loaded({0, 0, 0}, &referrer);
+	Serializer ser;
+	ser.setView(data.data(), data.size());
+	ser >> loaded;
+	REQUIRE(loaded.getBlockAt({1, 0, 0}).type ==
+	        chunk.getBlockAt({1, 0, 0}).type);
+}
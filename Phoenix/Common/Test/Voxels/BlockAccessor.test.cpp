@@ -0,0 +1,230 @@
+#include <catch2/catch.hpp>
+
+#include "TestBlocks.hpp"
+
+#include <Common/Save.hpp>
+#include <Common/Voxels/BlockAccessor.hpp>
+#include <Common/Voxels/Map.hpp>
+
+#include <chrono>
+#include <filesystem>
+#include <random>
+
+using namespace phx;
+using namespace phx::voxels;
+using phx::voxels::test::addTestBlock;
+
+SCENARIO("Reading blocks through an accessor.", "[BlockAccessor]")
+{
+	const std::string saveName = "phx_test_accessor";
+	std::filesystem::remove_all(phx::saveDir + saveName);
+
+	BlockReferrer referrer;
+	addTestBlock(referrer, "core.grass");
+	addTestBlock(referrer, "core.stone");
+	BlockType* stone = referrer.getByID("core.stone");
+
+	GIVEN("A map with blocks scattered around the origin.")
+	{
+		Save save(saveName);
+		Map  map(&save, "map1", &referrer);
+
+		std::mt19937                       random(3);
+		std::uniform_int_distribution<int> coordinate(-40, 39);
+		for (int i = 0; i < 500; ++i)
+		{
+			map.setBlockAt({static_cast<float>(coordinate(random)),
+			                static_cast<float>(coordinate(random)),
+			                static_cast<float>(coordinate(random))},
+			               {stone, nullptr});
+		}
+
+		BlockAccessor blocks(&map);
+
+		WHEN("Blocks are read one at a time.")
+		{
+			THEN("They match the blocks the map gives.")
+			{
+				for (int i = 0; i < 2000; ++i)
+				{
+					const math::vec3i block = {coordinate(random),
+					                           coordinate(random),
+					                           coordinate(random)};
+
+					const math::vec3 position(block);
+					REQUIRE(blocks.getTypeAt(block) ==
+					        map.getBlockAt(position).type);
+					REQUIRE(blocks.getBlockAt(block).type ==
+					        map.getBlockAt(position).type);
+				}
+			}
+		}
+
+		WHEN("A box crossing chunks is read at once.")
+		{
+			const math::vec3i min = {-20, -3, -17};
+			const math::vec3i max = {18, 17, 1};
+
+			std::vector<BlockType*> types;
+			blocks.getTypes(min, max, types);
+
+			THEN("Every block matches reading it on its own.")
+			{
+				REQUIRE(types.size() == 39 * 21 * 19);
+
+				BlockAccessor single(&map);
+				std::size_t   i = 0;
+				for (int z = min.z; z <= max.z; ++z)
+				{
+					for (int y = min.y; y <= max.y; ++y)
+					{
+						for (int x = min.x; x <= max.x; ++x)
+						{
+							REQUIRE(types[i++] == single.getTypeAt({x, y, z}));
+						}
+					}
+				}
+			}
+		}
+
+		WHEN("A box is empty.")
+		{
+			std::vector<BlockType*> types(4);
+			blocks.getTypes({0, 5, 0}, {3, 4, 3}, types);
+
+			THEN("Nothing is read.") { REQUIRE(types.empty()); }
+		}
+	}
+
+	GIVEN("A networked map that has not received any chunks.")
+	{
+		BlockingQueue<std::pair<math::vec3, std::vector<std::byte>>> queue;
+		Map           map(&queue, &referrer);
+		BlockAccessor blocks(&map);
+
+		THEN("Every block is out of bounds.")
+		{
+			BlockType* outOfBounds =
+			    referrer.blocks.get(BlockType::OUT_OF_BOUNDS_BLOCK);
+
+			REQUIRE(blocks.getTypeAt({1, 2, 3}) == outOfBounds);
+			REQUIRE(blocks.getBlockAt({-1, 2, 3}).type == outOfBounds);
+			REQUIRE(blocks.getChunkAt({1, 2, 3}) == nullptr);
+
+			std::vector<BlockType*> types;
+			blocks.getTypes({-2, -2, -2}, {1, 1, 1}, types);
+			REQUIRE(types.size() == 64);
+			for (BlockType* type : types)
+			{
+				REQUIRE(type == outOfBounds);
+			}
+		}
+	}
+
+	std::filesystem::remove_all(phx::saveDir + saveName);
+}
+
+// Compares walking rays and reading a box of blocks through the map against
+// a BlockAccessor. Hidden by default, run with:
+// PhoenixCommon_test "[benchmark]"
+TEST_CASE("Benchmark Block Accessor Walks", "[.][benchmark]")
+{
+	using Clock = std::chrono::steady_clock;
+
+	const std::string saveName = "phx_bench_accessor";
+	std::filesystem::remove_all(phx::saveDir + saveName);
+
+	BlockReferrer referrer;
+	addTestBlock(referrer, "core.grass");
+	BlockType* grassType = referrer.getByID("core.grass");
+
+	Save save(saveName);
+	Map  map(&save, "map1", &referrer);
+
+	// rays like the ones the actors cast, 0.5 blocks a step and 32 steps.
+	std::mt19937                          random(11);
+	std::uniform_real_distribution<float> start(-64.f, 64.f);
+	std::uniform_real_distribution<float> direction(-1.f, 1.f);
+
+	constexpr int rays  = 1 << 15;
+	constexpr int steps = 32;
+
+	std::vector<std::pair<math::vec3, math::vec3>> walks(rays);
+	for (auto& walk : walks)
+	{
+		walk.first  = {start(random), start(random) / 4.f, start(random)};
+		walk.second = math::vec3::normalize(
+		    {direction(random), direction(random), direction(random)});
+	}
+
+	// load everything up front so neither side pays for generating.
+	std::vector<BlockType*> types;
+	BlockAccessor(&map).getTypes({-96, -48, -96}, {96, 48, 96}, types);
+
+	std::size_t grass    = 0;
+	const auto  mapStart = Clock::now();
+	for (const auto& walk : walks)
+	{
+		for (int i = 0; i < steps; ++i)
+		{
+			math::vec3 pos = walk.first + walk.second * (i * 0.5f);
+			pos.floor();
+			grass += map.getBlockAt(pos).type == grassType ? 1 : 0;
+		}
+	}
+	const std::chrono::duration<float> mapTime = Clock::now() - mapStart;
+
+	std::size_t accessorGrass = 0;
+	const auto  accessorStart = Clock::now();
+	for (const auto& walk : walks)
+	{
+		BlockAccessor blocks(&map);
+		for (int i = 0; i < steps; ++i)
+		{
+			math::vec3 pos = walk.first + walk.second * (i * 0.5f);
+			pos.floor();
+			accessorGrass +=
+			    blocks.getTypeAt(math::vec3i(pos)) == grassType ? 1 : 0;
+		}
+	}
+	const std::chrono::duration<float> accessorTime =
+	    Clock::now() - accessorStart;
+
+	// an 8 chunk area read as a box, against a block at a time.
+	const math::vec3i min = {-32, -16, -32};
+	const math::vec3i max = {31, 15, 31};
+
+	BlockAccessor area(&map);
+	const auto    boxStart = Clock::now();
+	area.getTypes(min, max, types);
+	const std::chrono::duration<float> boxTime = Clock::now() - boxStart;
+
+	std::size_t single      = 0;
+	const auto  singleStart = Clock::now();
+	for (int z = min.z; z <= max.z; ++z)
+	{
+		for (int y = min.y; y <= max.y; ++y)
+		{
+			for (int x = min.x; x <= max.x; ++x)
+			{
+				single += area.getTypeAt({x, y, z}) == grassType ? 1 : 0;
+			}
+		}
+	}
+	const std::chrono::duration<float> singleTime = Clock::now() - singleStart;
+
+	const float lookups = static_cast<float>(rays) * steps;
+	WARN("Map::getBlockAt: " << lookups / mapTime.count() / 1e6f
+	                         << "M lookups/s");
+	WARN("BlockAccessor::getTypeAt: "
+	     << lookups / accessorTime.count() / 1e6f << "M lookups/s");
+	WARN("BlockAccessor::getTypes: " << types.size() / boxTime.count() / 1e6f
+	                                 << "M blocks/s, against "
+	                                 << types.size() / singleTime.count() / 1e6f
+	                                 << "M blocks/s a block at a time");
+
+	CHECK(grass == accessorGrass);
+	CHECK(single > 0);
+
+	std::filesystem::remove_all(phx::saveDir + saveName);
+}
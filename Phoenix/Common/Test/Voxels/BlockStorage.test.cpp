@@ -0,0 +1,83 @@
+#include <catch2/catch.hpp>
+
+#include <Common/Voxels/BlockStorage.hpp>
+
+using namespace phx::voxels;
+
+TEST_CASE("Validate BlockStorage Behavior")
+{
+	BlockType air;
+	BlockType stone;
+	BlockType dirt;
+	BlockType sand;
+	BlockType glass;
+
+	GIVEN("A newly created storage filled with air")
+	{
+		BlockStorage storage(4096, &air);
+		REQUIRE(storage.size() == 4096);
+		REQUIRE(storage.isSingleValue());
+		REQUIRE(storage.getBitsPerBlock() == 0);
+		REQUIRE(storage.get(1234) == &air);
+
+		WHEN("A different block is set")
+		{
+			storage.set(10, &stone);
+			THEN("Only that block changes and the indices grow")
+			{
+				REQUIRE(storage.get(10) == &stone);
+				REQUIRE(storage.get(9) == &air);
+				REQUIRE(storage.get(11) == &air);
+				REQUIRE(storage.getBitsPerBlock() == 1);
+				REQUIRE_FALSE(storage.isSingleValue());
+			}
+		}
+		WHEN("Many different blocks are set")
+		{
+			std::vector<BlockType> types(300);
+			for (std::size_t i = 0; i < types.size(); ++i)
+			{
+				storage.set(i * 13, &types[i]);
+			}
+			THEN("Every block reads back as it was written")
+			{
+				REQUIRE(storage.getBitsPerBlock() == 16);
+				for (std::size_t i = 0; i < types.size(); ++i)
+				{
+					REQUIRE(storage.get(i * 13) == &types[i]);
+				}
+				REQUIRE(storage.get(1) == &air);
+			}
+		}
+		WHEN("Blocks are replaced until the palette is full of stale entries")
+		{
+			storage.set(0, &stone);
+			storage.set(1, &dirt);
+			storage.set(2, &sand);
+			REQUIRE(storage.getBitsPerBlock() == 2);
+
+			storage.set(0, &air);
+			storage.set(1, &air);
+			storage.set(2, &air);
+			storage.set(3, &glass);
+			THEN("Unused entries are reclaimed instead of widening")
+			{
+				REQUIRE(storage.get(2) == &air);
+				REQUIRE(storage.get(3) == &glass);
+				REQUIRE(storage.getPalette().size() == 2);
+				REQUIRE(storage.getBitsPerBlock() == 1);
+			}
+		}
+		WHEN("The storage is filled")
+		{
+			storage.set(100, &stone);
+			storage.fill(&dirt);
+			THEN("It goes back to a single value")
+			{
+				REQUIRE(storage.isSingleValue());
+				REQUIRE(storage.get(100) == &dirt);
+				REQUIRE(storage.getPalette().size() == 1);
+			}
+		}
+	}
+}
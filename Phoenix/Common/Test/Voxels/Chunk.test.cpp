@@ -0,0 +1,162 @@
+#include <catch2/catch.hpp>
+
+#include "TestBlocks.hpp"
+
+#include <Common/Voxels/Chunk.hpp>
+
+#include <chrono>
+
+using namespace phx;
+using namespace phx::voxels;
+using phx::voxels::test::addTestBlock;
+
+namespace
+{
+	// stone with some ore, a few layers of dirt, grass and then air.
+	void fillTerrain(Chunk& chunk, BlockReferrer& referrer)
+	{
+		BlockType* stone = referrer.getByID("core.stone");
+		BlockType* dirt  = referrer.getByID("core.dirt");
+		BlockType* grass = referrer.getByID("core.grass");
+		BlockType* ore   = referrer.getByID("core.ore");
+
+		for (std::size_t z = 0; z < 16; ++z)
+		{
+			for (std::size_t x = 0; x < 16; ++x)
+			{
+				const std::size_t height = 7 + (x * 7 + z * 3) % 3;
+				for (std::size_t y = 0; y <= height; ++y)
+				{
+					BlockType* block = stone;
+					if (y == height)
+						block = grass;
+					else if (y + 3 >= height)
+						block = dirt;
+					else if ((x * 31 + y * 17 + z * 13) % 23 == 0)
+						block = ore;
+
+					chunk.getBlocks().set(Chunk::getVectorIndex(x, y, z),
+					                      block);
+				}
+			}
+		}
+	}
+} // namespace
+
+TEST_CASE("Validate Chunk Serialization")
+{
+	BlockReferrer referrer;
+	addTestBlock(referrer, "core.air");
+	addTestBlock(referrer, "core.stone");
+	addTestBlock(referrer, "core.dirt");
+	addTestBlock(referrer, "core.grass");
+	addTestBlock(referrer, "core.ore");
+
+	GIVEN("A chunk of terrain")
+	{
+		Chunk chunk({16, -32, 48}, &referrer);
+		chunk.getBlocks().fill(referrer.getByID("core.air"));
+		fillTerrain(chunk, referrer);
+
+		Serializer ser;
+		ser << chunk;
+
+		Chunk loaded({0, 0, 0}, &referrer);
+		ser >> loaded;
+
+		THEN("It is read back exactly")
+		{
+			REQUIRE(loaded.getChunkPos() == chunk.getChunkPos());
+			for (int i = 0; i < Chunk::CHUNK_MAX_BLOCKS; ++i)
+			{
+				REQUIRE(loaded.getBlocks().get(i) == chunk.getBlocks().get(i));
+			}
+			REQUIRE(ser.empty());
+			REQUIRE_FALSE(ser.failed());
+		}
+	}
+
+	GIVEN("A chunk that was cut short")
+	{
+		Chunk chunk({16, -32, 48}, &referrer);
+		chunk.getBlocks().fill(referrer.getByID("core.air"));
+		fillTerrain(chunk, referrer);
+
+		Serializer ser;
+		ser << chunk;
+
+		data::Data data = ser.getBuffer();
+		data.resize(data.size() / 2);
+		ser.setBuffer(std::move(data));
+
+		Chunk loaded({0, 0, 0}, &referrer);
+		ser >> loaded;
+
+		THEN("The serializer reports it as damaged")
+		{
+			REQUIRE(ser.failed());
+		}
+	}
+
+	GIVEN("A chunk in the old string format")
+	{
+		// one grass block followed by 4095 repeats of stone.
+		Serializer ser;
+		ser << 0.f << 16.f << 0.f;
+		ser << std::string("core.grass") << ';';
+		ser << std::string("core.stone") << '*'
+		    << std::size_t {Chunk::CHUNK_MAX_BLOCKS - 2};
+
+		Chunk loaded({0, 0, 0}, &referrer);
+		ser >> loaded;
+
+		THEN("It can still be read")
+		{
+			REQUIRE(loaded.getChunkPos() == math::vec3 {0, 16, 0});
+			REQUIRE(loaded.getBlockAt(std::size_t {0}).type ==
+			        referrer.getByID("core.grass"));
+			REQUIRE(loaded.getBlockAt(Chunk::CHUNK_MAX_BLOCKS - 1).type ==
+			        referrer.getByID("core.stone"));
+			REQUIRE_FALSE(ser.failed());
+		}
+	}
+}
+
+// Reports the encoded size and decode time of a typical terrain chunk. Hidden
+// by default, run with: PhoenixCommon_test "[benchmark]"
+TEST_CASE("Benchmark Chunk Encoding", "[.][benchmark]")
+{
+	using Clock = std::chrono::steady_clock;
+
+	BlockReferrer referrer;
+	addTestBlock(referrer, "core.air");
+	addTestBlock(referrer, "core.stone");
+	addTestBlock(referrer, "core.dirt");
+	addTestBlock(referrer, "core.grass");
+	addTestBlock(referrer, "core.ore");
+
+	Chunk chunk({0, 0, 0}, &referrer);
+	chunk.getBlocks().fill(referrer.getByID("core.air"));
+	fillTerrain(chunk, referrer);
+
+	Serializer writer;
+	writer << chunk;
+	const data::Data data = writer.getBuffer();
+
+	constexpr int iterations = 1000;
+
+	const auto start = Clock::now();
+	for (int i = 0; i < iterations; ++i)
+	{
+		Chunk      loaded({0, 0, 0}, &referrer);
+		Serializer ser;
+		ser.setView(data.data(), data.size());
+		ser >> loaded;
+	}
+	const std::chrono::duration<float, std::nano> time = Clock::now() - start;
+
+	WARN("Terrain chunk is " << data.size() << " bytes, decoded in "
+	                         << time.count() / iterations << "ns.");
+
+	REQUIRE(!data.empty());
+}
@@ -0,0 +1,254 @@
+#include <catch2/catch.hpp>
+
+#include <Common/Voxels/ChunkViewTracker.hpp>
+
+#include <chrono>
+#include <cstdlib>
+#include <random>
+
+using namespace phx;
+using namespace phx::voxels;
+
+namespace
+{
+	int distanceSquared(const math::vec3i& a, const math::vec3i& b)
+	{
+		const int x = a.x - b.x;
+		const int y = a.y - b.y;
+		const int z = a.z - b.z;
+		return x * x + y * y + z * z;
+	}
+
+	bool isNearestFirst(const std::vector<math::vec3i>& indices,
+	                    const math::vec3i&              centre)
+	{
+		for (std::size_t i = 1; i < indices.size(); ++i)
+		{
+			if (distanceSquared(indices[i - 1], centre) >
+			    distanceSquared(indices[i], centre))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	int chebyshev(const math::vec3i& a, const math::vec3i& b)
+	{
+		return std::max({std::abs(a.x - b.x), std::abs(a.y - b.y),
+		                 std::abs(a.z - b.z)});
+	}
+
+	const auto loadAll = [](const math::vec3i&) { return true; };
+} // namespace
+
+TEST_CASE("Validate Chunk View Tracking")
+{
+	ChunkViewTracker tracker(3, 4);
+
+	GIVEN("A tracker placed for the first time")
+	{
+		REQUIRE(tracker.move({0, 0, 0}));
+
+		THEN("Every chunk in view is wanted, nearest first")
+		{
+			REQUIRE(tracker.getWanted().size() == 7 * 7 * 7);
+			REQUIRE(tracker.getWanted().front() == math::vec3i {0, 0, 0});
+			REQUIRE(isNearestFirst(tracker.getWanted(), {0, 0, 0}));
+		}
+
+		WHEN("Only some chunks can be loaded")
+		{
+			const std::size_t loaded = tracker.load(
+			    [](const math::vec3i& index) { return index.y >= 0; });
+
+			THEN("The rest are still wanted, in the same order")
+			{
+				REQUIRE(loaded == 7 * 7 * 4);
+				REQUIRE(tracker.getWanted().size() == 7 * 7 * 3);
+				REQUIRE(tracker.getWanted().front() ==
+				        math::vec3i {0, -1, 0});
+				REQUIRE(isNearestFirst(tracker.getWanted(), {0, 0, 0}));
+			}
+		}
+
+		WHEN("Everything is loaded and the viewer moves over a chunk")
+		{
+			tracker.load(loadAll);
+			REQUIRE_FALSE(tracker.move({0, 0, 0}));
+			REQUIRE(tracker.move({1, 0, 0}));
+
+			THEN("Only the new face of the view is wanted")
+			{
+				REQUIRE(tracker.getWanted().size() == 7 * 7);
+				for (const math::vec3i& index : tracker.getWanted())
+				{
+					REQUIRE(index.x == 4);
+				}
+			}
+
+			THEN("Nothing is unloaded while it's within the hysteresis")
+			{
+				REQUIRE(tracker.takeUnloaded().empty());
+				REQUIRE(tracker.isInRange({-3, 0, 0}));
+			}
+		}
+
+		WHEN("Everything is loaded and the viewer moves over two chunks")
+		{
+			tracker.load(loadAll);
+			tracker.move({2, 0, 0});
+
+			THEN("The far face is unloaded, nearest first")
+			{
+				const std::vector<math::vec3i> unloaded =
+				    tracker.takeUnloaded();
+				REQUIRE(unloaded.size() == 7 * 7);
+				REQUIRE(isNearestFirst(unloaded, {2, 0, 0}));
+				for (const math::vec3i& index : unloaded)
+				{
+					REQUIRE(index.x == -3);
+					REQUIRE_FALSE(tracker.isLoaded(index));
+				}
+
+				REQUIRE(tracker.takeUnloaded().empty());
+			}
+
+			THEN("Coming back doesn't want chunks that were kept")
+			{
+				tracker.load(loadAll);
+				tracker.move({0, 0, 0});
+				REQUIRE(tracker.getWanted().size() == 7 * 7);
+				for (const math::vec3i& index : tracker.getWanted())
+				{
+					REQUIRE(index.x == -3);
+				}
+			}
+		}
+
+		WHEN("The viewer moves before the chunks are loaded")
+		{
+			tracker.move({10, 0, 0});
+
+			THEN("Chunks that are out of view aren't wanted anymore")
+			{
+				REQUIRE(tracker.getWanted().size() == 7 * 7 * 7);
+				for (const math::vec3i& index : tracker.getWanted())
+				{
+					REQUIRE(chebyshev(index, {10, 0, 0}) <= 3);
+				}
+				REQUIRE(tracker.takeUnloaded().empty());
+			}
+		}
+	}
+
+	GIVEN("A viewer wandering around randomly")
+	{
+		std::mt19937                       random(1234);
+		std::uniform_int_distribution<int> step(-1, 1);
+		std::uniform_int_distribution<int> jump(-20, 20);
+
+		math::vec3i centre = {0, 0, 0};
+		bool        valid  = true;
+		for (int i = 0; i < 200 && valid; ++i)
+		{
+			// every so often, teleport.
+			if (i % 50 == 49)
+			{
+				centre = {jump(random), jump(random), jump(random)};
+			}
+			else
+			{
+				centre = {centre.x + step(random), centre.y + step(random),
+				          centre.z + step(random)};
+			}
+
+			tracker.move(centre);
+			for (const math::vec3i& index : tracker.takeUnloaded())
+			{
+				valid &= chebyshev(index, centre) > 4;
+			}
+			tracker.load(loadAll);
+
+			valid &= tracker.getLoaded().size() >= 7 * 7 * 7;
+			for (const math::vec3i& index : tracker.getLoaded())
+			{
+				valid &= chebyshev(index, centre) <= 4;
+			}
+		}
+
+		THEN("Everything in view is loaded and nothing out of range is")
+		{
+			REQUIRE(valid);
+		}
+	}
+}
+
+// Compares moving the view one chunk at a time against scanning the whole
+// view every time, at a view distance of 16. Hidden by default, run with:
+// PhoenixCommon_test "[benchmark]"
+TEST_CASE("Benchmark Chunk View Tracking", "[.][benchmark]")
+{
+	using Clock = std::chrono::steady_clock;
+
+	constexpr int viewDistance = 16;
+	constexpr int steps        = 64;
+
+	ChunkViewTracker tracker(viewDistance, viewDistance + 1);
+
+	const auto firstStart = Clock::now();
+	tracker.move({0, 0, 0});
+	tracker.load(loadAll);
+	const std::chrono::duration<float, std::micro> firstTime =
+	    Clock::now() - firstStart;
+
+	std::size_t tracked    = 0;
+	const auto  trackStart = Clock::now();
+	for (int i = 1; i <= steps; ++i)
+	{
+		tracker.move({i, 0, 0});
+		tracked += tracker.load(loadAll);
+		tracked += tracker.takeUnloaded().size();
+	}
+	const std::chrono::duration<float, std::micro> trackTime =
+	    Clock::now() - trackStart;
+
+	// every chunk in view is looked up, and every loaded chunk checked.
+	ChunkViewTracker::IndexSet loaded;
+	std::size_t                scanned   = 0;
+	const auto                 scanStart = Clock::now();
+	for (int i = 0; i <= steps; ++i)
+	{
+		for (auto it = loaded.begin(); it != loaded.end();)
+		{
+			if (chebyshev(*it, {i, 0, 0}) > viewDistance + 1)
+			{
+				it = loaded.erase(it);
+				++scanned;
+				continue;
+			}
+			++it;
+		}
+
+		for (int x = i - viewDistance; x <= i + viewDistance; ++x)
+		{
+			for (int y = -viewDistance; y <= viewDistance; ++y)
+			{
+				for (int z = -viewDistance; z <= viewDistance; ++z)
+				{
+					scanned += loaded.insert({x, y, z}).second ? 1 : 0;
+				}
+			}
+		}
+	}
+	const std::chrono::duration<float, std::micro> scanTime =
+	    Clock::now() - scanStart;
+
+	WARN(tracker.getLoaded().size()
+	     << " chunks in view. First placement: " << firstTime.count()
+	     << "us, then per step: " << trackTime.count() / steps
+	     << "us tracked, " << scanTime.count() / (steps + 1)
+	     << "us scanning the whole view.");
+
+	REQUIRE(tracker.getLoaded().size() == loaded.size());
+}
@@ -0,0 +1,231 @@
+#include <catch2/catch.hpp>
+
+#include <Common/Voxels/Chunk.hpp>
+#include <Common/Voxels/ChunkVisibility.hpp>
+
+#include <algorithm>
+#include <unordered_map>
+
+using namespace phx;
+using namespace phx::voxels;
+
+namespace
+{
+	// the faces in the order ChunkVisibility uses.
+	enum Face : std::size_t
+	{
+		NEG_Z,
+		NEG_X,
+		POS_Z,
+		POS_X,
+		POS_Y,
+		NEG_Y
+	};
+
+	std::vector<bool> resolve(const BlockStorage& blocks, BlockType* stone)
+	{
+		std::vector<bool> opaque;
+		for (BlockType* block : blocks.getPalette())
+		{
+			opaque.push_back(block == stone);
+		}
+		return opaque;
+	}
+
+	// a chunk with a wall of stone across it at x = 8.
+	void buildWall(BlockStorage& blocks, BlockType* stone)
+	{
+		for (std::size_t z = 0; z < 16; ++z)
+		{
+			for (std::size_t y = 0; y < 16; ++y)
+			{
+				blocks.set(Chunk::getVectorIndex(8, y, z), stone);
+			}
+		}
+	}
+
+	// the chunk positions are in blocks, so neighbours are 16 apart.
+	math::vec3 chunkAt(int x, int y, int z)
+	{
+		return {x * 16.f, y * 16.f, z * 16.f};
+	}
+
+	using World = std::unordered_map<math::vec3, ChunkVisibility,
+	                                 math::Vector3Hasher,
+	                                 math::Vector3KeyComparator>;
+
+	ChunkVisibility::Lookup makeLookup(const World& world)
+	{
+		return [&world](const math::vec3& pos) -> const ChunkVisibility* {
+			const auto it = world.find(pos);
+			return it == world.end() ? nullptr : &it->second;
+		};
+	}
+
+	bool contains(const std::vector<math::vec3>& chunks,
+	              const math::vec3&              pos)
+	{
+		return std::find(chunks.begin(), chunks.end(), pos) != chunks.end();
+	}
+} // namespace
+
+TEST_CASE("Chunk visibility connects faces through air", "[ChunkVisibility]")
+{
+	BlockType air;
+	BlockType stone;
+
+	BlockStorage blocks(Chunk::CHUNK_MAX_BLOCKS, &air);
+
+	SECTION("An empty chunk connects every face")
+	{
+		const ChunkVisibility visibility =
+		    ChunkVisibility::compute(blocks, resolve(blocks, &stone));
+
+		for (std::size_t from = 0; from < ChunkVisibility::FACE_COUNT; ++from)
+		{
+			for (std::size_t to = 0; to < ChunkVisibility::FACE_COUNT; ++to)
+			{
+				REQUIRE(visibility.connects(from, to));
+			}
+		}
+	}
+
+	SECTION("A solid chunk connects nothing")
+	{
+		blocks.fill(&stone);
+		const ChunkVisibility visibility =
+		    ChunkVisibility::compute(blocks, resolve(blocks, &stone));
+
+		for (std::size_t from = 0; from < ChunkVisibility::FACE_COUNT; ++from)
+		{
+			for (std::size_t to = 0; to < ChunkVisibility::FACE_COUNT; ++to)
+			{
+				REQUIRE_FALSE(visibility.connects(from, to));
+			}
+		}
+	}
+
+	SECTION("A wall splits the chunk in two")
+	{
+		buildWall(blocks, &stone);
+		const ChunkVisibility visibility =
+		    ChunkVisibility::compute(blocks, resolve(blocks, &stone));
+
+		REQUIRE_FALSE(visibility.connects(NEG_X, POS_X));
+		REQUIRE_FALSE(visibility.connects(POS_X, NEG_X));
+
+		// both halves still reach the faces along the wall.
+		REQUIRE(visibility.connects(NEG_X, POS_Y));
+		REQUIRE(visibility.connects(POS_X, POS_Y));
+		REQUIRE(visibility.connects(NEG_Z, POS_Z));
+		REQUIRE(visibility.connects(POS_Y, NEG_Y));
+
+		WHEN("A hole is made in the wall")
+		{
+			blocks.set(Chunk::getVectorIndex(8, 3, 12), &air);
+			const ChunkVisibility holed =
+			    ChunkVisibility::compute(blocks, resolve(blocks, &stone));
+
+			REQUIRE(holed.connects(NEG_X, POS_X));
+		}
+	}
+
+	SECTION("Opposite faces")
+	{
+		REQUIRE(ChunkVisibility::opposite(NEG_Z) == POS_Z);
+		REQUIRE(ChunkVisibility::opposite(NEG_X) == POS_X);
+		REQUIRE(ChunkVisibility::opposite(POS_Z) == NEG_Z);
+		REQUIRE(ChunkVisibility::opposite(POS_X) == NEG_X);
+		REQUIRE(ChunkVisibility::opposite(POS_Y) == NEG_Y);
+		REQUIRE(ChunkVisibility::opposite(NEG_Y) == POS_Y);
+	}
+}
+
+TEST_CASE("Finding visible chunks", "[ChunkVisibility]")
+{
+	World world;
+	for (int x = -4; x <= 4; ++x)
+	{
+		for (int y = -1; y <= 1; ++y)
+		{
+			for (int z = -1; z <= 1; ++z)
+			{
+				world[chunkAt(x, y, z)] = ChunkVisibility::all();
+			}
+		}
+	}
+
+	std::vector<math::vec3> visible;
+
+	SECTION("Open chunks are all visible")
+	{
+		REQUIRE(ChunkVisibility::findVisible(chunkAt(0, 0, 0),
+		                                     makeLookup(world), {}, visible));
+		REQUIRE(visible.size() == world.size());
+		REQUIRE(visible.front() == chunkAt(0, 0, 0));
+	}
+
+	SECTION("Chunks behind a solid wall of chunks are hidden")
+	{
+		for (int y = -1; y <= 1; ++y)
+		{
+			for (int z = -1; z <= 1; ++z)
+			{
+				world[chunkAt(2, y, z)] = ChunkVisibility();
+			}
+		}
+
+		REQUIRE(ChunkVisibility::findVisible(chunkAt(0, 0, 0),
+		                                     makeLookup(world), {}, visible));
+
+		// the wall itself is drawn, what is behind it isn't.
+		REQUIRE(contains(visible, chunkAt(2, 0, 0)));
+		REQUIRE_FALSE(contains(visible, chunkAt(3, 0, 0)));
+		REQUIRE_FALSE(contains(visible, chunkAt(4, 1, -1)));
+		REQUIRE(contains(visible, chunkAt(-4, 0, 0)));
+	}
+
+	SECTION("Chunks are only seen through connected faces")
+	{
+		// a chunk that can only be seen through from -x to +y.
+		ChunkVisibility bend;
+		bend.connect(NEG_X, POS_Y);
+		world[chunkAt(1, 0, 0)] = bend;
+
+		for (int y = -1; y <= 1; ++y)
+		{
+			for (int z = -1; z <= 1; ++z)
+			{
+				if (y != 0 || z != 0)
+				{
+					world[chunkAt(1, y, z)] = ChunkVisibility();
+				}
+			}
+		}
+
+		REQUIRE(ChunkVisibility::findVisible(chunkAt(0, 0, 0),
+		                                     makeLookup(world), {}, visible));
+
+		REQUIRE(contains(visible, chunkAt(1, 0, 0)));
+		REQUIRE(contains(visible, chunkAt(1, 1, 0)));
+		REQUIRE_FALSE(contains(visible, chunkAt(2, 0, 0)));
+	}
+
+	SECTION("Chunks out of view are skipped")
+	{
+		const auto inFront = [](const math::vec3& pos) { return pos.x >= 0; };
+
+		REQUIRE(ChunkVisibility::findVisible(
+		    chunkAt(0, 0, 0), makeLookup(world), inFront, visible));
+
+		REQUIRE(contains(visible, chunkAt(4, 0, 0)));
+		REQUIRE_FALSE(contains(visible, chunkAt(-1, 0, 0)));
+	}
+
+	SECTION("Nothing is found from an unknown chunk")
+	{
+		REQUIRE_FALSE(ChunkVisibility::findVisible(
+		    chunkAt(10, 0, 0), makeLookup(world), {}, visible));
+		REQUIRE(visible.empty());
+	}
+}
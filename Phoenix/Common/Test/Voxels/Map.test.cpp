@@ -0,0 +1,426 @@
+#include <catch2/catch.hpp>
+
+#include "TestBlocks.hpp"
+
+#include <Common/Save.hpp>
+#include <Common/Voxels/Map.hpp>
+
+#include <chrono>
+#include <filesystem>
+#include <random>
+#include <thread>
+#include <unordered_map>
+
+using namespace phx;
+using namespace phx::voxels;
+using phx::voxels::test::addTestBlock;
+
+TEST_CASE("Validate Map Write Back")
+{
+	const std::string saveName = "phx_test_map";
+	std::filesystem::remove_all(phx::saveDir + saveName);
+
+	BlockReferrer referrer;
+	addTestBlock(referrer, "core.grass");
+	addTestBlock(referrer, "core.stone");
+	BlockType* stone = referrer.getByID("core.stone");
+
+	Save save(saveName);
+
+	GIVEN("A map that writes edits back after a while")
+	{
+		{
+			Map map(&save, "map1", &referrer);
+			map.setWriteBack(std::chrono::hours(1), 64);
+
+			// make sure the generated chunks are on disk before editing.
+			map.getBlockAt({1, 1, 1});
+			map.getBlockAt({17, 1, 1});
+			map.flush();
+
+			map.setBlockAt({1, 1, 1}, {stone, nullptr});
+			map.setBlockAt({2, 1, 1}, {stone, nullptr});
+
+			WHEN("The map is read again before it is flushed")
+			{
+				Map other(&save, "map1", &referrer);
+				THEN("The edits have not been saved yet")
+				{
+					REQUIRE(other.getBlockAt({1, 1, 1}).type != stone);
+				}
+			}
+
+			WHEN("The map is flushed")
+			{
+				map.flush();
+				Map other(&save, "map1", &referrer);
+				THEN("Both edits were saved")
+				{
+					REQUIRE(other.getBlockAt({1, 1, 1}).type == stone);
+					REQUIRE(other.getBlockAt({2, 1, 1}).type == stone);
+				}
+			}
+
+			WHEN("The edited chunk is unloaded")
+			{
+				map.unloadChunk({0, 0, 0});
+				THEN("It is saved and loaded back with the edits")
+				{
+					REQUIRE(map.getChunkState({0, 0, 0}) ==
+					        ChunkState::UNLOADED);
+					REQUIRE(map.getBlockAt({1, 1, 1}).type == stone);
+				}
+			}
+
+			WHEN("Only the chunk next to the edited one is needed")
+			{
+				const std::size_t usage = map.getMemoryUsage();
+				const std::size_t unloaded =
+				    map.unloadChunks([](const math::vec3& pos) {
+					    return pos == math::vec3 {16, 0, 0};
+				    });
+				THEN("The edited chunk is saved and unloaded")
+				{
+					REQUIRE(unloaded == 1);
+					REQUIRE(map.getLoadedChunkCount() == 1);
+					REQUIRE(map.getMemoryUsage() < usage);
+					REQUIRE(map.getChunkState({0, 0, 0}) ==
+					        ChunkState::UNLOADED);
+					REQUIRE(map.getChunkState({16, 0, 0}) ==
+					        ChunkState::LOADED);
+					REQUIRE(map.getBlockAt({1, 1, 1}).type == stone);
+				}
+			}
+		}
+
+		WHEN("The map is destroyed")
+		{
+			Map other(&save, "map1", &referrer);
+			THEN("The edits were saved on the way out")
+			{
+				REQUIRE(other.getBlockAt({1, 1, 1}).type == stone);
+				REQUIRE(other.getBlockAt({2, 1, 1}).type == stone);
+			}
+		}
+	}
+
+	GIVEN("A chunk whose region file can't be opened")
+	{
+		// a directory where the region file should be.
+		const std::string region =
+		    phx::saveDir + saveName + "/map2.0_0_0.region";
+		std::filesystem::create_directory(region);
+
+		Map map(&save, "map2", &referrer);
+		map.setWriteBack(std::chrono::hours(1), 64);
+		map.setBlockAt({1, 1, 1}, {stone, nullptr});
+
+		WHEN("The edited chunk is unloaded")
+		{
+			THEN("It is kept in memory with its edits")
+			{
+				REQUIRE_FALSE(map.unloadChunk({0, 0, 0}));
+				REQUIRE_FALSE(map.flush());
+				REQUIRE(map.getChunkState({0, 0, 0}) == ChunkState::LOADED);
+				REQUIRE(map.getBlockAt({1, 1, 1}).type == stone);
+			}
+		}
+
+		WHEN("The region file can be opened again")
+		{
+			REQUIRE_FALSE(map.flush());
+			std::filesystem::remove(region);
+
+			THEN("The edits are saved on the next try")
+			{
+				REQUIRE(map.unloadChunk({0, 0, 0}));
+				REQUIRE(map.flush());
+
+				Map other(&save, "map2", &referrer);
+				REQUIRE(other.getBlockAt({1, 1, 1}).type == stone);
+			}
+		}
+	}
+
+	GIVEN("A chunk saved with a codec this build doesn't know")
+	{
+		const std::string path =
+		    phx::saveDir + saveName + "/map3.0_0_0.region";
+		const std::size_t index = RegionFile::toLocalIndex({0, 0, 0});
+
+		data::Data frame = data::Compression::compress(
+		    data::Data(64, std::byte {1}), data::Codec::NONE);
+		frame[0] = std::byte {0x7f};
+		{
+			RegionFile region(path);
+			REQUIRE(region.write(index, frame));
+		}
+
+		WHEN("The map tries to load and edit it")
+		{
+			{
+				Map map(&save, "map3", &referrer);
+				map.getBlockAt({1, 1, 1});
+				map.setBlockAt({1, 1, 1}, {stone, nullptr});
+
+				REQUIRE(map.getChunkState({0, 0, 0}) == ChunkState::UNLOADED);
+				REQUIRE(map.flush());
+			}
+
+			THEN("The saved chunk is left exactly as it was")
+			{
+				RegionFile region(path);
+				data::Data saved;
+				REQUIRE(region.read(index, saved));
+				REQUIRE(saved == frame);
+			}
+		}
+
+		WHEN("A worker thread tries to load it")
+		{
+			Map map(&save, "map3", &referrer, 1);
+			REQUIRE(map.getChunk({0, 0, 0}) == nullptr);
+
+			while (map.getIOStats().queued > 0 ||
+			       map.getIOStats().completed == 0)
+			{
+				std::this_thread::yield();
+			}
+
+			THEN("It is never published or asked for again")
+			{
+				REQUIRE(map.tick(std::chrono::hours(1)) == 0);
+				REQUIRE(map.getChunk({0, 0, 0}) == nullptr);
+				REQUIRE(map.getIOStats().pending == 0);
+				REQUIRE(map.getChunkState({0, 0, 0}) == ChunkState::UNLOADED);
+			}
+		}
+	}
+
+	std::filesystem::remove_all(phx::saveDir + saveName);
+}
+
+TEST_CASE("Validate Map Background Loading")
+{
+	const std::string saveName = "phx_test_map_async";
+	std::filesystem::remove_all(phx::saveDir + saveName);
+
+	BlockReferrer referrer;
+	addTestBlock(referrer, "core.grass");
+	addTestBlock(referrer, "core.stone");
+	BlockType* stone = referrer.getByID("core.stone");
+
+	Save save(saveName);
+
+	GIVEN("A chunk that is edited and unloaded while a worker loads it")
+	{
+		Map map(&save, "map1", &referrer, 1);
+		map.setWriteBack(std::chrono::hours(1), 64);
+
+		REQUIRE(map.getChunk({0, 0, 0}) == nullptr);
+		map.setBlockAt({1, 1, 1}, {stone, nullptr});
+		map.unloadChunk({0, 0, 0});
+
+		while (map.getIOStats().queued > 0 || map.getIOStats().completed == 0)
+		{
+			std::this_thread::yield();
+		}
+
+		WHEN("The map is ticked")
+		{
+			const std::size_t published = map.tick(std::chrono::hours(1));
+			THEN("The worker's copy is thrown away")
+			{
+				REQUIRE(published == 0);
+				REQUIRE(map.getChunkState({0, 0, 0}) == ChunkState::UNLOADED);
+
+				Map other(&save, "map1", &referrer);
+				REQUIRE(other.getBlockAt({1, 1, 1}).type == stone);
+			}
+		}
+	}
+
+	std::filesystem::remove_all(phx::saveDir + saveName);
+}
+
+TEST_CASE("Validate Block Positions")
+{
+	GIVEN("Positions on either side of the origin")
+	{
+		THEN("They are split into the chunk and the block inside of it")
+		{
+			using Split = std::pair<math::vec3, math::vec3>;
+			REQUIRE(Map::getBlockPos({17.5f, 3.f, 0.f}) ==
+			        Split {{16, 0, 0}, {1, 3, 0}});
+			REQUIRE(Map::getBlockPos({-1.f, -16.f, -17.f}) ==
+			        Split {{-16, -16, -32}, {15, 0, 15}});
+
+			// positions are rounded towards zero before being split.
+			REQUIRE(Map::getBlockPos({-0.5f, -15.5f, 0.f}) ==
+			        Split {{0, -16, 0}, {0, 1, 0}});
+		}
+
+		THEN("Chunk positions round trip through ChunkPos")
+		{
+			REQUIRE(toChunkPos({-32, 16, 0}) == ChunkPos {-2, 1, 0});
+			REQUIRE(toPosition({-2, 1, 0}) == math::vec3 {-32, 16, 0});
+			REQUIRE(getChunkPos({-1, 15, 16}) == ChunkPos {-1, 0, 1});
+		}
+	}
+}
+
+// Compares editing throughput when saving on every edit (how the map used
+// to behave) against writing edits back later. Hidden by default, run with:
+// PhoenixCommon_test "[benchmark]"
+TEST_CASE("Benchmark Map Edit Throughput", "[.][benchmark]")
+{
+	using Clock = std::chrono::steady_clock;
+
+	const std::string saveName = "phx_bench_map";
+	std::filesystem::remove_all(phx::saveDir + saveName);
+
+	BlockReferrer referrer;
+	addTestBlock(referrer, "core.grass");
+	addTestBlock(referrer, "core.stone");
+	BlockType* stone = referrer.getByID("core.stone");
+	BlockType* air   = referrer.getByID("core.air");
+
+	Save save(saveName);
+
+	constexpr int edits = 20000;
+
+	const auto measure = [&](std::chrono::milliseconds interval,
+	                         std::size_t               maxDirty) {
+		Map map(&save, "map1", &referrer);
+		map.setWriteBack(interval, maxDirty);
+
+		const auto start = Clock::now();
+		for (int i = 0; i < edits; ++i)
+		{
+			// a bridge being built, 64 blocks long, over and over.
+			map.setBlockAt({static_cast<float>(i % 64), 4.f, 4.f},
+			               {(i / 64) % 2 == 0 ? stone : air, nullptr});
+		}
+		map.flush();
+
+		const std::chrono::duration<float> time = Clock::now() - start;
+		return edits / time.count();
+	};
+
+	const float writeThrough = measure(std::chrono::milliseconds(0), 0);
+	const float writeBack    = measure(std::chrono::milliseconds(5000), 64);
+
+	WARN("Edited " << edits << " blocks: " << writeThrough
+	               << " blocks/sec saving every edit, " << writeBack
+	               << " blocks/sec writing back.");
+
+	REQUIRE(writeBack > 0.f);
+
+	std::filesystem::remove_all(phx::saveDir + saveName);
+}
+
+// Compares looking blocks up through the map against how the map used to do
+// it, with float positions in a std::unordered_map hashed by xor. Hidden by
+// default, run with: PhoenixCommon_test "[benchmark]"
+TEST_CASE("Benchmark Map Block Lookups", "[.][benchmark]")
+{
+	using Clock = std::chrono::steady_clock;
+
+	const std::string saveName = "phx_bench_lookups";
+	std::filesystem::remove_all(phx::saveDir + saveName);
+
+	BlockReferrer referrer;
+	addTestBlock(referrer, "core.grass");
+	BlockType* grassType = referrer.getByID("core.grass");
+
+	Save save(saveName);
+	Map  map(&save, "map1", &referrer);
+
+	struct XorHasher
+	{
+		std::size_t operator()(const math::vec3& k) const
+		{
+			return std::hash<float>()(k.x) ^ std::hash<float>()(k.y) ^
+			       std::hash<float>()(k.z);
+		}
+	};
+	std::unordered_map<math::vec3, Chunk*, XorHasher,
+	                   math::Vector3KeyComparator>
+	    chunks;
+
+	// a 16 chunk radius around the origin, two chunks deep.
+	constexpr int radius = 16;
+	for (int x = -radius; x <= radius; ++x)
+	{
+		for (int y = -1; y <= 0; ++y)
+		{
+			for (int z = -radius; z <= radius; ++z)
+			{
+				const math::vec3 pos = {x * 16.f, y * 16.f, z * 16.f};
+				chunks.emplace(pos, map.getChunk(pos));
+			}
+		}
+	}
+
+	std::mt19937                          random(7);
+	std::uniform_real_distribution<float> horizontal(-radius * 16.f,
+	                                                 radius * 16.f + 15.f);
+	std::uniform_real_distribution<float> vertical(-16.f, 15.f);
+
+	std::vector<math::vec3> positions(1 << 20);
+	for (math::vec3& position : positions)
+	{
+		position = {horizontal(random), vertical(random), horizontal(random)};
+	}
+
+	std::size_t grass = 0;
+	const auto  start = Clock::now();
+	for (const math::vec3& position : positions)
+	{
+		grass += map.getBlockAt(position).type == grassType ? 1 : 0;
+	}
+	const std::chrono::duration<float> mapTime = Clock::now() - start;
+
+	// the old float arithmetic of getBlockPos, and the old hash map.
+	std::size_t oldGrass = 0;
+	const auto  oldStart = Clock::now();
+	for (math::vec3 position : positions)
+	{
+		int posX = static_cast<int>(position.x / Chunk::CHUNK_WIDTH);
+		int posY = static_cast<int>(position.y / Chunk::CHUNK_HEIGHT);
+		int posZ = static_cast<int>(position.z / Chunk::CHUNK_DEPTH);
+
+		position.x = static_cast<float>(static_cast<int>(position.x) % 16);
+		position.y = static_cast<float>(static_cast<int>(position.y) % 16);
+		position.z = static_cast<float>(static_cast<int>(position.z) % 16);
+		if (position.x < 0)
+		{
+			posX -= 1;
+			position.x += 16;
+		}
+		if (position.y < 0)
+		{
+			posY -= 1;
+			position.y += 16;
+		}
+		if (position.z < 0)
+		{
+			posZ -= 1;
+			position.z += 16;
+		}
+
+		Chunk* chunk = chunks.at({posX * 16.f, posY * 16.f, posZ * 16.f});
+		oldGrass += chunk->getBlockAt(position).type == grassType ? 1 : 0;
+	}
+	const std::chrono::duration<float> oldTime = Clock::now() - oldStart;
+
+	WARN(positions.size() << " lookups in " << chunks.size()
+	                      << " chunks: " << positions.size() / mapTime.count()
+	                      << " blocks/sec now, "
+	                      << positions.size() / oldTime.count()
+	                      << " blocks/sec the old way.");
+
+	REQUIRE(grass == oldGrass);
+
+	std::filesystem::remove_all(phx::saveDir + saveName);
+}
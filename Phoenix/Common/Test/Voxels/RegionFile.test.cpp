@@ -0,0 +1,255 @@
+#include <catch2/catch.hpp>
+
+#include <Common/Utility/Compression.hpp>
+#include <Common/Voxels/RegionFile.hpp>
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+using namespace phx;
+using namespace phx::voxels;
+
+namespace fs = std::filesystem;
+
+data::Data makeTestData(std::size_t size, unsigned char seed)
+{
+	data::Data data(size);
+	for (std::size_t i = 0; i < size; ++i)
+	{
+		data[i] = static_cast<std::byte>(seed + i);
+	}
+	return data;
+}
+
+TEST_CASE("Validate RegionFile Behavior")
+{
+	const fs::path path = fs::temp_directory_path() / "phx_test.region";
+	fs::remove(path);
+
+	GIVEN("A newly created region file")
+	{
+		{
+			RegionFile region(path);
+			REQUIRE(region.isOpen());
+			REQUIRE_FALSE(region.has(0));
+
+			data::Data data;
+			REQUIRE_FALSE(region.read(0, data));
+
+			region.write(0, makeTestData(100, 1));
+			region.write(1, makeTestData(RegionFile::SECTOR_SIZE * 2, 2));
+		}
+
+		REQUIRE(fs::file_size(path) ==
+		        (RegionFile::HEADER_SECTORS + 3) * RegionFile::SECTOR_SIZE);
+
+		WHEN("The region is opened again")
+		{
+			RegionFile region(path);
+			THEN("The saved chunks can be read back")
+			{
+				data::Data data;
+				REQUIRE(region.read(0, data));
+				REQUIRE(data == makeTestData(100, 1));
+				REQUIRE(region.read(1, data));
+				REQUIRE(data == makeTestData(RegionFile::SECTOR_SIZE * 2, 2));
+				REQUIRE_FALSE(region.has(2));
+			}
+		}
+		WHEN("A chunk is rewritten and still fits its sectors")
+		{
+			{
+				RegionFile region(path);
+				region.write(1, makeTestData(RegionFile::SECTOR_SIZE, 3));
+			}
+
+			THEN("It is rewritten in place")
+			{
+				RegionFile region(path);
+				data::Data data;
+				REQUIRE(region.read(1, data));
+				REQUIRE(data == makeTestData(RegionFile::SECTOR_SIZE, 3));
+				REQUIRE(fs::file_size(path) == (RegionFile::HEADER_SECTORS + 3) *
+				                                   RegionFile::SECTOR_SIZE);
+			}
+		}
+		WHEN("A chunk grows past its sectors")
+		{
+			{
+				RegionFile region(path);
+				region.write(0, makeTestData(RegionFile::SECTOR_SIZE + 1, 4));
+			}
+
+			THEN("It is moved without touching its neighbours")
+			{
+				RegionFile region(path);
+				data::Data data;
+				REQUIRE(region.read(0, data));
+				REQUIRE(data == makeTestData(RegionFile::SECTOR_SIZE + 1, 4));
+				REQUIRE(region.read(1, data));
+				REQUIRE(data == makeTestData(RegionFile::SECTOR_SIZE * 2, 2));
+			}
+		}
+	}
+
+	GIVEN("A region file in the version 1 format")
+	{
+		{
+			RegionFile region(path);
+			region.write(0, makeTestData(100, 1));
+		}
+
+		// version 1 only differs in the version, and in the payloads not
+		// being wrapped in frames.
+		{
+			std::fstream file(path, std::fstream::in | std::fstream::out |
+			                            std::fstream::binary);
+			const char version[4] = {0, 0, 0, 1};
+			file.seekp(sizeof(std::uint32_t));
+			file.write(version, sizeof(version));
+		}
+
+		{
+			RegionFile region(path);
+		}
+
+		THEN("The upgraded file replaced it, each payload wrapped once")
+		{
+			REQUIRE_FALSE(fs::exists(path.string() + ".upgrade"));
+
+			RegionFile region(path);
+			data::Data frame;
+			REQUIRE(region.read(0, frame));
+
+			data::Data data;
+			REQUIRE(data::Compression::decompress(frame.data(), frame.size(),
+			                                      data) ==
+			        data::FrameStatus::OK);
+			REQUIRE(data == makeTestData(100, 1));
+		}
+	}
+
+	fs::remove(path);
+}
+
+TEST_CASE("Validate RegionFile Coordinates")
+{
+	REQUIRE(RegionFile::toRegionPos({0, 15, 16}) == math::vec3i {0, 0, 1});
+	REQUIRE(RegionFile::toRegionPos({-1, -16, -17}) ==
+	        math::vec3i {-1, -1, -2});
+
+	REQUIRE(RegionFile::toLocalIndex({0, 0, 0}) == 0);
+	REQUIRE(RegionFile::toLocalIndex({-1, 0, 0}) == 15);
+	REQUIRE(RegionFile::toLocalIndex({1, 1, 1}) ==
+	        1 + RegionFile::REGION_SIZE * (1 + RegionFile::REGION_SIZE));
+}
+
+// Compares reading a 32 chunk radius (one layer thick) of 300 byte payloads
+// from one file per chunk against reading them from region files. This only
+// measures the cost of opening and reading the files: the files were just
+// written so they are in the page cache, the payloads aren't real chunks and
+// nothing is decoded. Hidden by default, run with:
+// PhoenixCommon_test "[benchmark]"
+TEST_CASE("Benchmark RegionFile Reads", "[.][benchmark]")
+{
+	using Clock = std::chrono::steady_clock;
+
+	constexpr int         radius    = 32;
+	constexpr std::size_t chunkSize = 300;
+
+	const fs::path folder = fs::temp_directory_path() / "phx_region_bench";
+	fs::remove_all(folder);
+	fs::create_directories(folder);
+
+	const data::Data data = makeTestData(chunkSize, 5);
+
+	{
+		std::unordered_map<math::vec3i, std::unique_ptr<RegionFile>,
+		                   math::Vector3Hasher, math::Vector3KeyComparator>
+		    regions;
+		for (int x = -radius; x <= radius; ++x)
+		{
+			for (int z = -radius; z <= radius; ++z)
+			{
+				const std::string name =
+				    std::to_string(x) + '_' + std::to_string(z);
+				std::ofstream file(folder / (name + ".save"),
+				                   std::ofstream::binary);
+				file.write(reinterpret_cast<const char*>(data.data()),
+				           data.size());
+
+				const math::vec3i regionPos = RegionFile::toRegionPos({x, 0, z});
+				auto&             region    = regions[regionPos];
+				if (region == nullptr)
+				{
+					region = std::make_unique<RegionFile>(
+					    folder / (std::to_string(regionPos.x) + '_' +
+					              std::to_string(regionPos.z) + ".region"));
+				}
+				region->write(RegionFile::toLocalIndex({x, 0, z}), data);
+			}
+		}
+	}
+
+	std::size_t bytesRead = 0;
+
+	const auto legacyStart = Clock::now();
+	for (int x = -radius; x <= radius; ++x)
+	{
+		for (int z = -radius; z <= radius; ++z)
+		{
+			const std::string name = std::to_string(x) + '_' + std::to_string(z);
+			std::ifstream     file(folder / (name + ".save"),
+			                       std::ifstream::binary);
+
+			file.seekg(0, std::ifstream::end);
+			data::Data chunk(static_cast<std::size_t>(file.tellg()));
+			file.seekg(0, std::ifstream::beg);
+			file.read(reinterpret_cast<char*>(chunk.data()), chunk.size());
+			bytesRead += chunk.size();
+		}
+	}
+	const auto legacyTime = Clock::now() - legacyStart;
+
+	const auto regionStart = Clock::now();
+	{
+		std::unordered_map<math::vec3i, std::unique_ptr<RegionFile>,
+		                   math::Vector3Hasher, math::Vector3KeyComparator>
+		    regions;
+		for (int x = -radius; x <= radius; ++x)
+		{
+			for (int z = -radius; z <= radius; ++z)
+			{
+				const math::vec3i regionPos = RegionFile::toRegionPos({x, 0, z});
+				auto&             region    = regions[regionPos];
+				if (region == nullptr)
+				{
+					region = std::make_unique<RegionFile>(
+					    folder / (std::to_string(regionPos.x) + '_' +
+					              std::to_string(regionPos.z) + ".region"));
+				}
+
+				data::Data chunk;
+				region->read(RegionFile::toLocalIndex({x, 0, z}), chunk);
+				bytesRead += chunk.size();
+			}
+		}
+	}
+	const auto regionTime = Clock::now() - regionStart;
+
+	using std::chrono::microseconds;
+	using std::chrono::duration_cast;
+	WARN("Loaded " << (2 * radius + 1) * (2 * radius + 1) << " chunks: "
+	               << duration_cast<microseconds>(legacyTime).count()
+	               << "us from chunk files, "
+	               << duration_cast<microseconds>(regionTime).count()
+	               << "us from region files.");
+
+	REQUIRE(bytesRead == 2 * (2 * radius + 1) * (2 * radius + 1) * chunkSize);
+
+	fs::remove_all(folder);
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <Common/Voxels/BlockReferrer.hpp>
+
+#include <string>
+
+namespace phx::voxels::test
+{
+	/**
+	 * @brief Registers a solid block, without needing any mods loaded.
+	 *
+	 * @param referrer The referrer to add the block to.
+	 * @param id The ID of the block, also used as its display name.
+	 * @return The block as stored in the referrer.
+	 */
+	inline BlockType* addTestBlock(BlockReferrer&     referrer,
+	                               const std::string& id)
+	{
+		const auto uid = referrer.referrer.size();
+		BlockType  block;
+		block.displayName      = id;
+		block.id               = id;
+		block.category         = BlockCategory::SOLID;
+		block.uniqueIdentifier = uid;
+		referrer.referrer.add(block.id, uid);
+		referrer.blocks.add(uid, block);
+		return referrer.blocks.get(uid);
+	}
+} // namespace phx::voxels::test
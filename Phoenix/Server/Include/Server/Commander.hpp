@@ -38,6 +38,7 @@
 #pragma once
 
 #include <Server/Iris.hpp>
+#include <Server/TickTimer.hpp>
 
 #include <Common/CMS/ModManager.hpp>
 
@@ -73,7 +74,11 @@ namespace phx::server
 	class Commander
 	{
 	public:
-		explicit Commander(net::Iris* iris);
+		/**
+		 * @param iris The networking object to reply through
+		 * @param ticks The timer of the game's ticks, for the stats command
+		 */
+		Commander(net::Iris* iris, const TickTimer* ticks);
 
 		void registerAPI(cms::ModManager* manager);
 
@@ -119,8 +124,16 @@ namespace phx::server
 		 */
 		void list(std::size_t userRef);
 
+		/**
+		 * @brief Outputs statistics on how the server is running.
+		 *
+		 * @param userRef The user who ran the command
+		 */
+		void stats(std::size_t userRef);
+
 	private:
 		net::Iris*                               m_iris;
+		const TickTimer*                         m_ticks;
 		std::unordered_map<std::string, Command> m_commands;
 	};
 } // namespace phx
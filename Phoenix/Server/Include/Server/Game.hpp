@@ -30,12 +30,17 @@
 
 #include <Server/Commander.hpp>
 #include <Server/Iris.hpp>
+#include <Server/TickTimer.hpp>
 #include <Server/Voxels/BlockRegistry.hpp>
 
+#include <Common/Position.hpp>
 #include <Common/Voxels/Map.hpp>
 
 #include <entt/entt.hpp>
 
+#include <unordered_map>
+#include <vector>
+
 namespace phx::server
 {
 	class Game
@@ -62,6 +67,12 @@ namespace phx::server
 
 		/**
 		 * @brief Runs the main game loop as long as running is true
+		 *
+		 * The game ticks at the fixed rate set by server:tick_rate (20 per
+		 * second by default), whether or not any inputs have arrived.
+		 * Players are always moved at InputState::RATE, the rate clients
+		 * send inputs at, the tick rate only changes how often everything
+		 * else is done and how soon inputs are picked up.
 		 */
 		void run();
 
@@ -70,11 +81,114 @@ namespace phx::server
 		 */
 		void kill();
 
-		/// @brief Just a temporary static storage for the DT
-		/// @TODO Move this to a config file
-		static constexpr float dt = 1.f / 20.f;
+	private:
+		/// @brief How many ticks the game catches up on after falling
+		/// behind, the rest are skipped.
+		static constexpr std::size_t MAX_CATCH_UP_TICKS = 5;
+		/// @brief How many input bundles can wait before they are applied
+		/// more than one a step.
+		static constexpr std::size_t MAX_QUEUED_BUNDLES = 3;
+		/// @brief How long a step of the players' movement is, one input.
+		static constexpr TickTimer::Duration STEP_LENGTH =
+		    std::chrono::duration_cast<TickTimer::Duration>(
+		        std::chrono::seconds(1)) /
+		    InputState::RATE;
+
+		/// @brief The latest input of a player, repeated while their next
+		/// one hasn't arrived.
+		struct PlayerInput
+		{
+			InputState input;
+			/// @brief The sequence of the latest input.
+			std::size_t sequence = 0;
+			/// @brief How many ticks it has been repeated for since, each
+			/// standing in for the input with the next sequence.
+			std::size_t repeated = 0;
+			/// @brief Where the actor was before the first repeat, so the
+			/// repeats can be replayed once the real inputs turn up.
+			Position rewind;
+		};
+
+		/**
+		 * @brief Moves the game forward a tick.
+		 */
+		void tick();
+
+		/**
+		 * @brief Applies the next bundle of inputs, and the last input of
+		 * every player whose input didn't arrive in time.
+		 *
+		 * An input that arrives after its tick was filled in by repeating
+		 * the last one replaces the repeat rather than being applied on top
+		 * of it, see replaceRepeats().
+		 */
+		void applyInputs();
+
+		/**
+		 * @brief Moves a player's actor by their input.
+		 *
+		 * @param player The player entity.
+		 * @param input The input to apply.
+		 */
+		void applyInput(entt::entity player, const InputState& input);
+
+		/**
+		 * @brief Replays a player's repeated inputs with one that arrived
+		 * late, from where the player was before the first repeat.
+		 *
+		 * @param player The player entity.
+		 * @param input What is known of the player's input.
+		 * @param late The input that arrived after its tick.
+		 */
+		void replaceRepeats(entt::entity player, PlayerInput& input,
+		                    const InputState& late);
+
+		/**
+		 * @brief Forgets the players that have disconnected, letting go of
+		 * the chunks they could see.
+		 *
+		 * @return true if any player was forgotten.
+		 */
+		bool releaseDisconnected();
+
+		/**
+		 * @brief Sends every player the chunks that have come into their view
+		 * since they were last updated.
+		 *
+		 * @return true if any player let go of chunks.
+		 */
+		bool sendNewChunks();
+
+		/**
+		 * @brief Updates which chunks a player can see, sending the new
+		 * ones and letting go of the ones that went out of view.
+		 *
+		 * @param player The player entity.
+		 * @return true if the player let go of any chunks.
+		 */
+		bool updateView(entt::entity player);
+
+		/**
+		 * @brief Lets go of every chunk a player's actor could see.
+		 *
+		 * @param actor The actor of a player that left.
+		 */
+		void releaseView(entt::entity actor);
+
+		/**
+		 * @brief Unloads every chunk that no player can see.
+		 */
+		void unloadUnusedChunks();
 
 	private:
+		/// @brief A connected player and the actor they control, the actor
+		/// outlives the player when they disconnect.
+		struct ConnectedPlayer
+		{
+			entt::entity player;
+			entt::entity actor;
+		};
+
 		/// @brief The main loop runs while this is true
 		bool m_running = false;
 		/// @brief The block registry to use.
@@ -83,9 +197,25 @@ namespace phx::server
 		entt::registry* m_registry;
 		/// @brief The networking object to get data from
 		net::Iris* m_iris;
+		/// @brief How long each tick takes
+		TickTimer m_ticks;
+		/// @brief Time the players' movement is behind the ticks, paid off
+		/// a step at a time.
+		TickTimer::Duration m_stepLag {0};
 		/// @brief A commander object to process commands
 		Commander* m_commander;
 		/// @brief The map the players exist on
 		voxels::Map m_map;
+		/// @brief The players that have connected, to send chunks to
+		std::vector<ConnectedPlayer> m_players;
+		/// @brief The latest input of each player.
+		std::unordered_map<entt::entity, PlayerInput> m_inputs;
+		/// @brief The sequence of the last bundle of inputs applied.
+		std::size_t m_sequence = 0;
+		/// @brief How many players can see each chunk, chunks are only kept
+		/// loaded while a player can see them.
+		std::unordered_map<math::vec3, std::size_t, math::Vector3Hasher,
+		                   math::Vector3KeyComparator>
+		    m_chunkReferences;
 	};
 } // namespace phx::server
\ No newline at end of file
@@ -35,12 +35,18 @@
 
 #include <Common/Input.hpp>
 #include <Common/Network/Host.hpp>
+#include <Common/Network/Snapshot.hpp>
 #include <Common/Utility/BlockingQueue.hpp>
+#include <Common/Utility/Compression.hpp>
 #include <Common/Voxels/Chunk.hpp>
 
 #include <enet/enet.h>
 #include <entt/entt.hpp>
 
+#include <chrono>
+#include <mutex>
+#include <unordered_map>
+
 namespace phx::server::net
 {
 	struct StateBundle
@@ -51,6 +57,21 @@ namespace phx::server::net
 		std::unordered_map<entt::entity, InputState> states;
 	};
 
+	/**
+	 * @brief Counts of the input states received from users
+	 */
+	struct InputStats
+	{
+		/// @brief States queued for the game.
+		std::size_t received = 0;
+		/// @brief States queued that only arrived as a redundant copy.
+		std::size_t recovered = 0;
+		/// @brief Copies of states already queued, or that came too late.
+		std::size_t discarded = 0;
+		/// @brief States the game had to go without.
+		std::size_t lost = 0;
+	};
+
 	struct MessageBundle
 	{
 		size_t      userID;
@@ -111,6 +132,9 @@ namespace phx::server::net
 		/**
 		 * @brief Actions taken when a state is received
 		 *
+		 * A state packet carries the user's latest few input states, every
+		 * one not seen before is queued.
+		 *
 		 * @param userRef The user who sent the state packet
 		 * @param data The data in the state packet
 		 * @param dataLength The length of the data in the state packet
@@ -135,13 +159,30 @@ namespace phx::server::net
 		void sendEvent(std::size_t userID, enet_uint8* data);
 
 		/**
-		 * @brief Sends a state packet to a client
+		 * @brief Sends every user a snapshot of the entities around them
+		 *
+		 * Each user is only sent the entities in the chunks they can see,
+		 * as a delta against the last snapshot they acknowledged.
 		 *
-		 * @param userRef The user to sent the state to
-		 * @param data The state packet data
+		 * @param registry The registry holding the entities
+		 * @param sequence The sequence of the last inputs applied
 		 */
 		void sendState(entt::registry* registry, std::size_t sequence);
 
+		/**
+		 * @brief Gets how much snapshot data each user is being sent
+		 *
+		 * @return The bytes sent per second to each user, measured over the
+		 * last second
+		 */
+		std::unordered_map<std::size_t, float> getBandwidth();
+
+		/**
+		 * @brief Gets how many input states have been received, recovered
+		 * and lost since the server started
+		 */
+		InputStats getInputStats();
+
 		/**
 		 * @brief Sends a message packet to a client
 		 *
@@ -160,6 +201,9 @@ namespace phx::server::net
 		 * needs expanded upon before we can do that. This is why its named
 		 * sendData();
 		 *
+		 * The chunk is compressed with the codec negotiated with the user
+		 * when they connected.
+		 *
 		 * @param userID The user the data is being sent to
 		 * @param data The data to send (Currently, this is just a pointer to a chunk)
 		 */
@@ -184,5 +228,34 @@ namespace phx::server::net
 		phx::net::Host*                               m_server;
 		entt::registry*                               m_registry;
 		std::unordered_map<std::size_t, entt::entity> m_users;
+
+		void queueState(entt::entity player, InputState input, bool redundant);
+		void releaseBundle();
+
+		// the sequence of the bundle at the front of currentBundles, every
+		// state before it has been handed to the game.
+		std::size_t m_nextBundle = 0;
+		std::mutex  m_inputMutex;
+		InputStats  m_inputStats;
+
+		// the snapshots sent to each user, acknowledgements come in on the
+		// network thread.
+		struct SnapshotClient
+		{
+			entt::entity             player;
+			phx::net::SnapshotSender sender;
+
+			std::chrono::steady_clock::time_point windowStart;
+			std::size_t                           windowBytes = 0;
+			float                                 bandwidth   = 0.f;
+		};
+
+		std::mutex                                      m_snapshotMutex;
+		std::unordered_map<std::size_t, SnapshotClient> m_snapshots;
+
+		// the codec each user can decompress, set from the network thread.
+		std::mutex                                   m_codecMutex;
+		std::unordered_map<std::size_t, data::Codec> m_codecs;
+		int                                          m_compressionLevel;
 	};
 } // namespace phx::server::net
\ No newline at end of file
@@ -0,0 +1,105 @@
+// Copyright 2019-20 Genten Studios
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors
+// may be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+/**
+ * @file TickTimer.hpp
+ * @brief Keeps track of how long the server's ticks take.
+ *
+ * @copyright Copyright (c) 2019-2020
+ *
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <vector>
+
+namespace phx::server
+{
+	/**
+	 * @brief Records how long each tick took against the time it was given,
+	 * so ticks that overrun it can be spotted.
+	 */
+	class TickTimer
+	{
+	public:
+		using Clock    = std::chrono::steady_clock;
+		using Duration = Clock::duration;
+
+		/// @brief How many of the latest ticks the percentiles are taken
+		/// over.
+		static constexpr std::size_t HISTORY = 1200;
+
+		/**
+		 * @brief Creates a timer for ticks at a fixed rate.
+		 * @param rate How many ticks there are per second.
+		 */
+		explicit TickTimer(unsigned int rate);
+
+		/**
+		 * @brief Records how long a tick took.
+		 * @param time The time the tick took.
+		 * @return true if the tick took longer than it was given.
+		 */
+		bool record(Duration time);
+
+		/**
+		 * @brief Records ticks that were dropped because the server fell too
+		 * far behind to catch up on them.
+		 * @param ticks How many ticks were dropped.
+		 */
+		void skip(std::size_t ticks);
+
+		/**
+		 * @brief Gets how long the slowest ticks took.
+		 * @param percentile The share of ticks that were faster, from 0 to 1.
+		 * @return The time in milliseconds, or 0 if nothing was recorded.
+		 */
+		float getPercentile(float percentile) const;
+
+		unsigned int getRate() const { return m_rate; }
+		Duration     getBudget() const { return m_budget; }
+		std::size_t  getTicks() const { return m_ticks; }
+		std::size_t  getOverruns() const { return m_overruns; }
+		std::size_t  getSkipped() const { return m_skipped; }
+
+	private:
+		unsigned int m_rate;
+		Duration     m_budget;
+
+		// the latest tick times in milliseconds, wrapping around.
+		std::vector<float> m_times;
+		std::size_t        m_next = 0;
+
+		std::size_t m_ticks    = 0;
+		std::size_t m_overruns = 0;
+		std::size_t m_skipped  = 0;
+		bool        m_overran  = false;
+	};
+} // namespace phx::server
@@ -38,9 +38,14 @@
 #include <Common/Logger.hpp>
 #include <Server/Commander.hpp>
 
+#include <iomanip>
+
 using namespace phx::server;
 
-Commander::Commander(net::Iris* iris) : m_iris(iris) {}
+Commander::Commander(net::Iris* iris, const TickTimer* ticks)
+    : m_iris(iris), m_ticks(ticks)
+{
+}
 
 void Commander::registerAPI(phx::cms::ModManager* manager)
 {
@@ -159,6 +164,11 @@ bool Commander::run(std::size_t userRef, const std::string& input)
 		list(userRef);
 		return true;
 	}
+	else if (command == "stats")
+	{
+		stats(userRef);
+		return true;
+	}
 
 	// If no built in functions match, search library
 	auto com = m_commands.find(command);
@@ -191,6 +201,12 @@ bool Commander::help(std::size_t userRef, const std::vector<std::string>& args)
 		m_iris->sendMessage(userRef, "Lists available commands\n");
 		return true;
 	}
+	else if (args[0] == "stats")
+	{
+		m_iris->sendMessage(userRef, "Shows how long ticks take and how much "
+		                             "data each user is being sent\n");
+		return true;
+	}
 
 	auto com = m_commands.find(args[0]);
 	if (com != m_commands.end())
@@ -210,3 +226,36 @@ void Commander::list(std::size_t userRef)
 		m_iris->sendMessage(userRef, "- " + com.second.command + "\n");
 	}
 }
+
+void Commander::stats(std::size_t userRef)
+{
+	std::ostringstream out;
+	out << std::fixed << std::setprecision(2);
+
+	if (m_ticks != nullptr)
+	{
+		out << "Ticks at " << m_ticks->getRate() << " Hz, "
+		    << std::chrono::duration<float, std::milli>(m_ticks->getBudget())
+		           .count()
+		    << " ms each:\n"
+		    << "- p50: " << m_ticks->getPercentile(0.5f) << " ms\n"
+		    << "- p90: " << m_ticks->getPercentile(0.9f) << " ms\n"
+		    << "- p99: " << m_ticks->getPercentile(0.99f) << " ms\n"
+		    << "- max: " << m_ticks->getPercentile(1.f) << " ms\n"
+		    << "- " << m_ticks->getOverruns() << " of " << m_ticks->getTicks()
+		    << " overran, " << m_ticks->getSkipped() << " skipped\n";
+	}
+
+	out << "Snapshot bandwidth:\n";
+	for (const auto& user : m_iris->getBandwidth())
+	{
+		out << "- user " << user.first << ": " << user.second / 1024.f
+		    << " KiB/s\n";
+	}
+
+	const net::InputStats inputs = m_iris->getInputStats();
+	out << "Inputs: " << inputs.received << " received, " << inputs.recovered
+	    << " recovered from redundant copies, " << inputs.lost << " lost, "
+	    << inputs.discarded << " discarded\n";
+	m_iris->sendMessage(userRef, out.str());
+}
@@ -30,8 +30,11 @@
 #include <Server/User.hpp>
 
 #include <Common/Actor.hpp>
+#include <Common/Logger.hpp>
 #include <Common/PlayerView.hpp>
+#include <Common/Settings.hpp>
 
+#include <algorithm>
 #include <thread>
 
 using namespace phx;
@@ -40,9 +43,21 @@ using namespace phx::server;
 Game::Game(BlockRegistry* blockReg, entt::registry* registry,
            phx::server::net::Iris* iris, Save* save)
     : m_blockRegistry(blockReg), m_registry(registry), m_iris(iris),
-      m_map(voxels::Map(save, "map1", &blockReg->referrer))
+      m_ticks(static_cast<unsigned int>(std::max<int>(
+          Settings::instance()->getOr("server:tick_rate", 20), 1))),
+      m_map(save, "map1", &blockReg->referrer,
+            Settings::instance()->getOr("map:io_threads", 2))
 {
-	m_commander = new Commander(m_iris);
+	m_commander = new Commander(m_iris, &m_ticks);
+
+	m_map.setWriteBack(
+	    std::chrono::milliseconds(
+	        Settings::instance()->getOr("map:flush_interval_ms", 5000)),
+	    Settings::instance()->getOr("map:max_dirty_chunks", 64));
+	m_map.setCompression(
+	    data::Compression::fromName(Settings::instance()->getOr(
+	        "map:compression", std::string("deflate"))),
+	    Settings::instance()->getOr("map:compression_level", 1));
 }
 
 Game::~Game()
@@ -58,80 +73,362 @@ void Game::registerAPI(cms::ModManager* manager)
 
 void Game::run()
 {
+	using Clock = TickTimer::Clock;
+
+	const TickTimer::Duration tickLength = m_ticks.getBudget();
+
+	// time the game is behind the clock, paid off a whole tick at a time.
+	TickTimer::Duration lag {0};
+	Clock::time_point   previous = Clock::now();
+
 	m_running = true;
 	while (m_running)
 	{
-		// Wait for a new input bundle from the network
-		if (m_iris->stateQueue.empty())
+		const Clock::time_point now = Clock::now();
+		lag += now - previous;
+		previous = now;
+
+		// after a long stall only a few ticks are caught up on, running
+		// every missed tick back to back would only fall further behind.
+		if (lag > tickLength * MAX_CATCH_UP_TICKS)
 		{
-			// This just keeps the CPU from spinning
-			std::this_thread::sleep_for(1_ms);
-			continue;
+			const auto skipped =
+			    static_cast<std::size_t>(lag / tickLength) - MAX_CATCH_UP_TICKS;
+			m_ticks.skip(skipped);
+			lag -= tickLength * skipped;
+
+			LOG_WARNING("GAME") << "The server fell " << skipped
+			                    << " ticks behind, skipping them.";
 		}
-		net::StateBundle m_currentState = m_iris->stateQueue.pop();
 
-		// Process everybody's input first
-		for (const auto& state : m_currentState.states)
+		while (lag >= tickLength && m_running)
 		{
-			auto       player = m_registry->get<Player>(state.first);
-			math::vec3 pos = m_registry->get<Position>(player.actor).position;
-			const math::vec3i oldPos(
-			    static_cast<int>(pos.x) / voxels::Chunk::CHUNK_WIDTH,
-			    static_cast<int>(pos.y) / voxels::Chunk::CHUNK_HEIGHT,
-			    static_cast<int>(pos.z) / voxels::Chunk::CHUNK_DEPTH);
-			ActorSystem::tick(m_registry, player.actor, dt, state.second);
-			pos = m_registry->get<Position>(player.actor).position;
-			const math::vec3i newPos(
-			    static_cast<int>(pos.x) / voxels::Chunk::CHUNK_WIDTH,
-			    static_cast<int>(pos.y) / voxels::Chunk::CHUNK_HEIGHT,
-			    static_cast<int>(pos.z) / voxels::Chunk::CHUNK_DEPTH);
-			// TODO this needs fixed in the math lib
-			if (!(oldPos == newPos))
-			{
-				for (const auto& chunk :
-				     PlayerView::update(m_registry, player.actor))
-				{
-					m_iris->sendData(player.id, chunk);
-				}
-			}
+			const Clock::time_point start = Clock::now();
+			tick();
+			m_ticks.record(Clock::now() - start);
+
+			lag -= tickLength;
 		}
 
-		// Process events second
-		size_t size = m_iris->eventQueue.size();
-		for (size_t i = 0; i < size; i++)
+		std::this_thread::sleep_until(previous + (tickLength - lag));
+	}
+}
+
+void Game::tick()
+{
+	// Publish chunks the map has finished loading in the background and
+	// send them to the players that were waiting on them.
+	const bool published = m_map.tick(2_ms) > 0;
+
+	// players that left let go of their chunks straight away, not only once
+	// something new has loaded, which might never happen if they were the
+	// last one.
+	bool released = releaseDisconnected();
+	if (published)
+	{
+		released |= sendNewChunks();
+	}
+
+	// chunks can finish loading after every player that asked for them has
+	// moved on, so those are unloaded here too.
+	if (released || m_map.getLoadedChunkCount() > m_chunkReferences.size())
+	{
+		unloadUnusedChunks();
+	}
+
+	// Process everybody's input first. Players move a step per input sent,
+	// so that happens at the rate inputs are sent rather than every tick.
+	m_stepLag += m_ticks.getBudget();
+
+	bool stepped = false;
+	while (m_stepLag >= STEP_LENGTH)
+	{
+		applyInputs();
+		m_stepLag -= STEP_LENGTH;
+		stepped = true;
+	}
+
+	// Process events second
+	size_t size = m_iris->eventQueue.size();
+	for (size_t i = 0; i < size; i++)
+	{
+		net::Event event = m_iris->eventQueue.pop();
+		switch (event.type)
 		{
-			net::Event event = m_iris->eventQueue.pop();
-			switch (event.type)
-			{
-			case net::Event::Type::CONNECT:
+		case net::Event::Type::CONNECT:
+		{
+			auto entity = m_registry->get<Player>(event.player);
+			m_registry->emplace<PlayerView>(entity.actor, &m_map);
+			m_players.push_back({event.player, entity.actor});
+			updateView(event.player);
+			break;
+		}
+		default:
+			LOG_WARNING("GAME") << "Invalid network event received";
+			break;
+		}
+	}
+
+	// Process messages last
+	size = m_iris->messageQueue.size();
+	for (size_t i = 0; i < size; i++)
+	{
+		net::MessageBundle message = m_iris->messageQueue.front();
+		m_commander->run(message.userID, message.message);
+		m_iris->messageQueue.pop();
+	}
+
+	// Dispatch confirmation states
+	if (stepped)
+	{
+		m_iris->sendState(m_registry, m_sequence);
+	}
+}
+
+void Game::applyInputs()
+{
+	// a bundle of inputs a step, plus any that have piled up beyond a few
+	// because a client's clock runs faster than ours.
+	std::size_t bundles = 1;
+	if (m_iris->stateQueue.size() > MAX_QUEUED_BUNDLES)
+	{
+		bundles += m_iris->stateQueue.size() - MAX_QUEUED_BUNDLES;
+	}
+
+	std::vector<entt::entity> applied;
+	for (std::size_t i = 0; i < bundles && !m_iris->stateQueue.empty();)
+	{
+		const net::StateBundle bundle = m_iris->stateQueue.pop();
+		m_sequence                    = bundle.sequence;
+
+		bool stepped = false;
+		for (const auto& state : bundle.states)
+		{
+			// the player is destroyed when they disconnect.
+			if (!m_registry->valid(state.first))
 			{
-				auto entity = m_registry->get<Player>(event.player);
-				m_registry->emplace<PlayerView>(entity.actor, &m_map);
-				for (const auto& chunk :
-				     PlayerView::update(m_registry, entity.actor))
-				{
-					m_iris->sendData(entity.id, chunk);
-				}
-				break;
+				continue;
 			}
-			default:
-				LOG_WARNING("GAME") << "Invalid network event received";
-				break;
+
+			PlayerInput& player = m_inputs[state.first];
+
+			// an input that arrived after its tick already had the last one
+			// repeated in its place. Applying it as well would move the
+			// player twice, so it takes the repeat's place instead.
+			const bool late = state.second.sequence > player.sequence &&
+			                  state.second.sequence - player.sequence <=
+			                      player.repeated;
+			if (late)
+			{
+				replaceRepeats(state.first, player, state.second);
+				continue;
 			}
+
+			applyInput(state.first, state.second);
+			applied.push_back(state.first);
+			stepped = true;
+
+			player.input    = state.second;
+			player.sequence = state.second.sequence;
+			player.repeated = 0;
 		}
 
-		// Process messages last
-		size = m_iris->messageQueue.size();
-		for (size_t i = 0; i < size; i++)
+		// bundles that were only late inputs don't use up the step, the next
+		// one is applied in their place so players stay in step with what
+		// has arrived.
+		if (stepped)
 		{
-			net::MessageBundle message = m_iris->messageQueue.front();
-			m_commander->run(message.userID, message.message);
-			m_iris->messageQueue.pop();
+			++i;
 		}
+	}
 
-		// Dispatch confirmation states
-		m_iris->sendState(m_registry, m_currentState.sequence);
+	// a player whose input hasn't arrived in time is taken to still be
+	// holding the same keys, which is what their input most often is.
+	for (const ConnectedPlayer& player : m_players)
+	{
+		if (std::find(applied.begin(), applied.end(), player.player) !=
+		    applied.end())
+		{
+			continue;
+		}
+
+		const auto last = m_inputs.find(player.player);
+		if (last == m_inputs.end() || !m_registry->valid(player.player))
+		{
+			continue;
+		}
+
+		if (last->second.repeated == 0)
+		{
+			last->second.rewind = m_registry->get<Position>(player.actor);
+		}
+
+		applyInput(player.player, last->second.input);
+		++last->second.repeated;
+	}
+}
+
+void Game::replaceRepeats(entt::entity player, PlayerInput& input,
+                          const InputState& late)
+{
+	// the player is destroyed when they disconnect.
+	if (!m_registry->valid(player))
+	{
+		return;
+	}
+
+	const entt::entity actor    = m_registry->get<Player>(player).actor;
+	const std::size_t  replaced = late.sequence - input.sequence;
+
+	// movement only depends on the input, so the repeats are undone and
+	// played again with the input that was meant for them. The inputs
+	// between the last one and the late one never arrived, they keep the
+	// repeat that stood in for them.
+	m_registry->get<Position>(actor) = input.rewind;
+	for (std::size_t i = 1; i < replaced; ++i)
+	{
+		applyInput(player, input.input);
+	}
+	applyInput(player, late);
+
+	input.input    = late;
+	input.sequence = late.sequence;
+	input.repeated -= replaced;
+	input.rewind = m_registry->get<Position>(actor);
+
+	// the ticks after it are still waiting on their input, the late one is
+	// what they repeat now.
+	for (std::size_t i = 0; i < input.repeated; ++i)
+	{
+		applyInput(player, late);
+	}
+}
+
+void Game::applyInput(entt::entity player, const InputState& input)
+{
+	// the player is destroyed when they disconnect.
+	if (!m_registry->valid(player))
+	{
+		return;
+	}
+
+	const float dt = 1.f / InputState::RATE;
+
+	auto       data = m_registry->get<Player>(player);
+	math::vec3 pos  = m_registry->get<Position>(data.actor).position;
+	const math::vec3i oldPos(
+	    static_cast<int>(pos.x) / voxels::Chunk::CHUNK_WIDTH,
+	    static_cast<int>(pos.y) / voxels::Chunk::CHUNK_HEIGHT,
+	    static_cast<int>(pos.z) / voxels::Chunk::CHUNK_DEPTH);
+	ActorSystem::tick(m_registry, data.actor, dt, input);
+	pos = m_registry->get<Position>(data.actor).position;
+	const math::vec3i newPos(
+	    static_cast<int>(pos.x) / voxels::Chunk::CHUNK_WIDTH,
+	    static_cast<int>(pos.y) / voxels::Chunk::CHUNK_HEIGHT,
+	    static_cast<int>(pos.z) / voxels::Chunk::CHUNK_DEPTH);
+	// TODO this needs fixed in the math lib
+	if (!(oldPos == newPos) && updateView(player))
+	{
+		unloadUnusedChunks();
 	}
 }
 
 void Game::kill() { m_running = false; }
+
+bool Game::releaseDisconnected()
+{
+	bool released = false;
+	for (auto it = m_players.begin(); it != m_players.end();)
+	{
+		// the player is destroyed when they disconnect.
+		if (!m_registry->valid(it->player))
+		{
+			releaseView(it->actor);
+			released = true;
+
+			m_inputs.erase(it->player);
+			it = m_players.erase(it);
+			continue;
+		}
+
+		++it;
+	}
+
+	return released;
+}
+
+bool Game::sendNewChunks()
+{
+	bool released = false;
+	for (const ConnectedPlayer& player : m_players)
+	{
+		released |= updateView(player.player);
+	}
+
+	return released;
+}
+
+bool Game::updateView(entt::entity player)
+{
+	const Player& data = m_registry->get<Player>(player);
+
+	for (const auto& chunk : PlayerView::update(m_registry, data.actor))
+	{
+		++m_chunkReferences[chunk->getChunkPos()];
+		m_iris->sendData(data.id, chunk);
+	}
+
+	bool released = false;
+	for (const math::vec3& pos : PlayerView::evict(m_registry, data.actor))
+	{
+		const auto it = m_chunkReferences.find(pos);
+		if (it != m_chunkReferences.end() && --it->second == 0)
+		{
+			m_chunkReferences.erase(it);
+			released = true;
+		}
+	}
+
+	return released;
+}
+
+void Game::releaseView(entt::entity actor)
+{
+	if (!m_registry->valid(actor))
+	{
+		return;
+	}
+
+	PlayerView* view = m_registry->try_get<PlayerView>(actor);
+	if (view == nullptr)
+	{
+		return;
+	}
+
+	for (const voxels::ChunkPos& pos : view->tracker.getLoaded())
+	{
+		const auto it = m_chunkReferences.find(voxels::toPosition(pos));
+		if (it != m_chunkReferences.end() && --it->second == 0)
+		{
+			m_chunkReferences.erase(it);
+		}
+	}
+
+	view->tracker.clear();
+}
+
+void Game::unloadUnusedChunks()
+{
+	const std::size_t unloaded =
+	    m_map.unloadChunks([this](const math::vec3& pos) {
+		    return m_chunkReferences.find(pos) != m_chunkReferences.end();
+	    });
+
+	if (unloaded > 0)
+	{
+		LOG_DEBUG("GAME") << "Unloaded " << unloaded << " chunks, "
+		                  << m_map.getLoadedChunkCount() << " chunks ("
+		                  << m_map.getMemoryUsage() / 1024
+		                  << " KiB) still loaded";
+	}
+}
@@ -32,9 +32,13 @@
 #include <Common/Actor.hpp>
 #include <Common/Logger.hpp>
 #include <Common/Movement.hpp>
+#include <Common/PlayerView.hpp>
 #include <Common/Position.hpp>
+#include <Common/Settings.hpp>
 #include <Common/Utility/Serializer.hpp>
 
+#include <algorithm>
+
 using namespace phx;
 using namespace phx::net;
 using namespace phx::server::net;
@@ -42,18 +46,41 @@ using namespace phx::server::net;
 /// @todo Replace this with the config system
 static const std::size_t MAX_USERS = 32;
 
+// how many bundles can wait on missing states before the oldest is handed to
+// the game without them.
+static const std::size_t MAX_PENDING_BUNDLES = 10;
+
+static std::uint32_t toID(entt::entity entity)
+{
+	return static_cast<std::uint32_t>(entity);
+}
+
 Iris::Iris(entt::registry* registry) : m_registry(registry), m_running(false)
 {
+	m_compressionLevel =
+	    Settings::instance()->getOr("network:compression_level", 1);
+
 	m_server = new phx::net::Host(phx::net::Address(7777), MAX_USERS, 4);
 
-	m_server->onConnect([this](Peer& peer, enet_uint32) {
+	m_server->onConnect([this](Peer& peer, enet_uint32 codecs) {
 		LOG_INFO("NETWORK")
 		    << "Client connected from: " << peer.getAddress().getIP();
+		{
+			// clients connect with the codecs they can decompress.
+			std::lock_guard<std::mutex> lock(m_codecMutex);
+			m_codecs[peer.getID()] = data::Compression::negotiate(codecs);
+		}
 		{
 			auto entity = m_registry->create();
 			m_registry->emplace<Player>(
 			    entity, ActorSystem::registerActor(m_registry), peer.getID());
 			m_users.emplace(peer.getID(), entity);
+			{
+				std::lock_guard<std::mutex> lock(m_snapshotMutex);
+				SnapshotClient&             client = m_snapshots[peer.getID()];
+				client.player                      = entity;
+				client.windowStart = std::chrono::steady_clock::now();
+			}
 			eventQueue.push({entity, Event::Type::CONNECT});
 		}
 	});
@@ -96,6 +123,14 @@ void Iris::disconnect(std::size_t peerID)
 {
 	LOG_INFO("NETWORK") << peerID << " disconnected";
 	m_registry->destroy(m_users.at(peerID));
+
+	{
+		std::lock_guard<std::mutex> lock(m_snapshotMutex);
+		m_snapshots.erase(peerID);
+	}
+
+	std::lock_guard<std::mutex> lock(m_codecMutex);
+	m_codecs.erase(peerID);
 }
 
 void Iris::parseEvent(std::size_t userID, Packet& packet)
@@ -103,7 +138,7 @@ void Iris::parseEvent(std::size_t userID, Packet& packet)
 	std::string data;
 
 	phx::Serializer ser;
-	ser.setBuffer(packet.getData());
+	ser.setView(packet.getRawData(), packet.getSize());
 	ser >> data;
 
 	printf("Event received");
@@ -113,88 +148,135 @@ void Iris::parseEvent(std::size_t userID, Packet& packet)
 
 void Iris::parseState(std::size_t userID, phx::net::Packet& packet)
 {
-	InputState input;
-
-	auto data = packet.getData();
+	InputBatch batch;
 
 	phx::Serializer ser;
-	ser.setBuffer(data.data(), packet.getSize());
-	ser >> input;
+	ser.setView(packet.getRawData(), packet.getSize());
+	ser >> batch;
+
+	// inputs carry the newest snapshot the client has.
+	if (!ser.empty())
+	{
+		std::uint32_t acknowledged;
+		ser >> acknowledged;
+
+		std::lock_guard<std::mutex> lock(m_snapshotMutex);
+		const auto                  it = m_snapshots.find(userID);
+		if (it != m_snapshots.end())
+		{
+			it->second.sender.acknowledge(acknowledged);
+		}
+	}
+
+	if (batch.states.empty())
+	{
+		return;
+	}
+
+	// oldest first, so the states missing from the queue are filled in
+	// before the newest one can complete a bundle.
+	const entt::entity player = m_users[userID];
+	for (std::size_t i = batch.states.size(); i-- > 0;)
+	{
+		queueState(player, batch.states[i], i != 0);
+	}
+}
+
+void Iris::queueState(entt::entity player, InputState input, bool redundant)
+{
+	std::lock_guard<std::mutex> lock(m_inputMutex);
+
+	// only the lowest bits of a sequence are sent, the rest is taken from
+	// where the queue is.
+	input.sequence = BitReader::unwrapSequence(
+	    static_cast<std::uint16_t>(input.sequence), m_nextBundle);
+
+	// most of a batch has already been handed to the game, something far
+	// older than a batch reaches means the user's sequence started over.
+	if (input.sequence < m_nextBundle &&
+	    m_nextBundle - input.sequence <= InputBatch::MAX_STATES)
+	{
+		++m_inputStats.discarded;
+		return;
+	}
+
+	// only so many bundles are waited on, the oldest are given up on to
+	// make room.
+	while (!currentBundles.empty() &&
+	       (input.sequence < m_nextBundle ||
+	        input.sequence - m_nextBundle >= MAX_PENDING_BUNDLES))
+	{
+		releaseBundle();
+	}
 
-	// If the queue is empty we need to add a new bundle
 	if (currentBundles.empty())
+	{
+		// every redundant copy of a skipped state was lost as well, so there
+		// is nothing left to wait for.
+		if (m_nextBundle != 0 && input.sequence > m_nextBundle)
+		{
+			m_inputStats.lost += input.sequence - m_nextBundle;
+		}
+		m_nextBundle = input.sequence;
+	}
+
+	while (currentBundles.size() <= input.sequence - m_nextBundle)
 	{
 		StateBundle bundle;
-		bundle.sequence = input.sequence;
+		bundle.sequence = m_nextBundle + currentBundles.size();
 		bundle.ready    = false;
 		bundle.users    = 1; ///@todo We need to capture how many users we are
 		/// expecting packets from
 		currentBundles.push_back(bundle);
 	}
 
-	// Discard state if its older that the oldest stateBundle
-	if (input.sequence < currentBundles.front().sequence &&
-	    currentBundles.back().sequence - input.sequence < 10)
+	StateBundle& bundle = currentBundles[input.sequence - m_nextBundle];
+	if (!bundle.states.emplace(player, input).second)
 	{
-		printf("discard %lu \n", input.sequence);
+		++m_inputStats.discarded;
 		return;
 	}
 
-	// Fill the stateBundles up to the current input sequence
-	while ((input.sequence > currentBundles.back().sequence &&
-	        input.sequence - currentBundles.back().sequence > 10) ||
-	       currentBundles.back().sequence == 255)
+	++m_inputStats.received;
+	if (redundant)
 	{
-		// Insert a new bundle if this is the first packet in this sequence
-		StateBundle bundle;
-		bundle.sequence = currentBundles.back().sequence + 1;
-		bundle.ready    = false;
-		bundle.users    = 1; ///@todo We need to capture how many users we are
-		/// expecting packets from
-		currentBundles.push_back(bundle);
+		++m_inputStats.recovered;
 	}
 
+	// bundles are handed over in order, as soon as they have every state.
+	while (!currentBundles.empty() &&
+	       currentBundles.front().states.size() >= currentBundles.front().users)
 	{
-		for (auto it = currentBundles.begin(); it != currentBundles.end(); ++it)
-		{
-			StateBundle& bundle = *it;
-			if (bundle.sequence == input.sequence)
-			{
-				// Thread safety! If we said a bundle is ready, were too late
-				if (!bundle.ready)
-				{
-					bundle.states[m_users[userID]] = input;
-					// If we have all the states we need, then the bundle is
-					// ready
-					if (bundle.states.size() >= bundle.users)
-					{
-						bundle.ready = true;
-						stateQueue.push(bundle);
-						currentBundles.erase(it);
-					}
-				}
-				break;
-			}
-		}
+		releaseBundle();
 	}
+}
 
-	// If we have more than 10 states enqueued, assume we lost a packet
-	if (currentBundles.size() > 10)
+void Iris::releaseBundle()
+{
+	StateBundle& bundle = currentBundles.front();
+	if (bundle.states.size() < bundle.users)
 	{
-		currentBundles.front().ready = true;
-		stateQueue.push(currentBundles.front());
-		currentBundles.erase(currentBundles.begin());
+		m_inputStats.lost += bundle.users - bundle.states.size();
 	}
+
+	bundle.ready = true;
+	stateQueue.push(std::move(bundle));
+	currentBundles.erase(currentBundles.begin());
+	++m_nextBundle;
+}
+
+InputStats Iris::getInputStats()
+{
+	std::lock_guard<std::mutex> lock(m_inputMutex);
+	return m_inputStats;
 }
 
 void Iris::parseMessage(std::size_t userID, phx::net::Packet& packet)
 {
 	std::string input;
 
-	auto data = packet.getData();
-
 	phx::Serializer ser;
-	ser.setBuffer(reinterpret_cast<std::byte*>(data.data()), data.size());
+	ser.setView(packet.getRawData(), packet.getSize());
 	ser >> input;
 
 	/// @TODO replace userID with userName
@@ -217,32 +299,112 @@ void Iris::sendEvent(std::size_t userID, enet_uint8* data) {}
 
 void Iris::sendState(entt::registry* registry, std::size_t sequence)
 {
-	auto       view = registry->view<Position, Movement>();
-	Serializer ser;
-	ser << sequence;
+	// every entity is quantized once, users only differ in which of them
+	// they can see.
+	struct VisibleEntity
+	{
+		EntityState      state;
+		voxels::ChunkPos chunk;
+	};
+
+	std::vector<VisibleEntity> entities;
+	auto                       view = registry->view<Position, Movement>();
 	for (auto entity : view)
 	{
-		auto pos = view.get<Position>(entity);
-		ser << pos.position.x << pos.position.y << pos.position.z;
+		entities.push_back(
+		    {EntityState::quantize(toID(entity), view.get<Position>(entity)),
+		     PlayerView::getChunkPos(registry, entity)});
+	}
+	std::sort(entities.begin(), entities.end(),
+	          [](const VisibleEntity& lhs, const VisibleEntity& rhs) {
+		          return lhs.state.id < rhs.state.id;
+	          });
+
+	const auto now = std::chrono::steady_clock::now();
+
+	std::lock_guard<std::mutex> lock(m_snapshotMutex);
+	for (auto& user : m_snapshots)
+	{
+		SnapshotClient& client = user.second;
+		Peer*           peer   = m_server->getPeer(user.first);
+		if (peer == nullptr || !registry->valid(client.player))
+		{
+			continue;
+		}
+
+		const entt::entity actor = registry->get<Player>(client.player).actor;
+		const PlayerView*  playerView = registry->try_get<PlayerView>(actor);
+
+		Snapshot snapshot;
+		snapshot.sequence = sequence;
+		snapshot.self     = toID(actor);
+		for (const VisibleEntity& entity : entities)
+		{
+			// users only hear about entities in the chunks they can see.
+			if (entity.state.id == snapshot.self ||
+			    (playerView != nullptr &&
+			     playerView->tracker.isInRange(entity.chunk)))
+			{
+				snapshot.entities.push_back(entity.state);
+			}
+		}
+
+		Serializer ser(Packet::acquireBuffer());
+		client.sender.write(std::move(snapshot), ser);
+
+		client.windowBytes += ser.getBuffer().size();
+		const std::chrono::duration<float> window = now - client.windowStart;
+		if (window.count() >= 1.f)
+		{
+			client.bandwidth   = client.windowBytes / window.count();
+			client.windowBytes = 0;
+			client.windowStart = now;
+		}
+
+		peer->send(Packet(std::move(ser.getBuffer()), PacketFlags::UNRELIABLE),
+		           1);
 	}
-	Packet packet = Packet(ser.getBuffer(), PacketFlags::UNRELIABLE);
-	m_server->broadcast(packet, 1);
+}
+
+std::unordered_map<std::size_t, float> Iris::getBandwidth()
+{
+	std::unordered_map<std::size_t, float> bandwidth;
+
+	std::lock_guard<std::mutex> lock(m_snapshotMutex);
+	for (const auto& user : m_snapshots)
+	{
+		bandwidth.emplace(user.first, user.second.bandwidth);
+	}
+	return bandwidth;
 }
 
 void Iris::sendMessage(std::size_t userID, const std::string& message)
 {
-	Serializer ser;
+	Serializer ser(Packet::acquireBuffer());
 	ser << message;
-	Packet packet = Packet(ser.getBuffer(), PacketFlags::RELIABLE);
+	Packet packet = Packet(std::move(ser.getBuffer()), PacketFlags::RELIABLE);
 	Peer*  peer   = m_server->getPeer(userID);
 	peer->send(packet, 2);
 }
 
 void Iris::sendData(std::size_t userID, voxels::Chunk* data)
 {
+	phx::data::Codec codec = phx::data::Codec::NONE;
+	{
+		std::lock_guard<std::mutex> lock(m_codecMutex);
+		const auto                  it = m_codecs.find(userID);
+		if (it != m_codecs.end())
+		{
+			codec = it->second;
+		}
+	}
+
 	Serializer ser;
 	ser << *data;
-	Packet packet = Packet(ser.getBuffer(), PacketFlags::RELIABLE);
-	Peer*  peer   = m_server->getPeer(userID);
+
+	Packet packet = Packet(phx::data::Compression::compress(
+	                           ser.getBuffer(), codec, m_compressionLevel),
+	                       PacketFlags::RELIABLE);
+	Peer* peer = m_server->getPeer(userID);
 	peer->send(packet, 3);
 }
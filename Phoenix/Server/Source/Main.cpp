@@ -28,11 +28,36 @@
 
 #include <Server/Server.hpp>
 
+#include <Common/CLIParser.hpp>
+#include <Common/Logger.hpp>
+#include <Common/Voxels/Map.hpp>
+
 using namespace phx;
 
 #undef main
 int main(int argc, char** argv)
 {
+	CLIParser parser;
+	parser.addParameter({"migrate", "m",
+	                     "Packs the per chunk save files of a save into region "
+	                     "files and exits.",
+	                     false, false, true});
+
+	if (!parser.parse(argc, argv))
+	{
+		return 1;
+	}
+
+	if (const auto* migrate = parser.getArgument("migrate"))
+	{
+		LoggerConfig config;
+		config.verbosity = LogVerbosity::DEBUG;
+		Logger::initialize(config);
+
+		voxels::Map::migrateLegacySaves(migrate->front(), "map1");
+		return 0;
+	}
+
 	//    std::string save;
 	//    if (argc > 0){
 	//        save = argv[0];
@@ -43,5 +68,8 @@ int main(int argc, char** argv)
 	server::Server* server = new server::Server("save1");
 	server->run();
 
+	// saves anything that is still waiting to be written.
+	delete server;
+
 	return 0;
 }
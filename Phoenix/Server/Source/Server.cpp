@@ -132,6 +132,7 @@ void Server::run()
 		{
 			m_running = false;
 			m_iris->kill();
+			m_game->kill();
 		}
 	}
 
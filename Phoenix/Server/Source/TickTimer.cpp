@@ -0,0 +1,95 @@
+// Copyright 2019-20 Genten Studios
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors
+// may be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include <Server/TickTimer.hpp>
+
+#include <Common/Logger.hpp>
+
+#include <algorithm>
+
+using namespace phx::server;
+
+TickTimer::TickTimer(unsigned int rate)
+    : m_rate(std::max(rate, 1u)),
+      m_budget(std::chrono::duration_cast<Duration>(
+          std::chrono::duration<double>(1.0 / m_rate)))
+{
+	m_times.reserve(HISTORY);
+}
+
+bool TickTimer::record(Duration time)
+{
+	const float milliseconds =
+	    std::chrono::duration<float, std::milli>(time).count();
+
+	if (m_times.size() < HISTORY)
+	{
+		m_times.push_back(milliseconds);
+	}
+	else
+	{
+		m_times[m_next] = milliseconds;
+	}
+	m_next = (m_next + 1) % HISTORY;
+	++m_ticks;
+
+	const bool overran = time > m_budget;
+	if (overran)
+	{
+		++m_overruns;
+
+		// only the first of a run of slow ticks is logged.
+		if (!m_overran)
+		{
+			LOG_WARNING("GAME")
+			    << "A tick took " << milliseconds << "ms, longer than the "
+			    << std::chrono::duration<float, std::milli>(m_budget).count()
+			    << "ms it has.";
+		}
+	}
+	m_overran = overran;
+
+	return overran;
+}
+
+void TickTimer::skip(std::size_t ticks) { m_skipped += ticks; }
+
+float TickTimer::getPercentile(float percentile) const
+{
+	if (m_times.empty())
+	{
+		return 0.f;
+	}
+
+	std::vector<float> times = m_times;
+
+	const auto index = static_cast<std::size_t>(
+	    std::clamp(percentile, 0.f, 1.f) * (times.size() - 1) + 0.5f);
+	std::nth_element(times.begin(), times.begin() + index, times.end());
+	return times[index];
+}
@@ -2,6 +2,7 @@
 
 in vec3 pass_UV;
 in vec3 pass_Normal;
+in vec4 pass_UVRect;
 
 uniform sampler2DArray u_TexArray;
 uniform float u_AmbientStrength;
@@ -27,8 +28,14 @@ void main()
 	float diff = max(dot(norm, lightDir), 0.0);
 	vec3 diffuse = diff * lightColor;
 
+	// -- texture --
+
+	// merged faces have UVs past 1, wrap them back into the texture's
+	// rectangle on the layer so it repeats across the face.
+	vec2 uv = pass_UVRect.xy + fract(pass_UV.xy) * pass_UVRect.zw;
+
 	// -- output color --
 
 	vec4 lightingResult = (vec4(ambient, 1.0) + vec4(diffuse, 1.0)) * u_Brightness;
-	out_FragColor = lightingResult * texture(u_TexArray, pass_UV);
+	out_FragColor = lightingResult * texture(u_TexArray, vec3(uv, pass_UV.z));
 }
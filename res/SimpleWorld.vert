@@ -1,20 +1,40 @@
 #version 330 core
 
-layout (location = 0) in vec3 a_Vertex;
-layout (location = 1) in vec3 a_UV;
-layout (location = 2) in vec3 a_Normal;
+// a packed phx::gfx::Vertex, see ChunkMesher.hpp for the layout.
+layout (location = 0) in uvec4 a_Vertex;
+
+// the position of the chunk being drawn, vertices are relative to it. it's
+// per draw rather than per vertex, see ChunkMeshArena.hpp.
+layout (location = 1) in vec3 a_ChunkPos;
 
 uniform mat4 u_model;
 uniform mat4 u_view;
 uniform mat4 u_projection;
 
+uniform sampler2DArray u_TexArray;
+
 out vec3 pass_UV;
 out vec3 pass_Normal;
+out vec4 pass_UVRect;
 
 void main()
 {
-	gl_Position = u_projection * u_view * u_model * vec4(a_Vertex, 1.f);
+	// quarters of a model unit, offset so they are never negative.
+	vec3 position = vec3(a_Vertex.x & 0xFFu,
+	                     (a_Vertex.x >> 8u) & 0xFFu,
+	                     (a_Vertex.x >> 16u) & 0xFFu) / 4.0 - 2.0;
+
+	uint normal = a_Vertex.x >> 24u;
+
+	gl_Position = u_projection * u_view * u_model * vec4(a_ChunkPos + position, 1.f);
+
+	pass_UV = vec3(float(a_Vertex.y & 0xFFu) / 2.0,
+	               float((a_Vertex.y >> 8u) & 0xFFu) / 2.0,
+	               float(a_Vertex.y >> 16u));
+	pass_Normal = vec3(normal % 3u, (normal / 3u) % 3u, normal / 9u) - 1.0;
 
-	pass_UV = a_UV;
-	pass_Normal = a_Normal;
+	// the texture's rectangle comes in texels.
+	vec2 layerSize = vec2(textureSize(u_TexArray, 0).xy);
+	pass_UVRect = vec4(vec2(a_Vertex.z & 0xFFFFu, a_Vertex.z >> 16u) / layerSize,
+	                   vec2(a_Vertex.w & 0xFFFFu, a_Vertex.w >> 16u) / layerSize);
 }